@@ -0,0 +1,152 @@
+import { Server, Client, PACKET_FLAG_RELIABLE, SEND_MANY } from '../index.js';
+
+// @note microbenchmarks for the js <-> native boundary; the native core is covered by enet_bench
+// @note usage: node bench/addon-bench.mjs [filter], MIN_TIME_MS and RUNS override the defaults
+const MIN_TIME_MS = parseFloat(process.env.MIN_TIME_MS || '200');
+const RUNS = parseInt(process.env.RUNS || '5', 10);
+const PORT = parseInt(process.env.PORT || '17391', 10);
+const filter = process.argv[2] || '';
+
+const now = () => process.hrtime.bigint();
+
+// @note fn(iterations) returns elapsed nanoseconds of the timed part as a bigint
+function report(name, fn, bytesPerOp = 0) {
+  if (filter && !name.includes(filter)) return;
+
+  // @note grow the iteration count until one run is long enough to time
+  let iterations = 1;
+  for (;;) {
+    const elapsed = Number(fn(iterations));
+    if (elapsed >= MIN_TIME_MS * 1e6 || iterations >= 1 << 26) break;
+    iterations = elapsed < 1000
+      ? iterations * 16
+      : Math.ceil(iterations * Math.min(16, (MIN_TIME_MS * 1e6 * 1.1) / elapsed));
+  }
+
+  const samples = [];
+  for (let run = 0; run < RUNS; run += 1) {
+    samples.push(Number(fn(iterations)) / iterations);
+  }
+  samples.sort((a, b) => a - b);
+  const median = samples[Math.floor(RUNS / 2)];
+  const rate = bytesPerOp > 0 ? `${((bytesPerOp * 1e3) / median).toFixed(1)} MB/s` : '';
+  console.log(
+    `${name.padEnd(40)} ${median.toFixed(1).padStart(12)} ns/op ${rate.padStart(14)}  (${iterations} iterations)`,
+  );
+}
+
+const server = new Server({ port: PORT, maxPeer: 64, eventDriven: false });
+await server.createServer();
+const client = new Client({ port: PORT, eventDriven: false });
+
+// @note connect by servicing both hosts by hand so no timer loop competes with the benchmarks
+const serverPeers = [];
+server.on('connect', evt => serverPeers.push(evt.peer));
+server.on('receive', () => {});
+const clientPeer = client.native.connect('127.0.0.1', PORT, 2, 0);
+client.serverPeer = clientPeer;
+
+function pump(rounds = 1) {
+  for (let i = 0; i < rounds; i += 1) {
+    server.serviceBatch(256, 0);
+    client.serviceBatch(256, 0);
+  }
+}
+
+const deadline = Date.now() + 2000;
+while (serverPeers.length === 0 || !client.peers.get(clientPeer)?.connected) {
+  if (Date.now() > deadline) {
+    console.error('loopback connect failed');
+    process.exit(1);
+  }
+  pump();
+}
+
+const small = Buffer.alloc(64, 0x61);
+const large = Buffer.alloc(1200, 0x62);
+
+// @note sends are timed and the queue is flushed and drained outside the timed region
+function timedSends(send) {
+  return iterations => {
+    let elapsed = 0n;
+    for (let done = 0; done < iterations; ) {
+      const batch = Math.min(64, iterations - done);
+      const start = now();
+      for (let i = 0; i < batch; i += 1) send();
+      elapsed += now() - start;
+      done += batch;
+      client.flush();
+      pump();
+    }
+    return elapsed;
+  };
+}
+
+report('native.sendRawPacket/64B', timedSends(() => client.native.sendRawPacket(clientPeer, 0, small, 0)), 64);
+report('native.sendRawPacket/1200B', timedSends(() => client.native.sendRawPacket(clientPeer, 0, large, 0)), 1200);
+report('native.sendPacket/64B', timedSends(() => client.native.sendPacket(clientPeer, 0, small, 0)), 64);
+report('client.send/64B-unreliable', timedSends(() => client.send(0, small, false)), 64);
+report('client.sendRawPacket/64B-reliable', timedSends(() => client.sendRawPacket(0, small, PACKET_FLAG_RELIABLE)), 64);
+
+// @note 64 small messages per crossing, reported per message
+const batchPayload = Buffer.alloc(64 * 64, 0x63);
+const descriptors = new Uint32Array(64 * SEND_MANY.RECORD_STRIDE);
+const results = new Int32Array(64);
+for (let i = 0; i < 64; i += 1) {
+  const record = i * SEND_MANY.RECORD_STRIDE;
+  descriptors[record + SEND_MANY.PEER] = clientPeer;
+  descriptors[record + SEND_MANY.CHANNEL] = 0;
+  descriptors[record + SEND_MANY.FLAGS] = 0;
+  descriptors[record + SEND_MANY.OFFSET] = i * 64;
+  descriptors[record + SEND_MANY.LENGTH] = 64;
+}
+report('native.sendMany/64B-per-message', iterations => {
+  let elapsed = 0n;
+  for (let done = 0; done < iterations; done += 64) {
+    const start = now();
+    client.native.sendMany(descriptors, batchPayload, results);
+    elapsed += now() - start;
+    client.flush();
+    pump();
+  }
+  return (elapsed * BigInt(iterations)) / BigInt(Math.ceil(iterations / 64) * 64);
+}, 64);
+
+report('native.hostService/idle', iterations => {
+  const start = now();
+  for (let i = 0; i < iterations; i += 1) server.native.hostService(0);
+  const elapsed = now() - start;
+  pump();
+  return elapsed;
+});
+
+report('native.hostServiceBatch/idle', iterations => {
+  const start = now();
+  for (let i = 0; i < iterations; i += 1) server.native.hostServiceBatch(256, 0);
+  const elapsed = now() - start;
+  pump();
+  return elapsed;
+});
+
+// @note per event cost of draining received packets into js objects
+report('native.hostServiceBatch/per-event', iterations => {
+  let elapsed = 0n;
+  let drained = 0;
+  while (drained < iterations) {
+    for (let i = 0; i < 128; i += 1) client.native.sendRawPacket(clientPeer, 1, small, 0);
+    client.flush();
+    const start = now();
+    for (let spins = 0; spins < 64; spins += 1) {
+      const events = server.native.hostServiceBatch(256, 0);
+      drained += events.length;
+      if (events.length === 0 && spins > 8) break;
+    }
+    elapsed += now() - start;
+    client.serviceBatch(256, 0);
+  }
+  return (elapsed * BigInt(iterations)) / BigInt(drained);
+}, 64);
+
+try { client.native.disconnectNow(clientPeer, 0); } catch {}
+client.destroy();
+server.destroy();
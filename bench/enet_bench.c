@@ -0,0 +1,506 @@
+/**
+ @file enet_bench.c
+ @brief Microbenchmarks for the ENet core
+
+ Builds against the in-tree enet library:
+
+   cmake -S bench -B build-bench -DCMAKE_BUILD_TYPE=Release
+   cmake --build build-bench
+   ./build-bench/enet_bench [filter] [--min-time ms] [--runs n]
+
+ Every benchmark is calibrated to run for at least --min-time per run and
+ reports the median of --runs runs, so numbers are comparable between builds
+ on the same machine.  Inputs are generated from a fixed seed.
+*/
+#include <enet/enet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_PORT_BASE 29170
+#define BENCH_SLOTS ENET_PROTOCOL_MAXIMUM_PEER_ID
+#define BENCH_CLIENTS 16
+#define BENCH_MAX_RUNS 31
+
+typedef struct {
+  ENetHost *server;
+  ENetHost *clients[BENCH_CLIENTS];
+  ENetPeer *clientPeers[BENCH_CLIENTS]; /**< client side view of the server */
+  ENetPeer *serverPeers[BENCH_CLIENTS]; /**< server side view of each client */
+  ENetAddress address;
+  enet_uint16 unsequencedGroup;
+} BenchNetwork;
+
+typedef enet_uint64 (*BenchFunction)(void *context, size_t iterations);
+
+typedef struct {
+  const char *name;
+  BenchFunction function;
+  void *context;
+  size_t bytesPerOperation;
+} Bench;
+
+static unsigned benchSeed = 0x2545F491u;
+static double benchMinimumTime = 200e6;
+static int benchRuns = 5;
+static enet_uint64 benchSink;
+
+static unsigned bench_random(void) {
+  benchSeed ^= benchSeed << 13;
+  benchSeed ^= benchSeed >> 17;
+  benchSeed ^= benchSeed << 5;
+  return benchSeed;
+}
+
+/* game-like payload: small field names and numbers that compress a little */
+static void bench_fill_payload(enet_uint8 *data, size_t length) {
+  static const char *const words[] = {"pos", "vel", "hp", "id", "state",
+                                      "yaw", "seq", "tick"};
+  size_t offset = 0;
+
+  while (offset < length) {
+    char field[32];
+    int written = snprintf(field, sizeof(field), "%s:%u,",
+                           words[bench_random() % 8], bench_random() % 1000);
+    size_t n = (size_t)written;
+
+    if (n > length - offset)
+      n = length - offset;
+    memcpy(&data[offset], field, n);
+    offset += n;
+  }
+}
+
+static int bench_compare(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+static void bench_report(const Bench *bench) {
+  double samples[BENCH_MAX_RUNS], median;
+  size_t iterations = 1;
+  int run;
+
+  /* grow the iteration count until one run takes long enough to time */
+  for (;;) {
+    enet_uint64 elapsed = bench->function(bench->context, iterations);
+
+    if ((double)elapsed >= benchMinimumTime || iterations >= ((size_t)1 << 30))
+      break;
+    if (elapsed < 1000)
+      iterations *= 16;
+    else {
+      double scale = benchMinimumTime * 1.1 / (double)elapsed;
+      iterations = (size_t)((double)iterations * (scale > 16.0 ? 16.0 : scale)) + 1;
+    }
+  }
+
+  for (run = 0; run < benchRuns; ++run)
+    samples[run] =
+        (double)bench->function(bench->context, iterations) / (double)iterations;
+
+  qsort(samples, (size_t)benchRuns, sizeof(double), bench_compare);
+  median = samples[benchRuns / 2];
+
+  if (bench->bytesPerOperation > 0)
+    printf("%-44s %12.1f ns/op %10.1f MB/s  (%zu iterations)\n", bench->name,
+           median, (double)bench->bytesPerOperation * 1e3 / median, iterations);
+  else
+    printf("%-44s %12.1f ns/op %15s  (%zu iterations)\n", bench->name, median,
+           "", iterations);
+  fflush(stdout);
+}
+
+/* checksums */
+
+typedef struct {
+  enet_uint8 data[ENET_PROTOCOL_MAXIMUM_MTU];
+  ENetBuffer buffer;
+} BenchChecksum;
+
+static enet_uint64 bench_crc32(void *context, size_t iterations) {
+  BenchChecksum *checksum = (BenchChecksum *)context;
+  enet_uint64 start = enet_time_get_ns();
+  enet_uint32 total = 0;
+  size_t i;
+
+  for (i = 0; i < iterations; ++i)
+    total += enet_crc32(&checksum->buffer, 1);
+
+  benchSink += total;
+  return enet_time_get_ns() - start;
+}
+
+/* compressors */
+
+typedef struct {
+  void *context;
+  size_t(ENET_CALLBACK *compress)(void *, const ENetBuffer *, size_t, size_t,
+                                  enet_uint8 *, size_t);
+  size_t(ENET_CALLBACK *decompress)(void *, const enet_uint8 *, size_t,
+                                    enet_uint8 *, size_t);
+  enet_uint8 input[1200];
+  enet_uint8 compressed[ENET_PROTOCOL_MAXIMUM_MTU];
+  enet_uint8 output[ENET_PROTOCOL_MAXIMUM_MTU];
+  size_t compressedLength;
+} BenchCompressor;
+
+static enet_uint64 bench_compress(void *context, size_t iterations) {
+  BenchCompressor *compressor = (BenchCompressor *)context;
+  ENetBuffer buffer;
+  enet_uint64 start;
+  size_t i, total = 0;
+
+  buffer.data = compressor->input;
+  buffer.dataLength = sizeof(compressor->input);
+
+  start = enet_time_get_ns();
+  for (i = 0; i < iterations; ++i)
+    total += compressor->compress(compressor->context, &buffer, 1,
+                                  sizeof(compressor->input),
+                                  compressor->compressed,
+                                  sizeof(compressor->compressed));
+  benchSink += total;
+  return enet_time_get_ns() - start;
+}
+
+static enet_uint64 bench_decompress(void *context, size_t iterations) {
+  BenchCompressor *compressor = (BenchCompressor *)context;
+  enet_uint64 start = enet_time_get_ns();
+  size_t i, total = 0;
+
+  for (i = 0; i < iterations; ++i)
+    total += compressor->decompress(
+        compressor->context, compressor->compressed,
+        compressor->compressedLength, compressor->output,
+        sizeof(compressor->output));
+  benchSink += total;
+  return enet_time_get_ns() - start;
+}
+
+static void bench_setup_compressor(BenchCompressor *compressor) {
+  ENetBuffer buffer;
+
+  bench_fill_payload(compressor->input, sizeof(compressor->input));
+  buffer.data = compressor->input;
+  buffer.dataLength = sizeof(compressor->input);
+  compressor->compressedLength = compressor->compress(
+      compressor->context, &buffer, 1, sizeof(compressor->input),
+      compressor->compressed, sizeof(compressor->compressed));
+}
+
+/* loopback network shared by the peer and host benchmarks */
+
+static void bench_pump(BenchNetwork *network, int rounds) {
+  ENetEvent event;
+  int round, c;
+
+  for (round = 0; round < rounds; ++round) {
+    while (enet_host_service(network->server, &event, 0) > 0) {
+      if (event.type == ENET_EVENT_TYPE_CONNECT)
+        network->serverPeers[event.data] = event.peer;
+      else if (event.type == ENET_EVENT_TYPE_RECEIVE)
+        enet_packet_destroy(event.packet);
+    }
+    for (c = 0; c < BENCH_CLIENTS; ++c)
+      while (enet_host_service(network->clients[c], &event, 0) > 0)
+        if (event.type == ENET_EVENT_TYPE_RECEIVE)
+          enet_packet_destroy(event.packet);
+  }
+}
+
+static int bench_connect(BenchNetwork *network) {
+  int attempt, c, connected = 0;
+
+  memset(network, 0, sizeof(*network));
+  enet_address_set_host_ip(&network->address, "127.0.0.1");
+  network->address.type = ENET_ADDRESS_TYPE_IPV4;
+
+  for (attempt = 0; attempt < 32 && network->server == NULL; ++attempt) {
+    network->address.port = (enet_uint16)(BENCH_PORT_BASE + attempt);
+    network->server = enet_host_create(ENET_ADDRESS_TYPE_IPV4,
+                                       &network->address, BENCH_SLOTS, 2, 0, 0);
+  }
+  if (network->server == NULL)
+    return -1;
+
+  for (c = 0; c < BENCH_CLIENTS; ++c) {
+    network->clients[c] =
+        enet_host_create(ENET_ADDRESS_TYPE_IPV4, NULL, 1, 2, 0, 0);
+    if (network->clients[c] == NULL)
+      return -1;
+    network->clientPeers[c] = enet_host_connect(
+        network->clients[c], &network->address, 2, (enet_uint32)c);
+  }
+
+  for (attempt = 0; attempt < 5000 && connected < BENCH_CLIENTS; ++attempt) {
+    bench_pump(network, 1);
+    for (connected = 0, c = 0; c < BENCH_CLIENTS; ++c)
+      connected += network->serverPeers[c] != NULL &&
+                   network->clientPeers[c]->state == ENET_PEER_STATE_CONNECTED;
+  }
+
+  return connected == BENCH_CLIENTS ? 0 : -1;
+}
+
+static void bench_disconnect(BenchNetwork *network) {
+  int c;
+
+  for (c = 0; c < BENCH_CLIENTS; ++c)
+    if (network->clients[c] != NULL)
+      enet_host_destroy(network->clients[c]);
+  if (network->server != NULL)
+    enet_host_destroy(network->server);
+}
+
+/* enet_peer_send of a packet that splits into many fragments; the queue is
+   flushed to the socket outside the timed region */
+typedef struct {
+  BenchNetwork *network;
+  size_t length;
+  enet_uint8 *data;
+} BenchFragment;
+
+static enet_uint64 bench_peer_send_fragments(void *context, size_t iterations) {
+  BenchFragment *fragment = (BenchFragment *)context;
+  ENetPeer *peer = fragment->network->clientPeers[0];
+  enet_uint64 elapsed = 0;
+  size_t i;
+
+  for (i = 0; i < iterations; ++i) {
+    enet_uint64 start = enet_time_get_ns();
+    ENetPacket *packet = enet_packet_create(
+        fragment->data, fragment->length, ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT);
+
+    if (enet_peer_send(peer, 1, packet) < 0)
+      enet_packet_destroy(packet);
+    elapsed += enet_time_get_ns() - start;
+
+    if ((i & 15) == 15)
+      enet_host_flush(fragment->network->clients[0]);
+  }
+
+  enet_host_flush(fragment->network->clients[0]);
+  bench_pump(fragment->network, 1);
+  return elapsed;
+}
+
+/* enet_host_inject of synthetic unsequenced datagrams from a connected peer,
+   which runs enet_protocol_handle_incoming_commands on each */
+typedef struct {
+  BenchNetwork *network;
+  int commands;
+  size_t payload;
+} BenchIncoming;
+
+static size_t bench_build_datagram(BenchNetwork *network, ENetPeer *peer,
+                                   int commands, size_t payload,
+                                   enet_uint8 *datagram) {
+  enet_uint16 peerID =
+      (enet_uint16)(peer->incomingPeerID |
+                    (peer->incomingSessionID << ENET_PROTOCOL_HEADER_SESSION_SHIFT));
+  size_t length = (size_t) & ((ENetProtocolHeader *)0)->sentTime;
+  int i;
+
+  peerID = ENET_HOST_TO_NET_16(peerID);
+  memcpy(datagram, &peerID, sizeof(peerID));
+
+  for (i = 0; i < commands; ++i) {
+    ENetProtocolSendUnsequenced command;
+
+    command.header.command = ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED |
+                             ENET_PROTOCOL_COMMAND_FLAG_UNSEQUENCED;
+    command.header.channelID = 1;
+    command.header.reliableSequenceNumber = 0;
+    command.unsequencedGroup = ENET_HOST_TO_NET_16(++network->unsequencedGroup);
+    command.dataLength = ENET_HOST_TO_NET_16((enet_uint16)payload);
+    memcpy(&datagram[length], &command, sizeof(command));
+    length += sizeof(command);
+    memset(&datagram[length], 0x42, payload);
+    length += payload;
+  }
+
+  return length;
+}
+
+static enet_uint64 bench_handle_incoming(void *context, size_t iterations) {
+  BenchIncoming *incoming = (BenchIncoming *)context;
+  BenchNetwork *network = incoming->network;
+  ENetPeer *peer = network->serverPeers[0];
+  enet_uint8 datagram[ENET_PROTOCOL_MAXIMUM_MTU];
+  enet_uint64 elapsed = 0;
+  ENetEvent event;
+  size_t i;
+
+  for (i = 0; i < iterations; ++i) {
+    size_t length = bench_build_datagram(network, peer, incoming->commands,
+                                         incoming->payload, datagram);
+    enet_uint64 start = enet_time_get_ns();
+
+    enet_host_inject(network->server, &peer->address, datagram, length, NULL);
+    elapsed += enet_time_get_ns() - start;
+
+    if ((i & 63) == 63)
+      while (enet_host_check_events(network->server, &event) > 0)
+        if (event.type == ENET_EVENT_TYPE_RECEIVE)
+          enet_packet_destroy(event.packet);
+  }
+
+  while (enet_host_check_events(network->server, &event) > 0)
+    if (event.type == ENET_EVENT_TYPE_RECEIVE)
+      enet_packet_destroy(event.packet);
+  return elapsed;
+}
+
+/* per-service work that scales with peer slots rather than active peers */
+static enet_uint64 bench_host_service_idle(void *context, size_t iterations) {
+  BenchNetwork *network = (BenchNetwork *)context;
+  enet_uint64 start = enet_time_get_ns();
+  size_t i;
+
+  for (i = 0; i < iterations; ++i)
+    enet_host_service(network->server, NULL, 0);
+
+  start = enet_time_get_ns() - start;
+  bench_pump(network, 1);
+  return start;
+}
+
+static enet_uint64 bench_host_broadcast(void *context, size_t iterations) {
+  BenchNetwork *network = (BenchNetwork *)context;
+  enet_uint8 data[64];
+  enet_uint64 elapsed = 0;
+  size_t i;
+
+  memset(data, 0x17, sizeof(data));
+  for (i = 0; i < iterations; ++i) {
+    enet_uint64 start = enet_time_get_ns();
+
+    enet_host_broadcast(network->server, 1,
+                        enet_packet_create(data, sizeof(data), 0));
+    elapsed += enet_time_get_ns() - start;
+
+    if ((i & 63) == 63)
+      enet_host_flush(network->server);
+  }
+
+  enet_host_flush(network->server);
+  bench_pump(network, 1);
+  return elapsed;
+}
+
+static enet_uint64 bench_host_throttle(void *context, size_t iterations) {
+  BenchNetwork *network = (BenchNetwork *)context;
+  enet_uint64 start;
+  size_t i;
+
+  network->server->outgoingBandwidth = 1000000;
+  start = enet_time_get_ns();
+  for (i = 0; i < iterations; ++i) {
+    network->server->bandwidthThrottleEpoch = 0;
+    network->server->recalculateBandwidthLimits = 1;
+    enet_host_bandwidth_throttle(network->server);
+  }
+  start = enet_time_get_ns() - start;
+  network->server->outgoingBandwidth = 0;
+  network->server->recalculateBandwidthLimits = 1;
+  bench_pump(network, 1);
+  return start;
+}
+
+int main(int argc, char **argv) {
+  static BenchChecksum checksumSmall, checksumMtu;
+  static BenchCompressor rangeCoder, lz4;
+  static BenchNetwork network;
+  static enet_uint8 fragmentData[64 * 1024];
+  BenchFragment fragment;
+  BenchIncoming incomingSingle, incomingBatch;
+  const char *filter = NULL;
+  size_t b;
+  int i;
+
+  for (i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--min-time") && i + 1 < argc)
+      benchMinimumTime = atof(argv[++i]) * 1e6;
+    else if (!strcmp(argv[i], "--runs") && i + 1 < argc) {
+      benchRuns = atoi(argv[++i]);
+      if (benchRuns < 1)
+        benchRuns = 1;
+      if (benchRuns > BENCH_MAX_RUNS)
+        benchRuns = BENCH_MAX_RUNS;
+    } else
+      filter = argv[i];
+  }
+
+  if (enet_initialize() != 0) {
+    fprintf(stderr, "enet_initialize failed\n");
+    return 1;
+  }
+
+  bench_fill_payload(checksumSmall.data, sizeof(checksumSmall.data));
+  checksumSmall.buffer.data = checksumSmall.data;
+  checksumSmall.buffer.dataLength = 64;
+  memcpy(checksumMtu.data, checksumSmall.data, sizeof(checksumMtu.data));
+  checksumMtu.buffer.data = checksumMtu.data;
+  checksumMtu.buffer.dataLength = ENET_HOST_DEFAULT_MTU;
+
+  rangeCoder.context = enet_range_coder_create();
+  rangeCoder.compress = enet_range_coder_compress;
+  rangeCoder.decompress = enet_range_coder_decompress;
+  bench_setup_compressor(&rangeCoder);
+  lz4.context = enet_lz4_create(NULL, 0);
+  lz4.compress = enet_lz4_compress;
+  lz4.decompress = enet_lz4_decompress;
+  bench_setup_compressor(&lz4);
+
+  if (bench_connect(&network) < 0) {
+    fprintf(stderr, "loopback connect failed\n");
+    return 1;
+  }
+
+  bench_fill_payload(fragmentData, sizeof(fragmentData));
+  fragment.network = &network;
+  fragment.data = fragmentData;
+  fragment.length = sizeof(fragmentData);
+
+  incomingSingle.network = &network;
+  incomingSingle.commands = 1;
+  incomingSingle.payload = 100;
+  incomingBatch.network = &network;
+  incomingBatch.commands = 8;
+  incomingBatch.payload = 100;
+
+  {
+    Bench benches[] = {
+        {"crc32/64B", bench_crc32, &checksumSmall, 64},
+        {"crc32/1392B", bench_crc32, &checksumMtu, ENET_HOST_DEFAULT_MTU},
+        {"range_coder_compress/1200B", bench_compress, &rangeCoder, 1200},
+        {"range_coder_decompress/1200B", bench_decompress, &rangeCoder, 1200},
+        {"lz4_compress/1200B", bench_compress, &lz4, 1200},
+        {"lz4_decompress/1200B", bench_decompress, &lz4, 1200},
+        {"peer_send/64KiB-unreliable-fragments", bench_peer_send_fragments,
+         &fragment, sizeof(fragmentData)},
+        {"handle_incoming/1x100B-unsequenced", bench_handle_incoming,
+         &incomingSingle, 100},
+        {"handle_incoming/8x100B-unsequenced", bench_handle_incoming,
+         &incomingBatch, 800},
+        {"host_service/idle-4095-slots-16-peers", bench_host_service_idle,
+         &network, 0},
+        {"host_broadcast/64B-4095-slots-16-peers", bench_host_broadcast,
+         &network, 0},
+        {"host_bandwidth_throttle/4095-slots-16-peers", bench_host_throttle,
+         &network, 0},
+    };
+
+    for (b = 0; b < sizeof(benches) / sizeof(benches[0]); ++b)
+      if (filter == NULL || strstr(benches[b].name, filter) != NULL)
+        bench_report(&benches[b]);
+  }
+
+  bench_disconnect(&network);
+  enet_range_coder_destroy(rangeCoder.context);
+  enet_lz4_destroy(lz4.context);
+  enet_deinitialize();
+
+  return benchSink == 0xFFFFFFFFFFFFFFFFULL;
+}
@@ -1,4 +1,7 @@
 {
+  "variables": {
+    "enet_instrument%": "false"
+  },
   "targets": [
     {
       "target_name": "node",
@@ -6,14 +9,21 @@
       "cflags_cc!": [ "-fno-exceptions" ],
       "sources": [
         "src/enet_addon.cpp",
+        "src/slab_allocator.cpp",
+        "src/traffic_capture.cpp",
         "enet/address.c",
         "enet/callbacks.c",
         "enet/compress.c",
         "enet/host.c",
+        "enet/instrument.c",
         "enet/list.c",
+        "enet/lz4.c",
         "enet/packet.c",
         "enet/peer.c",
+        "enet/pool.c",
         "enet/protocol.c",
+        "enet/sequence.c",
+        "enet/timer.c",
         "enet/unix.c"
       ],
       "include_dirs": [
@@ -29,6 +39,9 @@
         "NAPI_VERSION=6"
       ],
       "conditions": [
+        ["enet_instrument=='true'", {
+          "defines": ["ENET_INSTRUMENT"]
+        }],
         ["OS=='win'", {
           "sources": ["enet/win32.c"],
           "libraries": ["winmm.lib", "ws2_32.lib"]
@@ -0,0 +1,111 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2025 Yoru Akio
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+// @note type declarations for the worker_threads cluster in cluster.js
+
+import { Server, ServerOptions, PeerId, ConnectEvent, DisconnectEvent, ReceiveEvent, ReceiveChunkEvent } from './index';
+
+export interface ShardMessageEvent {
+  type?: 'message';
+  // @note sending shard, -1 for the main thread
+  from: number;
+  data: any;
+  shard?: number;
+}
+
+export interface ShardInfo {
+  shard: number;
+  shardCount: number;
+}
+
+export interface ServerClusterOptions extends ServerOptions {
+  // @note worker count, defaults to available parallelism (max 256)
+  shards?: number;
+  // @note module run in every shard as `module.exports(server, info)` before it binds
+  worker?: string;
+  // @note relay connect/disconnect/receive/receiveChunk to the main thread (default: true without a worker module)
+  relayEvents?: boolean;
+}
+
+// @note events relayed from a shard carry its index
+export type ShardEvent<T> = T & { shard: number };
+
+/**
+ * A reusePort server in one worker; peer ids are cluster-wide and sends to
+ * peers of other shards are forwarded to them
+ */
+export class ShardServer extends Server {
+  readonly shard: number;
+  readonly shardCount: number;
+
+  on(event: 'message', handler: (event: ShardMessageEvent) => void): this;
+  on(event: 'connect', handler: (event: ConnectEvent) => void): this;
+  on(event: 'disconnect', handler: (event: DisconnectEvent) => void): this;
+  on(event: 'receive', handler: (event: ReceiveEvent) => void): this;
+  on(event: 'receiveChunk', handler: (event: ReceiveChunkEvent) => void): this;
+  on(event: 'error', handler: (error: Error) => void): this;
+  on(event: 'ready', handler: () => void): this;
+
+  broadcastLocal(channelId: number, data: Buffer | string, reliable?: boolean): void;
+  postToShard(shard: number, data: any): void;
+  publish(data: any): void;
+}
+
+/**
+ * Runs one ShardServer per worker thread, all bound to the same port
+ */
+export class ServerCluster {
+  constructor(options?: ServerClusterOptions);
+
+  readonly shardCount: number;
+
+  on(event: 'connect', handler: (event: ShardEvent<ConnectEvent>) => void): this;
+  on(event: 'disconnect', handler: (event: ShardEvent<DisconnectEvent>) => void): this;
+  on(event: 'receive', handler: (event: ShardEvent<ReceiveEvent>) => void): this;
+  on(event: 'receiveChunk', handler: (event: ShardEvent<ReceiveChunkEvent>) => void): this;
+  on(event: 'message', handler: (event: ShardMessageEvent) => void): this;
+  on(event: 'error', handler: (error: Error & { shard?: number }) => void): this;
+  on(event: 'ready', handler: () => void): this;
+  off(event: string, handler: (...args: any[]) => void): this;
+
+  start(): Promise<void>;
+  stop(): Promise<void>;
+
+  // @note requests are posted to the owning shard; return false before start()
+  send(peerId: PeerId, channelId: number, data: Buffer | string, reliable?: boolean): boolean;
+  sendRawPacket(peerId: PeerId, channelId: number, data: Buffer | Uint8Array, flags?: number): boolean;
+  sendToMany(peerIds: PeerId[], channelId: number, data: Buffer | string, reliable?: boolean): void;
+  broadcast(channelId: number, data: Buffer | string, reliable?: boolean): boolean;
+  disconnect(peerId: PeerId, data?: number): boolean;
+  disconnectNow(peerId: PeerId, data?: number): boolean;
+  disconnectLater(peerId: PeerId, data?: number): boolean;
+  postToShard(shard: number, data: any): boolean;
+  publish(data: any): boolean;
+}
+
+// @note cluster peer ids are Numbers: the shard-local handle * MAX_SHARDS + shard
+export function toClusterPeerId(shard: number, peerId: PeerId): PeerId;
+export function fromClusterPeerId(peerId: PeerId): { shard: number; peer: PeerId };
+export const MAX_SHARDS: number;
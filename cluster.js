@@ -0,0 +1,495 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Yoru Akio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+const os = require('os');
+const path = require('path');
+const {
+  Worker,
+  isMainThread,
+  parentPort,
+  workerData,
+  BroadcastChannel,
+} = require('worker_threads');
+const { Server } = require('./index');
+
+// @note low bits of a cluster peer id carry the shard, the rest is the shard-local id;
+// @note a 30-bit local handle and 8 shard bits stay well inside the safe integer range
+const SHARD_BITS = 8;
+const MAX_SHARDS = 2 ** SHARD_BITS;
+
+// @note marks workers started by ServerCluster so user workers loading this file are left alone
+const SHARD_MARKER = '__skyEnetShard';
+
+let nextClusterId = 0;
+
+function toClusterPeerId(shard, peerId) {
+  return Number(peerId) * MAX_SHARDS + shard;
+}
+
+function fromClusterPeerId(peerId) {
+  const id = Number(peerId);
+  const shard = id % MAX_SHARDS;
+  return { shard, peer: (id - shard) / MAX_SHARDS };
+}
+
+function shardOf(peerId) {
+  return Number(peerId) % MAX_SHARDS;
+}
+
+// @note structured clone turns Buffers into plain Uint8Arrays; view them as Buffers again
+function toBuffer(data) {
+  if (typeof data === 'string' || Buffer.isBuffer(data)) {
+    return data;
+  }
+  if (ArrayBuffer.isView(data)) {
+    return Buffer.from(data.buffer, data.byteOffset, data.byteLength);
+  }
+  return Buffer.from(data);
+}
+
+/**
+ * one shard of a cluster: a reusePort server on the shared port whose peer ids
+ * are namespaced by shard, with sends to other shards' peers forwarded over a
+ * BroadcastChannel
+ */
+class ShardServer extends Server {
+  constructor(options, shard, shardCount, channelName) {
+    super({ ...options, reusePort: true });
+
+    // @note user messages posted with postToShard/publish
+    this.eventCallbacks.message = [];
+
+    this.shard = shard;
+    this.shardCount = shardCount;
+    this.channel = new BroadcastChannel(channelName);
+    this.channel.onmessage = ({ data }) => this.handleClusterMessage(data);
+  }
+
+  handleEvent(event) {
+    // @note expose cluster-wide ids; the native layer only ever sees local ones
+    if (event && event.peer !== undefined) {
+      event.peer = toClusterPeerId(this.shard, event.peer);
+    }
+    return super.handleEvent(event);
+  }
+
+  handleClusterMessage(msg) {
+    if (!msg || (msg.shard !== this.shard && msg.shard !== -1)) {
+      return;
+    }
+    try {
+      switch (msg.op) {
+        case 'send':
+          this.send(msg.peer, msg.channelId, toBuffer(msg.data), msg.reliable);
+          break;
+        case 'sendRaw':
+          this.sendRawPacket(msg.peer, msg.channelId, toBuffer(msg.data), msg.flags);
+          break;
+        case 'sendToMany':
+          this.sendToMany(msg.peers, msg.channelId, toBuffer(msg.data), msg.reliable);
+          break;
+        case 'broadcast':
+          this.broadcastLocal(msg.channelId, toBuffer(msg.data), msg.reliable);
+          break;
+        case 'disconnect':
+        case 'disconnectNow':
+        case 'disconnectLater':
+          this[msg.op](msg.peer, msg.data);
+          break;
+        case 'message':
+          this.emit('message', { from: msg.from, data: msg.data });
+          break;
+        default:
+          break;
+      }
+    } catch (err) {
+      this.emit('error', err);
+    }
+  }
+
+  // @note true when the id belongs to this shard; otherwise the request is forwarded
+  routeLocal(peerId, msg) {
+    const shard = shardOf(peerId);
+    if (shard === this.shard) {
+      return true;
+    }
+    this.channel.postMessage({ ...msg, shard, peer: peerId });
+    return false;
+  }
+
+  send(peerId, channelId, data, reliable = true) {
+    if (!this.routeLocal(peerId, { op: 'send', channelId, data, reliable })) {
+      return 0;
+    }
+    return super.send(fromClusterPeerId(peerId).peer, channelId, data, reliable);
+  }
+
+  sendRawPacket(peerId, channelId, data, flags) {
+    if (!this.routeLocal(peerId, { op: 'sendRaw', channelId, data, flags })) {
+      return 0;
+    }
+    return super.sendRawPacket(fromClusterPeerId(peerId).peer, channelId, data, flags);
+  }
+
+  sendZeroCopy(peerId, channelId, data, flags) {
+    // @note pinned memory cannot cross threads; remote peers get a copy
+    if (!this.routeLocal(peerId, { op: 'sendRaw', channelId, data, flags })) {
+      return 0;
+    }
+    return super.sendZeroCopy(fromClusterPeerId(peerId).peer, channelId, data, flags);
+  }
+
+  sendToMany(peerIds, channelId, data, reliable = true) {
+    const local = [];
+    const remote = new Map();
+    for (const peerId of peerIds) {
+      const shard = shardOf(peerId);
+      if (shard === this.shard) {
+        local.push(fromClusterPeerId(peerId).peer);
+      } else {
+        if (!remote.has(shard)) remote.set(shard, []);
+        remote.get(shard).push(peerId);
+      }
+    }
+    for (const [shard, peers] of remote) {
+      this.channel.postMessage({ op: 'sendToMany', shard, peers, channelId, data, reliable });
+    }
+    return local.length > 0 ? super.sendToMany(local, channelId, data, reliable) : 0;
+  }
+
+  broadcastLocal(channelId, data, reliable = true) {
+    return super.broadcast(channelId, data, reliable);
+  }
+
+  broadcast(channelId, data, reliable = true) {
+    // @note every shard broadcasts to its own peers
+    this.channel.postMessage({ op: 'broadcast', shard: -1, channelId, data, reliable });
+    return this.broadcastLocal(channelId, data, reliable);
+  }
+
+  disconnect(peerId, data = 0) {
+    if (this.routeLocal(peerId, { op: 'disconnect', data })) {
+      super.disconnect(fromClusterPeerId(peerId).peer, data);
+      this.peers.delete(peerId);
+    }
+  }
+
+  disconnectNow(peerId, data = 0) {
+    if (this.routeLocal(peerId, { op: 'disconnectNow', data })) {
+      super.disconnectNow(fromClusterPeerId(peerId).peer, data);
+      this.peers.delete(peerId);
+    }
+  }
+
+  disconnectLater(peerId, data = 0) {
+    if (this.routeLocal(peerId, { op: 'disconnectLater', data })) {
+      super.disconnectLater(fromClusterPeerId(peerId).peer, data);
+      this.peers.delete(peerId);
+    }
+  }
+
+  postToShard(shard, data) {
+    // @note delivered as a 'message' event on the target shard
+    this.channel.postMessage({ op: 'message', shard, from: this.shard, data });
+  }
+
+  publish(data) {
+    this.channel.postMessage({ op: 'message', shard: -1, from: this.shard, data });
+  }
+
+  destroy() {
+    super.destroy();
+    this.channel.close();
+  }
+}
+
+/**
+ * runs one reusePort server per worker thread on a shared port so the kernel
+ * spreads clients across cores
+ */
+class ServerCluster {
+  constructor(options = {}) {
+    const parallelism = os.availableParallelism
+      ? os.availableParallelism()
+      : os.cpus().length;
+
+    this.options = { ...options };
+    delete this.options.shards;
+    delete this.options.worker;
+    delete this.options.relayEvents;
+
+    this.shardCount = Math.min(options.shards || parallelism, MAX_SHARDS);
+    // @note module run inside every shard as `module.exports(server, { shard, shardCount })`
+    this.workerPath = options.worker ? path.resolve(options.worker) : null;
+    // @note without a worker module, shard events are relayed here
+    this.relayEvents =
+      options.relayEvents !== undefined ? !!options.relayEvents : !this.workerPath;
+
+    this.channelName = `sky-enet-cluster:${process.pid}:${nextClusterId++}`;
+    this.channel = null;
+    this.workers = [];
+    this.eventCallbacks = {
+      connect: [],
+      disconnect: [],
+      receive: [],
+      message: [],
+      error: [],
+      ready: [],
+    };
+  }
+
+  on(eventType, callback) {
+    if (this.eventCallbacks[eventType]) {
+      this.eventCallbacks[eventType].push(callback);
+    }
+    return this;
+  }
+
+  off(eventType, callback) {
+    const list = this.eventCallbacks[eventType];
+    if (list) {
+      const idx = list.indexOf(callback);
+      if (idx !== -1) list.splice(idx, 1);
+    }
+    return this;
+  }
+
+  emit(eventType, data) {
+    if (this.eventCallbacks[eventType]) {
+      this.eventCallbacks[eventType].forEach(callback => {
+        try {
+          callback(data);
+        } catch (err) {
+          console.error('Error in event callback:', err);
+        }
+      });
+    }
+  }
+
+  async start() {
+    this.channel = new BroadcastChannel(this.channelName);
+
+    const started = [];
+    for (let shard = 0; shard < this.shardCount; shard++) {
+      started.push(this.startShard(shard));
+    }
+
+    try {
+      await Promise.all(started);
+    } catch (err) {
+      await this.stop();
+      throw err;
+    }
+
+    this.emit('ready');
+  }
+
+  startShard(shard) {
+    return new Promise((resolve, reject) => {
+      const worker = new Worker(__filename, {
+        workerData: {
+          [SHARD_MARKER]: true,
+          options: this.options,
+          shard,
+          shardCount: this.shardCount,
+          channelName: this.channelName,
+          workerPath: this.workerPath,
+          relayEvents: this.relayEvents,
+        },
+      });
+      this.workers[shard] = worker;
+
+      let ready = false;
+      worker.on('message', msg => {
+        switch (msg.type) {
+          case 'ready':
+            ready = true;
+            resolve();
+            break;
+          case 'event':
+            this.emit(msg.event.type, msg.event);
+            break;
+          case 'error': {
+            const error = new Error(msg.message);
+            error.stack = msg.stack;
+            error.shard = shard;
+            if (!ready) {
+              reject(error);
+            } else {
+              this.emit('error', error);
+            }
+            break;
+          }
+          default:
+            break;
+        }
+      });
+      worker.on('error', err => {
+        err.shard = shard;
+        if (!ready) {
+          reject(err);
+        } else {
+          this.emit('error', err);
+        }
+      });
+      worker.on('exit', code => {
+        this.workers[shard] = null;
+        if (!ready) {
+          reject(new Error(`Shard ${shard} exited with code ${code} before it was ready`));
+        }
+      });
+    });
+  }
+
+  async stop() {
+    const exits = this.workers.filter(Boolean).map(
+      worker =>
+        new Promise(resolve => {
+          worker.once('exit', resolve);
+          worker.postMessage({ op: 'stop' });
+        }),
+    );
+    await Promise.all(exits);
+    this.workers = [];
+    if (this.channel) {
+      this.channel.close();
+      this.channel = null;
+    }
+  }
+
+  post(msg) {
+    if (!this.channel) {
+      this.emit('error', new Error('Cluster not started'));
+      return false;
+    }
+    this.channel.postMessage(msg);
+    return true;
+  }
+
+  send(peerId, channelId, data, reliable = true) {
+    return this.post({ op: 'send', shard: shardOf(peerId), peer: peerId, channelId, data, reliable });
+  }
+
+  sendRawPacket(peerId, channelId, data, flags = 1) {
+    return this.post({ op: 'sendRaw', shard: shardOf(peerId), peer: peerId, channelId, data, flags });
+  }
+
+  sendToMany(peerIds, channelId, data, reliable = true) {
+    const byShard = new Map();
+    for (const peerId of peerIds) {
+      const shard = shardOf(peerId);
+      if (!byShard.has(shard)) byShard.set(shard, []);
+      byShard.get(shard).push(peerId);
+    }
+    for (const [shard, peers] of byShard) {
+      this.post({ op: 'sendToMany', shard, peers, channelId, data, reliable });
+    }
+  }
+
+  broadcast(channelId, data, reliable = true) {
+    return this.post({ op: 'broadcast', shard: -1, channelId, data, reliable });
+  }
+
+  disconnect(peerId, data = 0) {
+    return this.post({ op: 'disconnect', shard: shardOf(peerId), peer: peerId, data });
+  }
+
+  disconnectNow(peerId, data = 0) {
+    return this.post({ op: 'disconnectNow', shard: shardOf(peerId), peer: peerId, data });
+  }
+
+  disconnectLater(peerId, data = 0) {
+    return this.post({ op: 'disconnectLater', shard: shardOf(peerId), peer: peerId, data });
+  }
+
+  postToShard(shard, data) {
+    return this.post({ op: 'message', shard, from: -1, data });
+  }
+
+  publish(data) {
+    return this.post({ op: 'message', shard: -1, from: -1, data });
+  }
+}
+
+async function runShard() {
+  const { options, shard, shardCount, channelName, workerPath, relayEvents } = workerData;
+  const server = new ShardServer(options, shard, shardCount, channelName);
+
+  const reportError = err => {
+    parentPort.postMessage({
+      type: 'error',
+      message: err && err.message ? err.message : String(err),
+      stack: err && err.stack,
+    });
+  };
+  server.on('error', reportError);
+
+  if (relayEvents) {
+    for (const type of ['connect', 'disconnect', 'receive', 'receiveChunk']) {
+      server.on(type, event => {
+        parentPort.postMessage({ type: 'event', event: { ...event, shard } });
+      });
+    }
+    server.on('message', event => {
+      parentPort.postMessage({ type: 'event', event: { type: 'message', shard, ...event } });
+    });
+  }
+
+  parentPort.on('message', msg => {
+    if (msg && msg.op === 'stop') {
+      server.destroy();
+      parentPort.close();
+    }
+  });
+
+  try {
+    if (workerPath) {
+      const mod = require(workerPath);
+      const setup = typeof mod === 'function' ? mod : mod.default;
+      if (typeof setup === 'function') {
+        await setup(server, { shard, shardCount });
+      }
+    }
+
+    await server.createServer();
+  } catch (err) {
+    reportError(err);
+    process.exit(1);
+  }
+
+  parentPort.postMessage({ type: 'ready' });
+  server.listen().catch(reportError);
+}
+
+if (!isMainThread && workerData && workerData[SHARD_MARKER]) {
+  runShard();
+}
+
+module.exports = {
+  ServerCluster,
+  ShardServer,
+  toClusterPeerId,
+  fromClusterPeerId,
+  MAX_SHARDS,
+};
@@ -4,6 +4,8 @@
 */
 #define ENET_BUILDING_LIB 1
 #include "enet/enet.h"
+#include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 /** @defgroup host ENet host functions
@@ -35,6 +37,24 @@ ENetHost *enet_host_create(ENetAddressType type, const ENetAddress *address,
                            size_t peerCount, size_t channelLimit,
                            enet_uint32 incomingBandwidth,
                            enet_uint32 outgoingBandwidth) {
+  return enet_host_create_with_flags(type, address, peerCount, channelLimit,
+                                     incomingBandwidth, outgoingBandwidth, 0);
+}
+
+/** Creates a host as enet_host_create() does, with ENET_HOST_FLAG_* options
+    that must be applied to the socket before it is bound.
+
+    @param flags bitwise-or of ENetHostFlag values
+
+    @returns the host on success and NULL on failure, including when a
+   requested flag is not supported by the platform
+*/
+ENetHost *enet_host_create_with_flags(ENetAddressType type,
+                                      const ENetAddress *address,
+                                      size_t peerCount, size_t channelLimit,
+                                      enet_uint32 incomingBandwidth,
+                                      enet_uint32 outgoingBandwidth,
+                                      enet_uint32 flags) {
   ENetHost *host;
   ENetPeer *currentPeer;
 
@@ -49,23 +69,58 @@ ENetHost *enet_host_create(ENetAddressType type, const ENetAddress *address,
     return NULL;
   memset(host, 0, sizeof(ENetHost));
 
-  host->peers = (ENetPeer *)enet_malloc(peerCount * sizeof(ENetPeer));
+  host->peerHashMask = 1;
+  while (host->peerHashMask < peerCount)
+    host->peerHashMask <<= 1;
+
+  /* the address hash buckets and the throttle scratch array trail the peer
+     array in the same allocation */
+  host->peers = (ENetPeer *)enet_malloc(
+      peerCount * sizeof(ENetPeer) +
+      (host->peerHashMask + peerCount) * sizeof(ENetPeer *));
   if (host->peers == NULL) {
     enet_free(host);
 
     return NULL;
   }
-  memset(host->peers, 0, peerCount * sizeof(ENetPeer));
+  memset(host->peers, 0,
+         peerCount * sizeof(ENetPeer) +
+             (host->peerHashMask + peerCount) * sizeof(ENetPeer *));
+  host->peerHashBuckets = (ENetPeer **)&host->peers[peerCount];
+  host->throttlePeers = &host->peerHashBuckets[host->peerHashMask];
+  --host->peerHashMask;
+
+  host->receiveBatchData = (enet_uint8 *)enet_malloc(
+      ENET_SOCKET_BATCH_MAXIMUM * ENET_PROTOCOL_MAXIMUM_MTU);
+  if (ENET_SOCKET_BATCH_MAXIMUM > 1)
+    host->sendBatchData = (enet_uint8 *)enet_malloc(
+        ENET_SOCKET_BATCH_MAXIMUM * ENET_PROTOCOL_MAXIMUM_MTU);
+  if (host->receiveBatchData == NULL ||
+      (ENET_SOCKET_BATCH_MAXIMUM > 1 && host->sendBatchData == NULL)) {
+    if (host->receiveBatchData != NULL)
+      enet_free(host->receiveBatchData);
+    if (host->sendBatchData != NULL)
+      enet_free(host->sendBatchData);
+    enet_free(host->peers);
+    enet_free(host);
+
+    return NULL;
+  }
 
   host->socket = enet_socket_create(type, ENET_SOCKET_TYPE_DATAGRAM);
 
   if (host->socket != ENET_SOCKET_NULL && type == ENET_ADDRESS_TYPE_ANY)
     enet_socket_set_option(host->socket, ENET_SOCKOPT_IPV6ONLY, 0);
   if (host->socket == ENET_SOCKET_NULL ||
+      ((flags & ENET_HOST_FLAG_REUSE_PORT) &&
+       enet_socket_set_option(host->socket, ENET_SOCKOPT_REUSEPORT, 1) < 0) ||
       (address != NULL && enet_socket_bind(host->socket, address) < 0)) {
     if (host->socket != ENET_SOCKET_NULL)
       enet_socket_destroy(host->socket);
 
+    if (host->sendBatchData != NULL)
+      enet_free(host->sendBatchData);
+    enet_free(host->receiveBatchData);
     enet_free(host->peers);
     enet_free(host);
 
@@ -95,6 +150,7 @@ ENetHost *enet_host_create(ENetAddressType type, const ENetAddress *address,
   host->incomingBandwidth = incomingBandwidth;
   host->outgoingBandwidth = outgoingBandwidth;
   host->bandwidthThrottleEpoch = 0;
+  host->bandwidthThrottleInterval = ENET_HOST_BANDWIDTH_THROTTLE_INTERVAL;
   host->recalculateBandwidthLimits = 0;
   host->mtu = ENET_HOST_DEFAULT_MTU;
   host->peerCount = peerCount;
@@ -105,11 +161,21 @@ ENetHost *enet_host_create(ENetAddressType type, const ENetAddress *address,
   host->receivedAddress.port = 0;
   host->receivedData = NULL;
   host->receivedDataLength = 0;
+  host->receiveBatchCount = 0;
+  host->receiveBatchIndex = 0;
+  host->sendBatchCount = 0;
+
+  enet_pool_init(&host->outgoingCommandPool, sizeof(ENetOutgoingCommand));
+  enet_pool_init(&host->acknowledgementPool, sizeof(ENetAcknowledgement));
+  enet_pool_init(&host->incomingCommandPool, sizeof(ENetIncomingCommand));
+  enet_pool_init(&host->fragmentBitmapPool,
+                 ENET_HOST_POOL_FRAGMENT_COUNT / 32 * sizeof(enet_uint32));
 
   host->totalSentData = 0;
   host->totalSentPackets = 0;
   host->totalReceivedData = 0;
   host->totalReceivedPackets = 0;
+  host->totalRetransmits = 0;
   host->totalQueued = 0;
 
   host->connectedPeers = 0;
@@ -117,6 +183,9 @@ ENetHost *enet_host_create(ENetAddressType type, const ENetAddress *address,
   host->duplicatePeers = ENET_PROTOCOL_MAXIMUM_PEER_ID;
   host->maximumPacketSize = ENET_HOST_DEFAULT_MAXIMUM_PACKET_SIZE;
   host->maximumWaitingData = ENET_HOST_DEFAULT_MAXIMUM_WAITING_DATA;
+  host->maximumReassemblyData = ENET_HOST_DEFAULT_MAXIMUM_REASSEMBLY_DATA;
+  host->maximumPeerReassemblyData =
+      ENET_HOST_DEFAULT_MAXIMUM_PEER_REASSEMBLY_DATA;
 
   host->compressor.context = NULL;
   host->compressor.compress = NULL;
@@ -124,8 +193,13 @@ ENetHost *enet_host_create(ENetAddressType type, const ENetAddress *address,
   host->compressor.destroy = NULL;
 
   host->intercept = NULL;
+  host->interceptSend = NULL;
+  host->clock = NULL;
+  host->data = NULL;
+  host->histograms = NULL;
 
   enet_list_clear(&host->dispatchQueue);
+  enet_timer_wheel_init(&host->timerWheel, enet_time_get());
 
   for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount];
        ++currentPeer) {
@@ -133,6 +207,7 @@ ENetHost *enet_host_create(ENetAddressType type, const ENetAddress *address,
     currentPeer->incomingPeerID = currentPeer - host->peers;
     currentPeer->outgoingSessionID = currentPeer->incomingSessionID = 0xFF;
     currentPeer->data = NULL;
+    currentPeer->timer.slot = ENET_TIMER_UNSCHEDULED;
 
     enet_list_clear(&currentPeer->acknowledgements);
     enet_list_clear(&currentPeer->sentReliableCommands);
@@ -165,10 +240,220 @@ void enet_host_destroy(ENetHost *host) {
   if (host->compressor.context != NULL && host->compressor.destroy)
     (*host->compressor.destroy)(host->compressor.context);
 
+  enet_pool_destroy(&host->outgoingCommandPool);
+  enet_pool_destroy(&host->acknowledgementPool);
+  enet_pool_destroy(&host->incomingCommandPool);
+  enet_pool_destroy(&host->fragmentBitmapPool);
+
+  if (host->receiveSegmentData != NULL)
+    enet_free(host->receiveSegmentData);
+  if (host->sendBatchData != NULL)
+    enet_free(host->sendBatchData);
+  if (host->histograms != NULL)
+    enet_free(host->histograms);
+  enet_free(host->receiveBatchData);
   enet_free(host->peers);
   enet_free(host);
 }
 
+static size_t enet_host_address_hash(const ENetHost *host,
+                                     const ENetAddress *address) {
+  /* FNV-1a over the host part only, so every port of one remote host shares
+     a bucket and enet_address_equal_host matches stay within it */
+  const enet_uint8 *bytes;
+  size_t length, i;
+  enet_uint32 hash = 2166136261U;
+
+  if (address->type == ENET_ADDRESS_TYPE_IPV6) {
+    bytes = (const enet_uint8 *)&address->host.v6[0];
+    length = sizeof(address->host.v6);
+  } else {
+    bytes = &address->host.v4[0];
+    length = sizeof(address->host.v4);
+  }
+
+  for (i = 0; i < length; ++i)
+    hash = (hash ^ bytes[i]) * 16777619U;
+
+  return (size_t)(hash ^ (hash >> 16)) & host->peerHashMask;
+}
+
+/** Returns the first peer of the address bucket that may hold peers sharing
+    the host part of address; follow addressHashNext for the rest. */
+ENetPeer *enet_host_peer_bucket(ENetHost *host, const ENetAddress *address) {
+  return host->peerHashBuckets[enet_host_address_hash(host, address)];
+}
+
+void enet_host_index_peer(ENetHost *host, ENetPeer *peer) {
+  ENetPeer **bucket;
+
+  if (peer->addressHashPrev != NULL)
+    enet_host_unindex_peer(host, peer);
+
+  bucket = &host->peerHashBuckets[enet_host_address_hash(host, &peer->address)];
+
+  peer->addressHashNext = *bucket;
+  if (*bucket != NULL)
+    (*bucket)->addressHashPrev = &peer->addressHashNext;
+  peer->addressHashPrev = bucket;
+  *bucket = peer;
+}
+
+void enet_host_unindex_peer(ENetHost *host, ENetPeer *peer) {
+  (void)host;
+
+  if (peer->addressHashPrev == NULL)
+    return;
+
+  *peer->addressHashPrev = peer->addressHashNext;
+  if (peer->addressHashNext != NULL)
+    peer->addressHashNext->addressHashPrev = peer->addressHashPrev;
+
+  peer->addressHashNext = NULL;
+  peer->addressHashPrev = NULL;
+}
+
+/** Takes the oldest disconnected slot off the free list, or NULL if every
+    peer is in use. */
+ENetPeer *enet_host_acquire_peer(ENetHost *host) {
+  while (host->freePeers != NULL) {
+    ENetPeer *peer = host->freePeers;
+
+    host->freePeers = peer->freeSlotNext;
+    if (host->freePeers == NULL)
+      host->lastFreePeer = NULL;
+
+    peer->freeSlotNext = NULL;
+    peer->freeSlotListed = 0;
+
+    /* slots brought up behind the list's back are dropped here and queued
+       again by their next reset */
+    if (peer->state != ENET_PEER_STATE_DISCONNECTED)
+      continue;
+
+    peer->activeNext = host->activePeers;
+    if (host->activePeers != NULL)
+      host->activePeers->activePrev = &peer->activeNext;
+    peer->activePrev = &host->activePeers;
+    host->activePeers = peer;
+
+    return peer;
+  }
+
+  return NULL;
+}
+
+void enet_host_release_peer(ENetHost *host, ENetPeer *peer) {
+  enet_timer_cancel(&host->timerWheel, &peer->timer);
+
+  if (peer->activePrev != NULL) {
+    *peer->activePrev = peer->activeNext;
+    if (peer->activeNext != NULL)
+      peer->activeNext->activePrev = peer->activePrev;
+
+    peer->activeNext = NULL;
+    peer->activePrev = NULL;
+  }
+
+  if (peer->dirtyPrev != NULL) {
+    *peer->dirtyPrev = peer->dirtyNext;
+    if (peer->dirtyNext != NULL)
+      peer->dirtyNext->dirtyPrev = peer->dirtyPrev;
+
+    peer->dirtyNext = NULL;
+    peer->dirtyPrev = NULL;
+  }
+
+  if (peer->freeSlotListed)
+    return;
+
+  peer->freeSlotListed = 1;
+  peer->freeSlotNext = NULL;
+
+  if (host->lastFreePeer != NULL)
+    host->lastFreePeer->freeSlotNext = peer;
+  else
+    host->freePeers = peer;
+  host->lastFreePeer = peer;
+}
+
+/** Queues a peer for the next flush once it has something to send. */
+void enet_host_mark_peer_dirty(ENetHost *host, ENetPeer *peer) {
+  if (peer->dirtyPrev != NULL)
+    return;
+
+  peer->dirtyNext = host->dirtyPeers;
+  if (host->dirtyPeers != NULL)
+    host->dirtyPeers->dirtyPrev = &peer->dirtyNext;
+  peer->dirtyPrev = &host->dirtyPeers;
+  host->dirtyPeers = peer;
+}
+
+/** Drops a peer from the dirty list once a send pass has emptied its queues.
+ */
+void enet_host_update_peer_dirty(ENetHost *host, ENetPeer *peer) {
+  if (peer->dirtyPrev == NULL ||
+      !enet_list_empty(&peer->acknowledgements) ||
+      !enet_list_empty(&peer->outgoingCommands) ||
+      !enet_list_empty(&peer->outgoingSendReliableCommands))
+    return;
+
+  (void)host;
+
+  *peer->dirtyPrev = peer->dirtyNext;
+  if (peer->dirtyNext != NULL)
+    peer->dirtyNext->dirtyPrev = peer->dirtyPrev;
+
+  peer->dirtyNext = NULL;
+  peer->dirtyPrev = NULL;
+}
+
+/** Files a peer under its next deadline: the earliest retransmit timeout while
+    reliable commands are in flight, otherwise the time its next ping is due.
+    Deadlines may be early, since lastReceiveTime only moves later between send
+    passes and a peer woken early is simply filed again. nextTimeout can also
+    move earlier when an acknowledgement exposes a command with a shorter
+    timeout; the acknowledgement files the peer again in that case.
+ */
+void enet_host_schedule_peer(ENetHost *host, ENetPeer *peer) {
+  enet_uint32 deadline;
+
+  if (peer->state == ENET_PEER_STATE_DISCONNECTED ||
+      peer->state == ENET_PEER_STATE_ZOMBIE) {
+    enet_timer_cancel(&host->timerWheel, &peer->timer);
+    return;
+  }
+
+  if (!enet_list_empty(&peer->sentReliableCommands))
+    deadline = peer->nextTimeout;
+  else
+    deadline = peer->lastReceiveTime + peer->pingInterval;
+
+  if (peer->timer.slot != ENET_TIMER_UNSCHEDULED &&
+      peer->timer.deadline == deadline)
+    return;
+
+  enet_timer_schedule(&host->timerWheel, &peer->timer, deadline);
+}
+
+/** Moves every peer whose deadline has passed by host->serviceTime onto the
+    dirty list, so the next send pass visits it.
+ */
+void enet_host_expire_peers(ENetHost *host) {
+  ENetList expired;
+
+  enet_list_clear(&expired);
+  enet_timer_wheel_expire(&host->timerWheel, host->serviceTime, &expired);
+
+  while (!enet_list_empty(&expired)) {
+    ENetTimer *timer =
+        (ENetTimer *)enet_list_remove(enet_list_begin(&expired));
+
+    enet_host_mark_peer_dirty(
+        host, (ENetPeer *)((enet_uint8 *)timer - offsetof(ENetPeer, timer)));
+  }
+}
+
 enet_uint32 enet_host_random(ENetHost *host) {
   /* Mulberry32 by Tommy Ettinger */
   enet_uint32 n = (host->randomSeed += 0x6D2B79F5U);
@@ -198,22 +483,21 @@ ENetPeer *enet_host_connect(ENetHost *host, const ENetAddress *address,
   else if (channelCount > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT)
     channelCount = ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT;
 
-  for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount];
-       ++currentPeer) {
-    if (currentPeer->state == ENET_PEER_STATE_DISCONNECTED)
-      break;
-  }
-
-  if (currentPeer >= &host->peers[host->peerCount])
+  currentPeer = enet_host_acquire_peer(host);
+  if (currentPeer == NULL)
     return NULL;
 
   currentPeer->channels =
       (ENetChannel *)enet_malloc(channelCount * sizeof(ENetChannel));
-  if (currentPeer->channels == NULL)
+  if (currentPeer->channels == NULL) {
+    enet_host_release_peer(host, currentPeer);
+
     return NULL;
+  }
   currentPeer->channelCount = channelCount;
   currentPeer->state = ENET_PEER_STATE_CONNECTING;
   currentPeer->address = *address;
+  enet_host_index_peer(host, currentPeer);
   currentPeer->connectID = enet_host_random(host);
   currentPeer->mtu = host->mtu;
 
@@ -238,6 +522,10 @@ ENetPeer *enet_host_connect(ENetHost *host, const ENetAddress *address,
 
     enet_list_clear(&channel->incomingReliableCommands);
     enet_list_clear(&channel->incomingUnreliableCommands);
+    channel->priority =
+        host->channelPriorities[channel - currentPeer->channels];
+    enet_sequence_index_init(&channel->incomingReliableIndex);
+    enet_sequence_index_init(&channel->sentReliableIndex);
 
     channel->usedReliableWindows = 0;
     memset(channel->reliableWindows, 0, sizeof(channel->reliableWindows));
@@ -280,8 +568,8 @@ void enet_host_broadcast(ENetHost *host, enet_uint8 channelID,
                          ENetPacket *packet) {
   ENetPeer *currentPeer;
 
-  for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount];
-       ++currentPeer) {
+  for (currentPeer = host->activePeers; currentPeer != NULL;
+       currentPeer = currentPeer->activeNext) {
     if (currentPeer->state != ENET_PEER_STATE_CONNECTED)
       continue;
 
@@ -322,6 +610,38 @@ void enet_host_channel_limit(ENetHost *host, size_t channelLimit) {
   host->channelLimit = channelLimit;
 }
 
+/** Enables or disables UDP segmentation offload modes on a host.
+    @param host host to adjust
+    @param flags the ENET_HOST_OFFLOAD_* modes wanted; modes not listed are
+   turned off
+    @returns the modes that are actually active, which excludes any the socket
+   or platform does not support
+    @remarks GSO needs batched sends and is never enabled without them. GSO may
+   also switch itself off later if the device rejects a segmented write.
+*/
+enet_uint32 enet_host_offload(ENetHost *host, enet_uint32 flags) {
+  if ((flags & ENET_HOST_OFFLOAD_GSO) && host->sendBatchData != NULL &&
+      enet_socket_set_option(host->socket, ENET_SOCKOPT_UDP_SEGMENT, 0) == 0)
+    host->offloadFlags |= ENET_HOST_OFFLOAD_GSO;
+  else
+    host->offloadFlags &= ~ENET_HOST_OFFLOAD_GSO;
+
+  if (flags & ENET_HOST_OFFLOAD_GRO) {
+    if (host->receiveSegmentData == NULL)
+      host->receiveSegmentData =
+          (enet_uint8 *)enet_malloc(ENET_HOST_OFFLOAD_BUFFER_SIZE);
+
+    if (host->receiveSegmentData != NULL &&
+        enet_socket_set_option(host->socket, ENET_SOCKOPT_UDP_GRO, 1) == 0)
+      host->offloadFlags |= ENET_HOST_OFFLOAD_GRO;
+  } else if (host->offloadFlags & ENET_HOST_OFFLOAD_GRO) {
+    enet_socket_set_option(host->socket, ENET_SOCKOPT_UDP_GRO, 0);
+    host->offloadFlags &= ~ENET_HOST_OFFLOAD_GRO;
+  }
+
+  return host->offloadFlags;
+}
+
 /** Adjusts the bandwidth limits of a host.
     @param host host to adjust
     @param incomingBandwidth new incoming bandwidth
@@ -336,28 +656,82 @@ void enet_host_bandwidth_limit(ENetHost *host, enet_uint32 incomingBandwidth,
   host->recalculateBandwidthLimits = 1;
 }
 
-void enet_host_bandwidth_throttle(ENetHost *host) {
-  enet_uint32 timeCurrent = enet_time_get(),
-              elapsedTime = timeCurrent - host->bandwidthThrottleEpoch,
-              peersRemaining = (enet_uint32)host->connectedPeers,
-              dataTotal = ~0, bandwidth = ~0, throttle = 0, bandwidthLimit = 0;
-  int needsAdjustment = host->bandwidthLimitedPeers > 0 ? 1 : 0;
-  ENetPeer *peer;
-  ENetProtocol command;
+/** Sets how often the host rebalances packet throttles against its bandwidth
+    limits.
+    @param host host to adjust
+    @param interval milliseconds between rebalances, or 0 to leave packet
+   throttles to round trip measurements alone
+    @remarks bandwidth limit changes are still negotiated with peers while
+   rebalancing is off.
+*/
+void enet_host_bandwidth_throttle_interval(ENetHost *host,
+                                           enet_uint32 interval) {
+  host->bandwidthThrottleInterval = interval;
+}
 
-  if (elapsedTime < ENET_HOST_BANDWIDTH_THROTTLE_INTERVAL)
+/** Turns streaming delivery on or off for a channel of every peer.
+    @param host host to adjust
+    @param channelID channel to adjust
+    @param enable non-zero to stream the channel
+    @remarks reliable fragmented messages received on a streaming channel are
+   not reassembled; each fragment is returned as an
+   ENET_EVENT_TYPE_RECEIVE_CHUNK event as soon as it is in order. Unreliable
+   fragments are still reassembled.
+*/
+void enet_host_stream_channel(ENetHost *host, enet_uint8 channelID,
+                              int enable) {
+  if (channelID >= ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT)
     return;
 
-  host->bandwidthThrottleEpoch = timeCurrent;
+  if (enable)
+    host->streamingChannels[channelID / 32] |= 1u << (channelID % 32);
+  else
+    host->streamingChannels[channelID / 32] &= ~(1u << (channelID % 32));
+}
 
-  if (peersRemaining == 0)
+/** Sets the priority a channel starts with on peers connected from now on.
+    @param host host to adjust
+    @param channelID channel to adjust
+    @param priority priority of the channel, 0 (the default) being lowest
+    @remarks when a datagram is packed, queued commands of higher priority
+   channels are taken first; commands of equal priority keep the order they
+   were queued in. Protocol commands such as pings and disconnects use
+   ENET_PEER_CONTROL_PRIORITY. Use enet_peer_channel_priority() to change the
+   priority on a peer that is already connected.
+*/
+void enet_host_channel_priority(ENetHost *host, enet_uint8 channelID,
+                                enet_uint8 priority) {
+  if (channelID >= ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT)
     return;
 
+  host->channelPriorities[channelID] = priority;
+}
+
+static int enet_host_compare_outgoing_bandwidth(const void *first,
+                                                const void *second) {
+  enet_uint32 firstBandwidth = (*(ENetPeer *const *)first)->outgoingBandwidth,
+              secondBandwidth = (*(ENetPeer *const *)second)->outgoingBandwidth;
+
+  return firstBandwidth < secondBandwidth   ? -1
+         : firstBandwidth > secondBandwidth ? 1
+                                            : 0;
+}
+
+/* Caps every peer whose share of the host's outgoing bandwidth would exceed
+   its own downstream, then spreads the rest evenly. Capping only lowers the
+   shared throttle, so a second pass would never cap another peer and one is
+   enough. */
+static void enet_host_throttle_peers(ENetHost *host, enet_uint32 timeCurrent,
+                                     enet_uint32 elapsedTime) {
+  enet_uint32 peersRemaining = (enet_uint32)host->connectedPeers, throttle;
+  enet_uint64 dataTotal = ~0ULL, bandwidth = ~0ULL;
+  ENetPeer *peer;
+
   if (host->outgoingBandwidth != 0) {
     dataTotal = 0;
-    bandwidth = (host->outgoingBandwidth * elapsedTime) / 1000;
+    bandwidth = ((enet_uint64)host->outgoingBandwidth * elapsedTime) / 1000;
 
-    for (peer = host->peers; peer < &host->peers[host->peerCount]; ++peer) {
+    for (peer = host->activePeers; peer != NULL; peer = peer->activeNext) {
       if (peer->state != ENET_PEER_STATE_CONNECTED &&
           peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
         continue;
@@ -366,16 +740,15 @@ void enet_host_bandwidth_throttle(ENetHost *host) {
     }
   }
 
-  while (peersRemaining > 0 && needsAdjustment != 0) {
-    needsAdjustment = 0;
-
+  if (host->bandwidthLimitedPeers > 0) {
     if (dataTotal <= bandwidth)
       throttle = ENET_PEER_PACKET_THROTTLE_SCALE;
     else
-      throttle = (bandwidth * ENET_PEER_PACKET_THROTTLE_SCALE) / dataTotal;
+      throttle = (enet_uint32)((bandwidth * ENET_PEER_PACKET_THROTTLE_SCALE) /
+                               dataTotal);
 
-    for (peer = host->peers; peer < &host->peers[host->peerCount]; ++peer) {
-      enet_uint32 peerBandwidth;
+    for (peer = host->activePeers; peer != NULL; peer = peer->activeNext) {
+      enet_uint64 peerBandwidth;
 
       if ((peer->state != ENET_PEER_STATE_CONNECTED &&
            peer->state != ENET_PEER_STATE_DISCONNECT_LATER) ||
@@ -383,15 +756,15 @@ void enet_host_bandwidth_throttle(ENetHost *host) {
           peer->outgoingBandwidthThrottleEpoch == timeCurrent)
         continue;
 
-      peerBandwidth = (peer->incomingBandwidth * elapsedTime) / 1000;
-      if ((throttle * peer->outgoingDataTotal) /
+      peerBandwidth = ((enet_uint64)peer->incomingBandwidth * elapsedTime) / 1000;
+      if (((enet_uint64)throttle * peer->outgoingDataTotal) /
               ENET_PEER_PACKET_THROTTLE_SCALE <=
           peerBandwidth)
         continue;
 
       peer->packetThrottleLimit =
-          (peerBandwidth * ENET_PEER_PACKET_THROTTLE_SCALE) /
-          peer->outgoingDataTotal;
+          (enet_uint32)((peerBandwidth * ENET_PEER_PACKET_THROTTLE_SCALE) /
+                        peer->outgoingDataTotal);
 
       if (peer->packetThrottleLimit == 0)
         peer->packetThrottleLimit = 1;
@@ -404,7 +777,6 @@ void enet_host_bandwidth_throttle(ENetHost *host) {
       peer->incomingDataTotal = 0;
       peer->outgoingDataTotal = 0;
 
-      needsAdjustment = 1;
       --peersRemaining;
       bandwidth -= peerBandwidth;
       dataTotal -= peerBandwidth;
@@ -415,9 +787,10 @@ void enet_host_bandwidth_throttle(ENetHost *host) {
     if (dataTotal <= bandwidth)
       throttle = ENET_PEER_PACKET_THROTTLE_SCALE;
     else
-      throttle = (bandwidth * ENET_PEER_PACKET_THROTTLE_SCALE) / dataTotal;
+      throttle = (enet_uint32)((bandwidth * ENET_PEER_PACKET_THROTTLE_SCALE) /
+                               dataTotal);
 
-    for (peer = host->peers; peer < &host->peers[host->peerCount]; ++peer) {
+    for (peer = host->activePeers; peer != NULL; peer = peer->activeNext) {
       if ((peer->state != ENET_PEER_STATE_CONNECTED &&
            peer->state != ENET_PEER_STATE_DISCONNECT_LATER) ||
           peer->outgoingBandwidthThrottleEpoch == timeCurrent)
@@ -432,59 +805,113 @@ void enet_host_bandwidth_throttle(ENetHost *host) {
       peer->outgoingDataTotal = 0;
     }
   }
+}
 
-  if (host->recalculateBandwidthLimits) {
-    host->recalculateBandwidthLimits = 0;
+/* Water-fills the host's incoming bandwidth: peers whose upstream is unlimited
+   or below the even share keep their own rate and the remainder is split
+   among the rest. Visiting peers in ascending upstream order settles on the
+   same share as repeated rescans in a single pass. */
+static void enet_host_distribute_incoming_bandwidth(ENetHost *host,
+                                                    enet_uint32 timeCurrent) {
+  enet_uint32 peersRemaining = 0, bandwidth = host->incomingBandwidth,
+              bandwidthLimit = 0;
+  size_t peerCount = 0, i;
+  ENetPeer *peer;
+  ENetProtocol command;
+
+  for (peer = host->activePeers; peer != NULL; peer = peer->activeNext) {
+    if (peer->state != ENET_PEER_STATE_CONNECTED &&
+        peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
+      continue;
+
+    host->throttlePeers[peerCount++] = peer;
+  }
+
+  peersRemaining = (enet_uint32)peerCount;
+
+  if (bandwidth != 0) {
+    qsort(host->throttlePeers, peerCount, sizeof(ENetPeer *),
+          enet_host_compare_outgoing_bandwidth);
+
+    for (i = 0; i < peerCount; ++i) {
+      peer = host->throttlePeers[i];
+      bandwidthLimit = bandwidth / peersRemaining;
+
+      if (peer->outgoingBandwidth > 0 &&
+          peer->outgoingBandwidth >= bandwidthLimit)
+        break;
+
+      peer->incomingBandwidthThrottleEpoch = timeCurrent;
+
+      --peersRemaining;
+      bandwidth -= peer->outgoingBandwidth;
+    }
+  }
+
+  for (i = 0; i < peerCount; ++i) {
+    peer = host->throttlePeers[i];
 
-    peersRemaining = (enet_uint32)host->connectedPeers;
-    bandwidth = host->incomingBandwidth;
-    needsAdjustment = 1;
+    command.header.command = ENET_PROTOCOL_COMMAND_BANDWIDTH_LIMIT |
+                             ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
+    command.header.channelID = 0xFF;
+    command.bandwidthLimit.outgoingBandwidth =
+        ENET_HOST_TO_NET_32(host->outgoingBandwidth);
 
-    if (bandwidth == 0)
-      bandwidthLimit = 0;
+    if (peer->incomingBandwidthThrottleEpoch == timeCurrent)
+      command.bandwidthLimit.incomingBandwidth =
+          ENET_HOST_TO_NET_32(peer->outgoingBandwidth);
     else
-      while (peersRemaining > 0 && needsAdjustment != 0) {
-        needsAdjustment = 0;
-        bandwidthLimit = bandwidth / peersRemaining;
+      command.bandwidthLimit.incomingBandwidth =
+          ENET_HOST_TO_NET_32(bandwidthLimit);
 
-        for (peer = host->peers; peer < &host->peers[host->peerCount]; ++peer) {
-          if ((peer->state != ENET_PEER_STATE_CONNECTED &&
-               peer->state != ENET_PEER_STATE_DISCONNECT_LATER) ||
-              peer->incomingBandwidthThrottleEpoch == timeCurrent)
-            continue;
+    enet_peer_queue_outgoing_command(peer, &command, NULL, 0, 0);
+  }
+}
 
-          if (peer->outgoingBandwidth > 0 &&
-              peer->outgoingBandwidth >= bandwidthLimit)
-            continue;
+/** Returns the current time of the host: its clock callback if one is set,
+    enet_time_get() otherwise. */
+enet_uint32 enet_host_time(ENetHost *host) {
+  return host->clock != NULL ? host->clock(host) : enet_time_get();
+}
 
-          peer->incomingBandwidthThrottleEpoch = timeCurrent;
+/** Runs the host on a different clock, or on enet_time_get() if clock is NULL.
+    Deadlines taken from the old clock mean nothing on the new one, so this is
+    only valid while no peer is connected; the timer wheel and the throttle
+    epoch restart at the new clock's current time.
+    @param host  host to change
+    @param clock clock callback, or NULL
+    @ingroup host
+*/
+void enet_host_set_clock(ENetHost *host, ENetClockCallback clock) {
+  host->clock = clock;
+  host->serviceTime = enet_host_time(host);
+  host->bandwidthThrottleEpoch = host->serviceTime;
 
-          needsAdjustment = 1;
-          --peersRemaining;
-          bandwidth -= peer->outgoingBandwidth;
-        }
-      }
+  enet_timer_wheel_init(&host->timerWheel, host->serviceTime);
+}
 
-    for (peer = host->peers; peer < &host->peers[host->peerCount]; ++peer) {
-      if (peer->state != ENET_PEER_STATE_CONNECTED &&
-          peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
-        continue;
+void enet_host_bandwidth_throttle(ENetHost *host) {
+  enet_uint32 timeCurrent = host->serviceTime,
+              elapsedTime = timeCurrent - host->bandwidthThrottleEpoch;
 
-      command.header.command = ENET_PROTOCOL_COMMAND_BANDWIDTH_LIMIT |
-                               ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
-      command.header.channelID = 0xFF;
-      command.bandwidthLimit.outgoingBandwidth =
-          ENET_HOST_TO_NET_32(host->outgoingBandwidth);
+  if (host->bandwidthThrottleInterval != 0) {
+    if (elapsedTime < host->bandwidthThrottleInterval)
+      return;
+  } else if (!host->recalculateBandwidthLimits)
+    return;
 
-      if (peer->incomingBandwidthThrottleEpoch == timeCurrent)
-        command.bandwidthLimit.incomingBandwidth =
-            ENET_HOST_TO_NET_32(peer->outgoingBandwidth);
-      else
-        command.bandwidthLimit.incomingBandwidth =
-            ENET_HOST_TO_NET_32(bandwidthLimit);
+  host->bandwidthThrottleEpoch = timeCurrent;
 
-      enet_peer_queue_outgoing_command(peer, &command, NULL, 0, 0);
-    }
+  if (host->connectedPeers == 0)
+    return;
+
+  if (host->bandwidthThrottleInterval != 0)
+    enet_host_throttle_peers(host, timeCurrent, elapsedTime);
+
+  if (host->recalculateBandwidthLimits) {
+    host->recalculateBandwidthLimits = 0;
+
+    enet_host_distribute_incoming_bandwidth(host, timeCurrent);
   }
 }
 
@@ -13,9 +13,17 @@
 #include "enet/unix.h"
 #endif
 
+#ifndef ENET_SOCKET_BATCH_MAXIMUM
+#define ENET_SOCKET_BATCH_MAXIMUM 1
+#endif
+
 #include "enet/callbacks.h"
+#include "enet/instrument.h"
 #include "enet/list.h"
+#include "enet/pool.h"
 #include "enet/protocol.h"
+#include "enet/timer.h"
+#include "enet/sequence.h"
 #include "enet/types.h"
 
 #define ENET_VERSION_MAJOR 1
@@ -59,7 +67,10 @@ typedef enum _ENetSocketOption {
   ENET_SOCKOPT_ERROR = 8,
   ENET_SOCKOPT_NODELAY = 9,
   ENET_SOCKOPT_TTL = 10,
-  ENET_SOCKOPT_IPV6ONLY = 11
+  ENET_SOCKOPT_IPV6ONLY = 11,
+  ENET_SOCKOPT_UDP_SEGMENT = 12,
+  ENET_SOCKOPT_UDP_GRO = 13,
+  ENET_SOCKOPT_REUSEPORT = 14
 } ENetSocketOption;
 
 typedef enum _ENetSocketShutdown {
@@ -120,7 +131,10 @@ typedef enum _ENetPacketFlag {
 
   /** whether the packet has been sent from all queues it has been entered into
    */
-  ENET_PACKET_FLAG_SENT = (1 << 8)
+  ENET_PACKET_FLAG_SENT = (1 << 8),
+  /** set on the packet of an ENET_EVENT_TYPE_RECEIVE_CHUNK event that completes
+   * its message */
+  ENET_PACKET_FLAG_LAST_CHUNK = (1 << 9)
 } ENetPacketFlag;
 
 typedef void(ENET_CALLBACK *ENetPacketFreeCallback)(struct _ENetPacket *);
@@ -178,8 +192,15 @@ typedef struct _ENetOutgoingCommand {
   enet_uint32 fragmentOffset;
   enet_uint16 fragmentLength;
   enet_uint16 sendAttempts;
+  enet_uint8 inFlight; /**< queued in sentReliableCommands, as opposed to sent
+                          before and waiting to be resent */
+  enet_uint8 priority; /**< priority of the channel when queued */
   ENetProtocol command;
   ENetPacket *packet;
+#ifdef ENET_INSTRUMENT
+  enet_uint64 instrumentTime; /**< enet_time_get_ns() when queued, 0 if the
+                                 host was not instrumenting then */
+#endif
 } ENetOutgoingCommand;
 
 typedef struct _ENetIncomingCommand {
@@ -217,6 +238,17 @@ enum {
   ENET_HOST_DEFAULT_MTU = 1392,
   ENET_HOST_DEFAULT_MAXIMUM_PACKET_SIZE = 32 * 1024 * 1024,
   ENET_HOST_DEFAULT_MAXIMUM_WAITING_DATA = 32 * 1024 * 1024,
+  ENET_HOST_DEFAULT_MAXIMUM_REASSEMBLY_DATA = 256 * 1024 * 1024,
+  /* room for the largest packet plus the bitmap of its fragments */
+  ENET_HOST_DEFAULT_MAXIMUM_PEER_REASSEMBLY_DATA =
+      ENET_HOST_DEFAULT_MAXIMUM_PACKET_SIZE +
+      ENET_PROTOCOL_MAXIMUM_FRAGMENT_COUNT / 8,
+  ENET_HOST_OFFLOAD_MAXIMUM_SEGMENTS = 64,
+  ENET_HOST_OFFLOAD_MAXIMUM_SIZE = 65000,
+  ENET_HOST_OFFLOAD_BUFFER_SIZE = 65536,
+  ENET_HOST_POOL_FRAGMENT_COUNT = 1024,
+
+  ENET_LZ4_DICTIONARY_MAXIMUM = 32 * 1024,
 
   ENET_PEER_DEFAULT_ROUND_TRIP_TIME = 500,
   ENET_PEER_DEFAULT_PACKET_THROTTLE = 32,
@@ -237,7 +269,8 @@ enum {
   ENET_PEER_FREE_UNSEQUENCED_WINDOWS = 32,
   ENET_PEER_RELIABLE_WINDOWS = 16,
   ENET_PEER_RELIABLE_WINDOW_SIZE = 0x1000,
-  ENET_PEER_FREE_RELIABLE_WINDOWS = 8
+  ENET_PEER_FREE_RELIABLE_WINDOWS = 8,
+  ENET_PEER_CONTROL_PRIORITY = 0xFF
 };
 
 typedef struct _ENetChannel {
@@ -249,8 +282,27 @@ typedef struct _ENetChannel {
   enet_uint16 incomingUnreliableSequenceNumber;
   ENetList incomingReliableCommands;
   ENetList incomingUnreliableCommands;
+  enet_uint8 priority; /**< commands on higher priority channels are sent
+                          first, see enet_peer_channel_priority() */
+  ENetSequenceIndex incomingReliableIndex; /**< incomingReliableCommands by
+                                              reliable sequence number */
+  ENetSequenceIndex sentReliableIndex;     /**< reliable commands sent at least
+                                              once and not yet acknowledged */
 } ENetChannel;
 
+typedef enum _ENetHostOffload {
+  ENET_HOST_OFFLOAD_GSO = (1 << 0), /**< coalesce runs of datagrams to one peer
+                                       into a single UDP_SEGMENT write */
+  ENET_HOST_OFFLOAD_GRO = (1 << 1)  /**< receive kernel coalesced datagrams
+                                       and split them before handling */
+} ENetHostOffload;
+
+typedef enum _ENetHostFlag {
+  ENET_HOST_FLAG_REUSE_PORT = (1 << 0) /**< bind with SO_REUSEPORT so several
+                                          hosts share one port and the kernel
+                                          spreads clients across them */
+} ENetHostFlag;
+
 typedef enum _ENetPeerFlag {
   ENET_PEER_FLAG_NEEDS_DISPATCH = (1 << 0),
   ENET_PEER_FLAG_CONTINUE_SENDING = (1 << 1)
@@ -271,6 +323,8 @@ typedef struct _ENetPeer {
   enet_uint8 incomingSessionID;
   ENetAddress address; /**< Internet address of the peer */
   void *data;          /**< Application private data, may be freely modified */
+  enet_uint32 generation; /**< incremented by enet_peer_reset, so a slot can be
+                             told apart from its previous occupants */
   ENetPeerState state;
   ENetChannel *channels;
   size_t channelCount; /**< Number of channels allocated for communication with
@@ -322,6 +376,8 @@ typedef struct _ENetPeer {
   ENetList outgoingSendReliableCommands;
   ENetList outgoingCommands;
   ENetList dispatchedCommands;
+  ENetSequenceIndex sentControlIndex; /**< sentReliableIndex of the commands
+                                         sent outside any channel */
   enet_uint16 flags;
   enet_uint16 nonce;
   enet_uint16 incomingUnsequencedGroup;
@@ -329,6 +385,28 @@ typedef struct _ENetPeer {
   enet_uint32 unsequencedWindow[ENET_PEER_UNSEQUENCED_WINDOW_SIZE / 32];
   enet_uint32 eventData;
   size_t totalWaitingData;
+  size_t reassemblyData; /**< bytes held by messages that are still being
+                            reassembled from fragments */
+  enet_uint64 totalSentData;        /**< datagram bytes sent to the peer since
+                                       it was last reset */
+  enet_uint64 totalSentPackets;     /**< datagrams sent to the peer */
+  enet_uint64 totalReceivedData;    /**< datagram bytes received from the peer */
+  enet_uint64 totalReceivedPackets; /**< datagrams received from the peer */
+  enet_uint64 totalRetransmits;     /**< reliable commands resent after a
+                                       timeout */
+  struct _ENetPeer *addressHashNext;   /**< next peer in the same host bucket */
+  struct _ENetPeer **addressHashPrev;  /**< link pointing at this peer, NULL
+                                          while not indexed by address */
+  struct _ENetPeer *freeSlotNext;      /**< next slot in the host free list */
+  struct _ENetPeer *activeNext;        /**< next peer in the host active list */
+  struct _ENetPeer **activePrev;       /**< link pointing at this peer, NULL
+                                          while the slot is free */
+  struct _ENetPeer *dirtyNext;         /**< next peer in the host dirty list */
+  struct _ENetPeer **dirtyPrev;        /**< link pointing at this peer, NULL
+                                          while nothing is queued to send */
+  enet_uint8 freeSlotListed;           /**< whether the slot is queued in the
+                                          host free list */
+  ENetTimer timer; /**< next retransmit or ping deadline in the host wheel */
 } ENetPeer;
 
 /** An ENet packet compressor for compressing UDP packets before socket sends or
@@ -362,6 +440,18 @@ typedef enet_uint32(ENET_CALLBACK *ENetChecksumCallback)(
 typedef int(ENET_CALLBACK *ENetInterceptCallback)(struct _ENetHost *host,
                                                   struct _ENetEvent *event);
 
+/** Callback for intercepting raw UDP packets about to be sent to address,
+ * gathered from buffers[0:bufferCount-1]. Should return 1 to intercept, in
+ * which case the packet is treated as sent without reaching the socket, 0 to
+ * ignore, or -1 to propagate an error. */
+typedef int(ENET_CALLBACK *ENetSendInterceptCallback)(
+    struct _ENetHost *host, const ENetAddress *address,
+    const ENetBuffer *buffers, size_t bufferCount);
+
+/** Callback that returns the current time of a host in milliseconds, in place
+ * of enet_time_get(). */
+typedef enet_uint32(ENET_CALLBACK *ENetClockCallback)(struct _ENetHost *host);
+
 /** An ENet host for communicating with peers.
   *
   * No fields should be modified unless otherwise stated.
@@ -374,6 +464,7 @@ typedef int(ENET_CALLBACK *ENetInterceptCallback)(struct _ENetHost *host,
     @sa enet_host_broadcast()
     @sa enet_host_compress()
     @sa enet_host_compress_with_range_coder()
+    @sa enet_host_compress_with_lz4()
     @sa enet_host_channel_limit()
     @sa enet_host_bandwidth_limit()
     @sa enet_host_bandwidth_throttle()
@@ -384,6 +475,8 @@ typedef struct _ENetHost {
   enet_uint32 incomingBandwidth; /**< downstream bandwidth of the host */
   enet_uint32 outgoingBandwidth; /**< upstream bandwidth of the host */
   enet_uint32 bandwidthThrottleEpoch;
+  enet_uint32 bandwidthThrottleInterval; /**< milliseconds between packet
+                                            throttle rebalances, 0 disables */
   enet_uint32 mtu;
   enet_uint32 randomSeed;
   int recalculateBandwidthLimits;
@@ -407,17 +500,21 @@ typedef struct _ENetHost {
   ENetAddress receivedAddress;
   enet_uint8 *receivedData;
   size_t receivedDataLength;
-  enet_uint32 totalSentData;     /**< total data sent, user should reset to 0 as
-                                    needed to prevent overflow */
-  enet_uint32 totalSentPackets;  /**< total UDP packets sent, user should reset
-                                    to 0 as needed to prevent overflow */
-  enet_uint32 totalReceivedData; /**< total data received, user should reset to
-                                    0 as needed to prevent overflow */
-  enet_uint32
-      totalReceivedPackets; /**< total UDP packets received, user should reset
-                               to 0 as needed to prevent overflow */
+  enet_uint64 totalSentData;        /**< total data sent */
+  enet_uint64 totalSentPackets;     /**< total UDP packets sent */
+  enet_uint64 totalReceivedData;    /**< total data received */
+  enet_uint64 totalReceivedPackets; /**< total UDP packets received */
+  enet_uint64 totalRetransmits;     /**< total reliable commands resent after a
+                                       timeout */
   ENetInterceptCallback intercept; /**< callback the user can set to intercept
                                       received raw UDP packets */
+  ENetSendInterceptCallback
+      interceptSend; /**< callback the user can set to intercept raw UDP
+                        packets before they are sent */
+  ENetClockCallback clock; /**< callback the user can set to run the host on its
+                              own clock, e.g. to replay captured traffic; set
+                              it with enet_host_set_clock() */
+  void *data; /**< Application private data, may be freely modified */
   size_t connectedPeers;
   size_t bandwidthLimitedPeers;
   size_t duplicatePeers;    /**< optional number of allowed peers from duplicate
@@ -427,8 +524,58 @@ typedef struct _ENetHost {
   size_t
       maximumWaitingData;    /**< the maximum aggregate amount of buffer space a
                                 peer may use waiting for packets to be delivered */
+  size_t maximumReassemblyData; /**< the maximum aggregate amount of buffer space
+                                   all peers may hold for partially received
+                                   fragmented messages */
+  size_t maximumPeerReassemblyData; /**< the same limit for a single peer */
+  size_t reassemblyData; /**< buffer space currently held for reassembly */
+  enet_uint32 streamingChannels[(ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT + 31) /
+                                32]; /**< channels whose reliable fragments are
+                                        delivered as they arrive, see
+                                        enet_host_stream_channel() */
+  enet_uint8 channelPriorities
+      [ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT]; /**< priority each channel of a new
+                                                peer starts with, see
+                                                enet_host_channel_priority() */
   enet_uint8 usingNewPacket; /**< the New and Improved! */
   enet_uint8 usingNewPacketForServer; /**< the New and Improved! */
+  enet_uint8 *receiveBatchData; /**< ring of MTU sized slots filled by one
+                                   batched receive */
+  ENetAddress receiveBatchAddresses[ENET_SOCKET_BATCH_MAXIMUM];
+  int receiveBatchLengths[ENET_SOCKET_BATCH_MAXIMUM];
+  size_t receiveBatchCount; /**< datagrams held in the receive ring */
+  size_t receiveBatchIndex; /**< next datagram of the receive ring to handle */
+  enet_uint8 *sendBatchData; /**< assembled datagrams waiting for one batched
+                                send, NULL when batching is unavailable */
+  ENetAddress sendBatchAddresses[ENET_SOCKET_BATCH_MAXIMUM];
+  ENetBuffer sendBatchBuffers[ENET_SOCKET_BATCH_MAXIMUM];
+  size_t sendBatchCount;
+  enet_uint32 offloadFlags; /**< ENET_HOST_OFFLOAD_* modes currently active */
+  enet_uint8 *receiveSegmentData; /**< coalesced receive buffer, allocated when
+                                     GRO is first enabled */
+  size_t receiveSegmentSize;   /**< segment stride of the receive ring, 0 when
+                                  it holds separate datagrams */
+  size_t receiveSegmentLength; /**< total bytes of the coalesced receive */
+  ENetPool outgoingCommandPool; /**< ENetOutgoingCommand, including fragments */
+  ENetPool acknowledgementPool; /**< ENetAcknowledgement */
+  ENetPool incomingCommandPool; /**< ENetIncomingCommand */
+  ENetPool fragmentBitmapPool;  /**< incoming fragment bitmaps of up to
+                                   ENET_HOST_POOL_FRAGMENT_COUNT fragments */
+  ENetPeer **peerHashBuckets; /**< peers that are not disconnected, keyed by
+                                 remote host address */
+  size_t peerHashMask;        /**< bucket count minus one, a power of two */
+  ENetPeer *freePeers;        /**< FIFO of disconnected peer slots */
+  ENetPeer *lastFreePeer;
+  ENetPeer **throttlePeers; /**< scratch array of peerCount entries for
+                               bandwidth recalculation */
+  ENetPeer *activePeers; /**< peers whose slot is taken, whatever their state */
+  ENetPeer *dirtyPeers;  /**< peers with queued acknowledgements or outgoing
+                            commands */
+  ENetTimerWheel timerWheel; /**< peer deadlines; servicing only visits peers
+                                that are dirty or whose deadline passed */
+  ENetHistogram *histograms; /**< ENET_INSTRUMENT_STAGE_COUNT latency
+                                histograms, NULL unless enabled with
+                                enet_host_instrument() */
 } ENetHost;
 
 /**
@@ -458,7 +605,16 @@ typedef enum _ENetEventType {
    * the packet that was received; this packet must be destroyed with
    * enet_packet_destroy after use.
    */
-  ENET_EVENT_TYPE_RECEIVE = 3
+  ENET_EVENT_TYPE_RECEIVE = 3,
+
+  /** a fragment of a reliable message has been received on a streaming
+   * channel. Fragments of a message arrive in order and, like ordinary
+   * receives, in order with the rest of the channel. The packet field holds
+   * only this fragment and must be destroyed with enet_packet_destroy after
+   * use. The data field contains the byte offset of the fragment within its
+   * message, and the final fragment carries ENET_PACKET_FLAG_LAST_CHUNK.
+   */
+  ENET_EVENT_TYPE_RECEIVE_CHUNK = 4
 } ENetEventType;
 
 /**
@@ -524,14 +680,25 @@ ENET_API ENetVersion enet_linked_version(void);
 /** @defgroup private ENet private implementation functions */
 
 /**
-  Returns the wall-time in milliseconds.  Its initial value is unspecified
-  unless otherwise set.
+  Returns a monotonic time in milliseconds.  Its initial value is unspecified
+  unless otherwise set; it is not affected by wall-clock adjustments.
   */
 ENET_API enet_uint32 enet_time_get(void);
 /**
-  Sets the current wall-time in milliseconds.
+  Sets the current time in milliseconds.
   */
 ENET_API void enet_time_set(enet_uint32);
+/**
+  Returns a monotonic time in nanoseconds for measuring intervals.  Its origin
+  is unspecified, but it is the same clock as enet_time_get(), which is
+  enet_time_from_ns(enet_time_get_ns()).
+  */
+ENET_API enet_uint64 enet_time_get_ns(void);
+/**
+  Converts an enet_time_get_ns() reading to the milliseconds enet_time_get()
+  would have returned at that moment, including the enet_time_set() offset.
+  */
+ENET_API enet_uint32 enet_time_from_ns(enet_uint64);
 
 /** @defgroup socket ENet socket functions
     @{
@@ -546,6 +713,39 @@ ENET_API int enet_socket_send(ENetSocket, const ENetAddress *,
                               const ENetBuffer *, size_t);
 ENET_API int enet_socket_receive(ENetSocket, ENetAddress *, ENetBuffer *,
                                  size_t);
+/**
+  Sends one datagram per entry of buffers to the matching entry of addresses,
+  using a single sendmmsg where available.
+  @returns the number of datagrams handed to the socket, or -1 on error
+  */
+ENET_API int enet_socket_send_batch(ENetSocket, const ENetAddress *,
+                                    const ENetBuffer *, size_t);
+/**
+  Receives up to the given count of datagrams, one per entry of buffers,
+  using a single recvmmsg where available. Each length is written to the
+  matching int, or -2 if that datagram was truncated.
+  @returns the number of datagrams received, 0 if none were waiting, or -1 on
+  error
+  */
+ENET_API int enet_socket_receive_batch(ENetSocket, ENetAddress *, ENetBuffer *,
+                                       int *, size_t);
+/**
+  Sends the concatenated buffers as one write that the kernel splits into
+  datagrams of the given segment size; only the last may be shorter.
+  @returns the number of bytes sent, 0 if the socket would block, -2 if the
+  kernel or device rejected segmentation offload, or -1 on error
+  */
+ENET_API int enet_socket_send_segments(ENetSocket, const ENetAddress *,
+                                       const ENetBuffer *, size_t, size_t);
+/**
+  Receives a datagram that may hold several coalesced datagrams when
+  ENET_SOCKOPT_UDP_GRO is enabled; the size of each is written to the
+  segment size, the last may be shorter.
+  @returns the number of bytes received, 0 if none were waiting, -2 if the
+  data was truncated, or -1 on error
+  */
+ENET_API int enet_socket_receive_segments(ENetSocket, ENetAddress *,
+                                          ENetBuffer *, size_t *);
 ENET_API int enet_socket_wait(ENetSocket, enet_uint32 *, enet_uint32);
 ENET_API int enet_socket_set_option(ENetSocket, ENetSocketOption, int);
 ENET_API int enet_socket_get_option(ENetSocket, ENetSocketOption, int *);
@@ -666,25 +866,53 @@ ENET_API enet_uint32 enet_crc32(const ENetBuffer *, size_t);
 
 ENET_API ENetHost *enet_host_create(ENetAddressType type, const ENetAddress *,
                                     size_t, size_t, enet_uint32, enet_uint32);
+ENET_API ENetHost *enet_host_create_with_flags(ENetAddressType type,
+                                               const ENetAddress *, size_t,
+                                               size_t, enet_uint32, enet_uint32,
+                                               enet_uint32);
 ENET_API void enet_host_destroy(ENetHost *);
 ENET_API ENetPeer *enet_host_connect(ENetHost *, const ENetAddress *, size_t,
                                      enet_uint32);
 ENET_API int enet_host_check_events(ENetHost *, ENetEvent *);
+ENET_API int enet_host_inject(ENetHost *, const ENetAddress *, const void *,
+                             size_t, ENetEvent *);
 ENET_API int enet_host_service(ENetHost *, ENetEvent *, enet_uint32);
+ENET_API int enet_host_receive(ENetHost *, ENetEvent *);
 ENET_API void enet_host_flush(ENetHost *);
+ENET_API int enet_host_transmit(ENetHost *);
+ENET_API int enet_host_next_timeout(ENetHost *, enet_uint32 *);
+ENET_API enet_uint32 enet_host_offload(ENetHost *, enet_uint32);
 ENET_API void enet_host_broadcast(ENetHost *, enet_uint8, ENetPacket *);
 ENET_API void enet_host_compress(ENetHost *, const ENetCompressor *);
 ENET_API int enet_host_compress_with_range_coder(ENetHost *host);
+ENET_API int enet_host_compress_with_lz4(ENetHost *host, const void *dictionary,
+                                         size_t dictionaryLength);
 ENET_API void enet_host_channel_limit(ENetHost *, size_t);
 ENET_API void enet_host_bandwidth_limit(ENetHost *, enet_uint32, enet_uint32);
+ENET_API void enet_host_bandwidth_throttle_interval(ENetHost *, enet_uint32);
+ENET_API int enet_host_instrument(ENetHost *, int);
+ENET_API void enet_host_stream_channel(ENetHost *, enet_uint8, int);
+ENET_API void enet_host_channel_priority(ENetHost *, enet_uint8, enet_uint8);
+ENET_API void enet_host_set_clock(ENetHost *, ENetClockCallback);
 extern void enet_host_bandwidth_throttle(ENetHost *);
+extern enet_uint32 enet_host_time(ENetHost *);
 extern enet_uint32 enet_host_random_seed(void);
 extern enet_uint32 enet_host_random(ENetHost *);
+extern ENetPeer *enet_host_peer_bucket(ENetHost *, const ENetAddress *);
+extern void enet_host_index_peer(ENetHost *, ENetPeer *);
+extern void enet_host_unindex_peer(ENetHost *, ENetPeer *);
+extern ENetPeer *enet_host_acquire_peer(ENetHost *);
+extern void enet_host_release_peer(ENetHost *, ENetPeer *);
+extern void enet_host_mark_peer_dirty(ENetHost *, ENetPeer *);
+extern void enet_host_update_peer_dirty(ENetHost *, ENetPeer *);
+extern void enet_host_schedule_peer(ENetHost *, ENetPeer *);
+extern void enet_host_expire_peers(ENetHost *);
 
 ENET_API int enet_peer_send(ENetPeer *, enet_uint8, ENetPacket *);
 ENET_API ENetPacket *enet_peer_receive(ENetPeer *, enet_uint8 *channelID);
 ENET_API void enet_peer_ping(ENetPeer *);
 ENET_API void enet_peer_ping_interval(ENetPeer *, enet_uint32);
+ENET_API void enet_peer_channel_priority(ENetPeer *, enet_uint8, enet_uint8);
 ENET_API void enet_peer_timeout(ENetPeer *, enet_uint32, enet_uint32,
                                 enet_uint32);
 ENET_API void enet_peer_reset(ENetPeer *);
@@ -711,6 +939,7 @@ enet_peer_dispatch_incoming_unreliable_commands(ENetPeer *, ENetChannel *,
 extern void
 enet_peer_dispatch_incoming_reliable_commands(ENetPeer *, ENetChannel *,
                                               ENetIncomingCommand *);
+extern void enet_peer_release_reassembly(ENetPeer *, ENetIncomingCommand *);
 extern void enet_peer_on_connect(ENetPeer *);
 extern void enet_peer_on_disconnect(ENetPeer *);
 
@@ -721,6 +950,17 @@ ENET_API size_t enet_range_coder_compress(void *, const ENetBuffer *, size_t,
 ENET_API size_t enet_range_coder_decompress(void *, const enet_uint8 *, size_t,
                                             enet_uint8 *, size_t);
 
+ENET_API void enet_histogram_record(ENetHistogram *, enet_uint64);
+ENET_API void enet_histogram_reset(ENetHistogram *);
+ENET_API enet_uint64 enet_histogram_percentile(const ENetHistogram *, double);
+
+ENET_API void *enet_lz4_create(const void *, size_t);
+ENET_API void enet_lz4_destroy(void *);
+ENET_API size_t enet_lz4_compress(void *, const ENetBuffer *, size_t, size_t,
+                                  enet_uint8 *, size_t);
+ENET_API size_t enet_lz4_decompress(void *, const enet_uint8 *, size_t,
+                                    enet_uint8 *, size_t);
+
 extern size_t enet_protocol_command_size(enet_uint8);
 
 #ifdef __cplusplus
@@ -0,0 +1,55 @@
+/** 
+ @file  instrument.h
+ @brief ENet latency histograms for the service pipeline
+*/
+#ifndef __ENET_INSTRUMENT_H__
+#define __ENET_INSTRUMENT_H__
+
+#include "enet/types.h"
+
+typedef enum _ENetInstrumentStage
+{
+   ENET_INSTRUMENT_STAGE_SOCKET_RECEIVE = 0, /**< one receive system call */
+   ENET_INSTRUMENT_STAGE_PROTOCOL       = 1, /**< handling the commands of one datagram */
+   ENET_INSTRUMENT_STAGE_DISPATCH       = 2, /**< producing one event from the dispatch queue */
+   ENET_INSTRUMENT_STAGE_CONVERSION     = 3, /**< turning one event into a binding's own representation */
+   ENET_INSTRUMENT_STAGE_QUEUE_TO_WIRE  = 4, /**< from queuing an outgoing command to its first transmission */
+   ENET_INSTRUMENT_STAGE_COUNT          = 5
+} ENetInstrumentStage;
+
+enum
+{
+   ENET_HISTOGRAM_SUB_BUCKET_BITS = 4,
+   ENET_HISTOGRAM_SUB_BUCKETS     = 1 << ENET_HISTOGRAM_SUB_BUCKET_BITS,
+   ENET_HISTOGRAM_MAXIMUM_BITS    = 40,
+   ENET_HISTOGRAM_BUCKET_COUNT    = (ENET_HISTOGRAM_MAXIMUM_BITS - ENET_HISTOGRAM_SUB_BUCKET_BITS + 2) * ENET_HISTOGRAM_SUB_BUCKETS
+};
+
+/** A log-linear histogram of nanosecond durations: each power of two is split into
+    ENET_HISTOGRAM_SUB_BUCKETS buckets, bounding the error of any percentile to 1/16th.
+*/
+typedef struct _ENetHistogram
+{
+   enet_uint64 count;
+   enet_uint64 total;
+   enet_uint64 minimum;
+   enet_uint64 maximum;
+   enet_uint64 buckets [ENET_HISTOGRAM_BUCKET_COUNT];
+} ENetHistogram;
+
+/* recording compiles away entirely unless the library is built with ENET_INSTRUMENT,
+   and costs one branch per site while a host has it switched off */
+#ifdef ENET_INSTRUMENT
+#define ENET_INSTRUMENT_NOW(host) ((host) -> histograms != NULL ? enet_time_get_ns () : 0)
+#define ENET_INSTRUMENT_BEGIN(host, start) enet_uint64 start = ENET_INSTRUMENT_NOW (host)
+#define ENET_INSTRUMENT_RECORD(host, stage, value) \
+    do { if ((host) -> histograms != NULL) enet_histogram_record (& (host) -> histograms [stage], value); } while (0)
+#define ENET_INSTRUMENT_END(host, stage, start) \
+    do { if ((host) -> histograms != NULL) enet_histogram_record (& (host) -> histograms [stage], enet_time_get_ns () - (start)); } while (0)
+#else
+#define ENET_INSTRUMENT_BEGIN(host, start)
+#define ENET_INSTRUMENT_RECORD(host, stage, value)
+#define ENET_INSTRUMENT_END(host, stage, start)
+#endif
+
+#endif /* __ENET_INSTRUMENT_H__ */
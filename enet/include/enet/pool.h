@@ -0,0 +1,36 @@
+/** 
+ @file  pool.h
+ @brief ENet fixed size object pools
+*/
+#ifndef __ENET_POOL_H__
+#define __ENET_POOL_H__
+
+#include <stdlib.h>
+
+typedef struct _ENetPool
+{
+   void * freeList;
+   size_t objectSize;
+   size_t freeCount;   /**< objects cached on the free list */
+   size_t inUse;       /**< objects currently handed out */
+   size_t peakInUse;   /**< highest inUse seen since the pool was created */
+   size_t allocations; /**< objects obtained from enet_malloc */
+   size_t reuses;      /**< acquisitions served from the free list */
+} ENetPool;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern void enet_pool_init (ENetPool *, size_t);
+extern void enet_pool_destroy (ENetPool *);
+
+extern void * enet_pool_acquire (ENetPool *);
+extern void enet_pool_release (ENetPool *, void *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ENET_POOL_H__ */
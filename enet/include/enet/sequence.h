@@ -0,0 +1,46 @@
+/**
+ @file  sequence.h
+ @brief ENet reliable sequence number index
+*/
+#ifndef __ENET_SEQUENCE_H__
+#define __ENET_SEQUENCE_H__
+
+#include <stdlib.h>
+#include "enet/types.h"
+
+#define ENET_SEQUENCE_INDEX_MINIMUM_SIZE 16
+
+typedef struct _ENetSequenceSlot
+{
+   void * item;
+   enet_uint16 sequenceNumber;
+} ENetSequenceSlot;
+
+/** Open addressed table of slots, probed linearly from sequenceNumber % size.
+    It doubles only once it is half full, so its size follows the number of
+    items filed rather than the spread of their sequence numbers. Slots are
+    allocated on the first insert and kept until the index is destroyed.
+*/
+typedef struct _ENetSequenceIndex
+{
+   ENetSequenceSlot * slots;
+   size_t size;          /**< slot count, a power of two, or 0 before the first insert */
+   size_t count;         /**< items in the index */
+} ENetSequenceIndex;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern void enet_sequence_index_init (ENetSequenceIndex *);
+extern void enet_sequence_index_destroy (ENetSequenceIndex *);
+extern int enet_sequence_index_insert (ENetSequenceIndex *, enet_uint16, void *);
+extern void enet_sequence_index_remove (ENetSequenceIndex *, enet_uint16);
+extern void * enet_sequence_index_find (const ENetSequenceIndex *, enet_uint16);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ENET_SEQUENCE_H__ */
@@ -0,0 +1,54 @@
+/** 
+ @file  timer.h
+ @brief ENet hierarchical timer wheel
+*/
+#ifndef __ENET_TIMER_H__
+#define __ENET_TIMER_H__
+
+#include <stdlib.h>
+#include "enet/list.h"
+#include "enet/types.h"
+
+#define ENET_TIMER_WHEEL_BITS   8
+#define ENET_TIMER_WHEEL_SLOTS  (1 << ENET_TIMER_WHEEL_BITS)
+#define ENET_TIMER_WHEEL_LEVELS 3
+
+/** slot value of a timer that is not filed in any wheel */
+#define ENET_TIMER_UNSCHEDULED 0xFFFF
+
+typedef struct _ENetTimer
+{
+   ENetListNode node;
+   enet_uint32 deadline;
+   enet_uint16 slot;     /**< level * ENET_TIMER_WHEEL_SLOTS + index, or ENET_TIMER_UNSCHEDULED */
+} ENetTimer;
+
+/** Millisecond timer wheel: level 0 resolves single milliseconds, each level
+    above covers ENET_TIMER_WHEEL_SLOTS times the span of the one below and is
+    cascaded down as time reaches it. Deadlines beyond the top level are parked
+    in its furthest slot and filed again when that slot cascades.
+*/
+typedef struct _ENetTimerWheel
+{
+   enet_uint32 current;  /**< first millisecond whose level 0 slot has not expired yet */
+   size_t count;         /**< timers filed in the wheel */
+   enet_uint32 occupied [ENET_TIMER_WHEEL_LEVELS] [ENET_TIMER_WHEEL_SLOTS / 32];
+   ENetList slots [ENET_TIMER_WHEEL_LEVELS] [ENET_TIMER_WHEEL_SLOTS];
+} ENetTimerWheel;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern void enet_timer_wheel_init (ENetTimerWheel *, enet_uint32);
+extern void enet_timer_schedule (ENetTimerWheel *, ENetTimer *, enet_uint32);
+extern void enet_timer_cancel (ENetTimerWheel *, ENetTimer *);
+extern void enet_timer_wheel_expire (ENetTimerWheel *, enet_uint32, ENetList *);
+extern int enet_timer_wheel_next (const ENetTimerWheel *, enet_uint32 *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ENET_TIMER_H__ */
@@ -17,6 +17,10 @@
 #define ENET_BUFFER_MAXIMUM MSG_MAXIOVLEN
 #endif
 
+#if (defined(linux) || defined(__linux) || defined(__linux__)) && !defined(ENET_SOCKET_BATCH_MAXIMUM)
+#define ENET_SOCKET_BATCH_MAXIMUM 32 /**< datagrams moved per recvmmsg/sendmmsg call */
+#endif
+
 typedef int ENetSocket;
 
 #define ENET_SOCKET_NULL -1
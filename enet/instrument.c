@@ -0,0 +1,151 @@
+/** 
+ @file instrument.c
+ @brief ENet latency histograms for the service pipeline
+*/
+#define ENET_BUILDING_LIB 1
+#include <string.h>
+#include "enet/enet.h"
+
+static size_t
+enet_histogram_bucket (enet_uint64 value)
+{
+    int bits = 0;
+
+    if (value < ENET_HISTOGRAM_SUB_BUCKETS)
+      return (size_t) value;
+
+    if (value >> ENET_HISTOGRAM_MAXIMUM_BITS)
+      return ENET_HISTOGRAM_BUCKET_COUNT - 1;
+
+    while (value >> (bits + 1))
+      ++ bits;
+
+    return (size_t) (bits - ENET_HISTOGRAM_SUB_BUCKET_BITS + 1) * ENET_HISTOGRAM_SUB_BUCKETS +
+             (size_t) ((value >> (bits - ENET_HISTOGRAM_SUB_BUCKET_BITS)) & (ENET_HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+/* smallest value counted by a bucket */
+static enet_uint64
+enet_histogram_bucket_base (size_t bucket)
+{
+    size_t bits, sub;
+
+    if (bucket < ENET_HISTOGRAM_SUB_BUCKETS)
+      return (enet_uint64) bucket;
+
+    bits = bucket / ENET_HISTOGRAM_SUB_BUCKETS + ENET_HISTOGRAM_SUB_BUCKET_BITS - 1;
+    sub = bucket % ENET_HISTOGRAM_SUB_BUCKETS;
+
+    return (enet_uint64) (ENET_HISTOGRAM_SUB_BUCKETS + sub) << (bits - ENET_HISTOGRAM_SUB_BUCKET_BITS);
+}
+
+void
+enet_histogram_record (ENetHistogram * histogram, enet_uint64 value)
+{
+    ++ histogram -> buckets [enet_histogram_bucket (value)];
+
+    if (histogram -> count == 0 || value < histogram -> minimum)
+      histogram -> minimum = value;
+    if (value > histogram -> maximum)
+      histogram -> maximum = value;
+
+    ++ histogram -> count;
+    histogram -> total += value;
+}
+
+void
+enet_histogram_reset (ENetHistogram * histogram)
+{
+    memset (histogram, 0, sizeof (ENetHistogram));
+}
+
+/** Estimates a percentile of the recorded values.
+    @param histogram histogram to query
+    @param percentile percentile between 0 and 100
+    @returns the midpoint of the bucket holding the percentile, clamped to the
+    recorded range, or 0 if nothing was recorded
+*/
+enet_uint64
+enet_histogram_percentile (const ENetHistogram * histogram, double percentile)
+{
+    enet_uint64 rank, seen = 0, value;
+    size_t bucket;
+
+    if (histogram -> count == 0)
+      return 0;
+
+    if (percentile <= 0.0)
+      return histogram -> minimum;
+    if (percentile >= 100.0)
+      return histogram -> maximum;
+
+    rank = (enet_uint64) (percentile / 100.0 * (double) histogram -> count + 0.5);
+    if (rank < 1)
+      rank = 1;
+
+    for (bucket = 0; bucket < ENET_HISTOGRAM_BUCKET_COUNT; ++ bucket)
+    {
+        seen += histogram -> buckets [bucket];
+        if (seen >= rank)
+          break;
+    }
+
+    if (bucket >= ENET_HISTOGRAM_BUCKET_COUNT - 1)
+      return histogram -> maximum;
+
+    value = enet_histogram_bucket_base (bucket);
+    value += (enet_histogram_bucket_base (bucket + 1) - value) / 2;
+
+    if (value < histogram -> minimum)
+      value = histogram -> minimum;
+    if (value > histogram -> maximum)
+      value = histogram -> maximum;
+
+    return value;
+}
+
+/** @defgroup host ENet host functions
+    @{
+*/
+
+/** Starts or stops recording latency histograms for the host's service pipeline.
+    Enabling an already instrumented host clears its histograms.
+    @param host host to instrument
+    @param enable nonzero to record, zero to stop and release the histograms
+    @returns 0 on success, < 0 if the library was built without ENET_INSTRUMENT or memory ran out
+*/
+int
+enet_host_instrument (ENetHost * host, int enable)
+{
+#ifdef ENET_INSTRUMENT
+    size_t stage;
+
+    if (! enable)
+    {
+        if (host -> histograms != NULL)
+        {
+            enet_free (host -> histograms);
+            host -> histograms = NULL;
+        }
+        return 0;
+    }
+
+    if (host -> histograms == NULL)
+    {
+        host -> histograms = (ENetHistogram *) enet_malloc (ENET_INSTRUMENT_STAGE_COUNT * sizeof (ENetHistogram));
+        if (host -> histograms == NULL)
+          return -1;
+    }
+
+    for (stage = 0; stage < ENET_INSTRUMENT_STAGE_COUNT; ++ stage)
+      enet_histogram_reset (& host -> histograms [stage]);
+
+    return 0;
+#else
+    (void) host;
+
+    return enable ? -1 : 0;
+#endif
+}
+
+/** @} */
@@ -0,0 +1,298 @@
+/**
+ @file lz4.c
+ @brief An LZ4 block format packet compressor with optional preset dictionary
+*/
+#define ENET_BUILDING_LIB 1
+#include <string.h>
+#include "enet/enet.h"
+
+/* block format constants; see the LZ4 block format description, the output is
+   decodable by LZ4_decompress_safe_usingDict () given the same dictionary */
+enum
+{
+    ENET_LZ4_HASH_LOG       = 12,
+    ENET_LZ4_HASH_SIZE      = 1 << ENET_LZ4_HASH_LOG,
+    ENET_LZ4_MINIMUM_MATCH  = 4,
+    ENET_LZ4_LAST_LITERALS  = 5,
+    ENET_LZ4_MATCH_LIMIT    = 12,
+    ENET_LZ4_MAXIMUM_OFFSET = 65535,
+    ENET_LZ4_RUN_MASK       = 15
+};
+
+typedef struct _ENetLZ4
+{
+    size_t dictionaryLength;
+    /* hash table over the dictionary alone, restored before each packet */
+    enet_uint16 dictionaryTable [ENET_LZ4_HASH_SIZE];
+    enet_uint16 table [ENET_LZ4_HASH_SIZE];
+    /* dictionary followed by the packet being compressed, so matches may reach back into the dictionary */
+    enet_uint8 window [ENET_LZ4_DICTIONARY_MAXIMUM + ENET_PROTOCOL_MAXIMUM_MTU];
+} ENetLZ4;
+
+static enet_uint32
+enet_lz4_read32 (const enet_uint8 * data)
+{
+    enet_uint32 value;
+    memcpy (& value, data, sizeof (value));
+    return value;
+}
+
+static enet_uint32
+enet_lz4_hash (enet_uint32 sequence)
+{
+    return (sequence * 2654435761U) >> (32 - ENET_LZ4_HASH_LOG);
+}
+
+/** Creates an LZ4 compressor context.
+    @param dictionary optional preset dictionary shared by both ends, or NULL
+    @param dictionaryLength length of the dictionary; only the last ENET_LZ4_DICTIONARY_MAXIMUM bytes are used
+    @returns the context, or NULL on failure
+*/
+void *
+enet_lz4_create (const void * dictionary, size_t dictionaryLength)
+{
+    ENetLZ4 * lz4 = (ENetLZ4 *) enet_malloc (sizeof (ENetLZ4));
+    size_t position;
+
+    if (lz4 == NULL)
+      return NULL;
+
+    if (dictionary == NULL)
+      dictionaryLength = 0;
+    else
+    if (dictionaryLength > ENET_LZ4_DICTIONARY_MAXIMUM)
+    {
+        dictionary = (const enet_uint8 *) dictionary + dictionaryLength - ENET_LZ4_DICTIONARY_MAXIMUM;
+        dictionaryLength = ENET_LZ4_DICTIONARY_MAXIMUM;
+    }
+
+    lz4 -> dictionaryLength = dictionaryLength;
+    memset (lz4 -> dictionaryTable, 0, sizeof (lz4 -> dictionaryTable));
+    if (dictionaryLength > 0)
+      memcpy (lz4 -> window, dictionary, dictionaryLength);
+
+    /* table entries hold position + 1 so that zero marks an empty slot */
+    for (position = 0; position + ENET_LZ4_MINIMUM_MATCH <= dictionaryLength; ++ position)
+      lz4 -> dictionaryTable [enet_lz4_hash (enet_lz4_read32 (& lz4 -> window [position]))] = (enet_uint16) (position + 1);
+
+    return lz4;
+}
+
+void
+enet_lz4_destroy (void * context)
+{
+    if (context != NULL)
+      enet_free (context);
+}
+
+static enet_uint8 *
+enet_lz4_output_length (enet_uint8 * outData, size_t length)
+{
+    for (; length >= 255; length -= 255)
+      * outData ++ = 255;
+    * outData ++ = (enet_uint8) length;
+    return outData;
+}
+
+/* worst case bytes needed for a sequence's literals, token, offset and match length */
+#define ENET_LZ4_SEQUENCE_BOUND(literals, match) (1 + (literals) / 255 + 1 + (literals) + 2 + (match) / 255 + 1)
+
+size_t
+enet_lz4_compress (void * context, const ENetBuffer * inBuffers, size_t inBufferCount, size_t inLimit, enet_uint8 * outData, size_t outLimit)
+{
+    ENetLZ4 * lz4 = (ENetLZ4 *) context;
+    enet_uint8 * outStart = outData, * outEnd = & outData [outLimit];
+    const enet_uint8 * window = lz4 -> window;
+    size_t input = lz4 -> dictionaryLength, end, anchor, matchStart, matchLimit, literals;
+
+    if (inLimit <= 0 || inLimit > ENET_PROTOCOL_MAXIMUM_MTU)
+      return 0;
+
+    end = input;
+    while (inBufferCount -- > 0)
+    {
+        if (end + inBuffers -> dataLength > input + inLimit)
+          return 0;
+        memcpy (& lz4 -> window [end], inBuffers -> data, inBuffers -> dataLength);
+        end += inBuffers -> dataLength;
+        ++ inBuffers;
+    }
+
+    anchor = input;
+    if (end - input > ENET_LZ4_MATCH_LIMIT)
+    {
+        memcpy (lz4 -> table, lz4 -> dictionaryTable, sizeof (lz4 -> table));
+
+        matchStart = end - ENET_LZ4_MATCH_LIMIT;
+        matchLimit = end - ENET_LZ4_LAST_LITERALS;
+
+        while (input < matchStart)
+        {
+            enet_uint32 sequence = enet_lz4_read32 (& window [input]),
+                        hash = enet_lz4_hash (sequence);
+            size_t candidate = lz4 -> table [hash], length;
+
+            lz4 -> table [hash] = (enet_uint16) (input + 1);
+            /* entries left over from earlier packets may point past the current position */
+            if (candidate == 0 ||
+                (-- candidate) >= input ||
+                input - candidate > ENET_LZ4_MAXIMUM_OFFSET ||
+                enet_lz4_read32 (& window [candidate]) != sequence)
+            {
+                ++ input;
+                continue;
+            }
+
+            while (input > anchor && candidate > 0 && window [input - 1] == window [candidate - 1])
+            {
+                -- input;
+                -- candidate;
+            }
+
+            length = ENET_LZ4_MINIMUM_MATCH;
+            while (input + length < matchLimit && window [input + length] == window [candidate + length])
+              ++ length;
+
+            literals = input - anchor;
+            if (ENET_LZ4_SEQUENCE_BOUND (literals, length) > (size_t) (outEnd - outData))
+              return 0;
+
+            * outData = (enet_uint8) ((literals >= ENET_LZ4_RUN_MASK ? ENET_LZ4_RUN_MASK : literals) << 4);
+            * outData |= (enet_uint8) (length - ENET_LZ4_MINIMUM_MATCH >= ENET_LZ4_RUN_MASK ? ENET_LZ4_RUN_MASK : length - ENET_LZ4_MINIMUM_MATCH);
+            ++ outData;
+            if (literals >= ENET_LZ4_RUN_MASK)
+              outData = enet_lz4_output_length (outData, literals - ENET_LZ4_RUN_MASK);
+            memcpy (outData, & window [anchor], literals);
+            outData += literals;
+
+            * outData ++ = (enet_uint8) ((input - candidate) & 0xFF);
+            * outData ++ = (enet_uint8) ((input - candidate) >> 8);
+            if (length - ENET_LZ4_MINIMUM_MATCH >= ENET_LZ4_RUN_MASK)
+              outData = enet_lz4_output_length (outData, length - ENET_LZ4_MINIMUM_MATCH - ENET_LZ4_RUN_MASK);
+
+            input += length;
+            anchor = input;
+
+            if (input - 2 < matchStart)
+              lz4 -> table [enet_lz4_hash (enet_lz4_read32 (& window [input - 2]))] = (enet_uint16) (input - 1);
+        }
+    }
+
+    literals = end - anchor;
+    if (1 + literals / 255 + 1 + literals > (size_t) (outEnd - outData))
+      return 0;
+
+    * outData ++ = (enet_uint8) ((literals >= ENET_LZ4_RUN_MASK ? ENET_LZ4_RUN_MASK : literals) << 4);
+    if (literals >= ENET_LZ4_RUN_MASK)
+      outData = enet_lz4_output_length (outData, literals - ENET_LZ4_RUN_MASK);
+    memcpy (outData, & window [anchor], literals);
+    outData += literals;
+
+    return (size_t) (outData - outStart);
+}
+
+static int
+enet_lz4_input_length (const enet_uint8 * * inData, const enet_uint8 * inEnd, size_t * length)
+{
+    enet_uint8 byte;
+    do
+    {
+        if (* inData >= inEnd)
+          return -1;
+        byte = * (* inData) ++;
+        * length += byte;
+    } while (byte == 255);
+    return 0;
+}
+
+size_t
+enet_lz4_decompress (void * context, const enet_uint8 * inData, size_t inLimit, enet_uint8 * outData, size_t outLimit)
+{
+    ENetLZ4 * lz4 = (ENetLZ4 *) context;
+    const enet_uint8 * inEnd = & inData [inLimit],
+                     * dictionaryEnd = & lz4 -> window [lz4 -> dictionaryLength];
+    enet_uint8 * outStart = outData, * outEnd = & outData [outLimit];
+
+    while (inData < inEnd)
+    {
+        enet_uint8 token = * inData ++;
+        size_t literals = token >> 4, length = token & ENET_LZ4_RUN_MASK, offset, produced;
+
+        if (literals == ENET_LZ4_RUN_MASK && enet_lz4_input_length (& inData, inEnd, & literals) < 0)
+          return 0;
+        if (literals > (size_t) (inEnd - inData) || literals > (size_t) (outEnd - outData))
+          return 0;
+        memcpy (outData, inData, literals);
+        inData += literals;
+        outData += literals;
+
+        /* the final sequence carries literals only */
+        if (inData >= inEnd)
+          break;
+
+        if (inEnd - inData < 2)
+          return 0;
+        offset = inData [0] | (inData [1] << 8);
+        inData += 2;
+        if (length == ENET_LZ4_RUN_MASK && enet_lz4_input_length (& inData, inEnd, & length) < 0)
+          return 0;
+        length += ENET_LZ4_MINIMUM_MATCH;
+
+        produced = (size_t) (outData - outStart);
+        if (offset == 0 || offset > produced + lz4 -> dictionaryLength || length > (size_t) (outEnd - outData))
+          return 0;
+
+        if (offset > produced)
+        {
+            size_t fromDictionary = offset - produced;
+            if (fromDictionary > length)
+              fromDictionary = length;
+            memcpy (outData, dictionaryEnd - (offset - produced), fromDictionary);
+            outData += fromDictionary;
+            length -= fromDictionary;
+            offset = (size_t) (outData - outStart);
+        }
+
+        if (offset >= length)
+        {
+            memcpy (outData, outData - offset, length);
+            outData += length;
+        }
+        else
+        {
+            const enet_uint8 * match = outData - offset;
+            while (length -- > 0)
+              * outData ++ = * match ++;
+        }
+    }
+
+    return (size_t) (outData - outStart);
+}
+
+/** @defgroup host ENet host functions
+    @{
+*/
+
+/** Sets the packet compressor the host should use to the LZ4 block compressor.
+    Both ends of a connection must be set up with the same dictionary.
+    @param host host to enable LZ4 compression for
+    @param dictionary optional preset dictionary, or NULL
+    @param dictionaryLength length of the dictionary in bytes
+    @returns 0 on success, < 0 on failure
+*/
+int
+enet_host_compress_with_lz4 (ENetHost * host, const void * dictionary, size_t dictionaryLength)
+{
+    ENetCompressor compressor;
+    memset (& compressor, 0, sizeof (compressor));
+    compressor.context = enet_lz4_create (dictionary, dictionaryLength);
+    if (compressor.context == NULL)
+      return -1;
+    compressor.compress = enet_lz4_compress;
+    compressor.decompress = enet_lz4_decompress;
+    compressor.destroy = enet_lz4_destroy;
+    enet_host_compress (host, & compressor);
+    return 0;
+}
+
+/** @} */
@@ -2,6 +2,7 @@
  @file  peer.c
  @brief ENet peer management functions
 */
+#include <assert.h>
 #include <string.h>
 #define ENET_BUILDING_LIB 1
 #include "enet/utility.h"
@@ -160,14 +161,14 @@ enet_peer_send (ENetPeer * peer, enet_uint8 channelID, ENetPacket * packet)
          if (packet -> dataLength - fragmentOffset < fragmentLength)
            fragmentLength = packet -> dataLength - fragmentOffset;
 
-         fragment = (ENetOutgoingCommand *) enet_malloc (sizeof (ENetOutgoingCommand));
+         fragment = (ENetOutgoingCommand *) enet_pool_acquire (& peer -> host -> outgoingCommandPool);
          if (fragment == NULL)
          {
             while (! enet_list_empty (& fragments))
             {
                fragment = (ENetOutgoingCommand *) enet_list_remove (enet_list_begin (& fragments));
                
-               enet_free (fragment);
+               enet_pool_release (& peer -> host -> outgoingCommandPool, fragment);
             }
             
             return -1;
@@ -225,6 +226,41 @@ enet_peer_send (ENetPeer * peer, enet_uint8 channelID, ENetPacket * packet)
    return 0;
 }
 
+static size_t
+enet_peer_reassembly_size (enet_uint32 totalLength, enet_uint32 fragmentCount)
+{
+    return totalLength + (fragmentCount + 31) / 32 * sizeof (enet_uint32);
+}
+
+/** Returns the reassembly budget held by a fragmented incoming command once
+    its last fragment has arrived, or when it is discarded unfinished.
+*/
+void
+enet_peer_release_reassembly (ENetPeer * peer, ENetIncomingCommand * incomingCommand)
+{
+    size_t size = enet_peer_reassembly_size (incomingCommand -> packet -> dataLength, incomingCommand -> fragmentCount);
+
+    /* charged with the same size when the command was queued */
+    assert (peer -> reassemblyData >= size && peer -> host -> reassemblyData >= size);
+
+    peer -> reassemblyData -= size;
+    peer -> host -> reassemblyData -= size;
+}
+
+static void
+enet_peer_free_incoming_command (ENetPeer * peer, ENetIncomingCommand * incomingCommand)
+{
+    if (incomingCommand -> fragments != NULL)
+    {
+       if (incomingCommand -> fragmentCount <= ENET_HOST_POOL_FRAGMENT_COUNT)
+         enet_pool_release (& peer -> host -> fragmentBitmapPool, incomingCommand -> fragments);
+       else
+         enet_free (incomingCommand -> fragments);
+    }
+
+    enet_pool_release (& peer -> host -> incomingCommandPool, incomingCommand);
+}
+
 /** Attempts to dequeue any incoming queued packet.
     @param peer peer to dequeue packets from
     @param channelID holds the channel ID of the channel the packet was received on success
@@ -248,10 +284,7 @@ enet_peer_receive (ENetPeer * peer, enet_uint8 * channelID)
 
    -- packet -> referenceCount;
 
-   if (incomingCommand -> fragments != NULL)
-     enet_free (incomingCommand -> fragments);
-
-   enet_free (incomingCommand);
+   enet_peer_free_incoming_command (peer, incomingCommand);
 
    peer -> totalWaitingData -= ENET_MIN (peer -> totalWaitingData, packet -> dataLength);
 
@@ -275,7 +308,7 @@ enet_peer_reset_outgoing_commands (ENetPeer * peer, ENetList * queue)
             enet_packet_destroy (outgoingCommand -> packet);
        }
 
-       enet_free (outgoingCommand);
+       enet_pool_release (& peer -> host -> outgoingCommandPool, outgoingCommand);
     }
 }
 
@@ -294,6 +327,9 @@ enet_peer_remove_incoming_commands (ENetPeer * peer, ENetList * queue, ENetListI
          continue;
 
        enet_list_remove (& incomingCommand -> incomingCommandList);
+
+       if (incomingCommand -> fragmentsRemaining > 0)
+         enet_peer_release_reassembly (peer, incomingCommand);
  
        if (incomingCommand -> packet != NULL)
        {
@@ -305,10 +341,7 @@ enet_peer_remove_incoming_commands (ENetPeer * peer, ENetList * queue, ENetListI
             enet_packet_destroy (incomingCommand -> packet);
        }
 
-       if (incomingCommand -> fragments != NULL)
-         enet_free (incomingCommand -> fragments);
-
-       enet_free (incomingCommand);
+       enet_peer_free_incoming_command (peer, incomingCommand);
     }
 }
 
@@ -331,13 +364,15 @@ enet_peer_reset_queues (ENetPeer * peer)
     }
 
     while (! enet_list_empty (& peer -> acknowledgements))
-      enet_free (enet_list_remove (enet_list_begin (& peer -> acknowledgements)));
+      enet_pool_release (& peer -> host -> acknowledgementPool, enet_list_remove (enet_list_begin (& peer -> acknowledgements)));
 
     enet_peer_reset_outgoing_commands (peer, & peer -> sentReliableCommands);
     enet_peer_reset_outgoing_commands (peer, & peer -> outgoingCommands);
     enet_peer_reset_outgoing_commands (peer, & peer -> outgoingSendReliableCommands);
     enet_peer_reset_incoming_commands (peer, & peer -> dispatchedCommands);
 
+    enet_sequence_index_destroy (& peer -> sentControlIndex);
+
     if (peer -> channels != NULL && peer -> channelCount > 0)
     {
         for (channel = peer -> channels;
@@ -346,6 +381,9 @@ enet_peer_reset_queues (ENetPeer * peer)
         {
             enet_peer_reset_incoming_commands (peer, & channel -> incomingReliableCommands);
             enet_peer_reset_incoming_commands (peer, & channel -> incomingUnreliableCommands);
+
+            enet_sequence_index_destroy (& channel -> incomingReliableIndex);
+            enet_sequence_index_destroy (& channel -> sentReliableIndex);
         }
 
         enet_free (peer -> channels);
@@ -383,12 +421,14 @@ enet_peer_on_disconnect (ENetPeer * peer)
     @param peer peer to forcefully disconnect
     @remarks The foreign host represented by the peer is not notified of the disconnection and will timeout
     on its connection to the local host.
+    @remarks The peer's generation is incremented, invalidating handles built from the previous one.
 */
 void
 enet_peer_reset (ENetPeer * peer)
 {
     enet_peer_on_disconnect (peer);
         
+    ++ peer -> generation;
     peer -> outgoingPeerID = ENET_PROTOCOL_MAXIMUM_PEER_ID;
     peer -> connectID = 0;
 
@@ -407,6 +447,11 @@ enet_peer_reset (ENetPeer * peer)
     peer -> packetLossEpoch = 0;
     peer -> packetsSent = 0;
     peer -> packetsLost = 0;
+    peer -> totalSentData = 0;
+    peer -> totalSentPackets = 0;
+    peer -> totalReceivedData = 0;
+    peer -> totalReceivedPackets = 0;
+    peer -> totalRetransmits = 0;
     peer -> packetLoss = 0;
     peer -> packetLossVariance = 0;
     peer -> packetThrottle = ENET_PEER_DEFAULT_PACKET_THROTTLE;
@@ -439,6 +484,9 @@ enet_peer_reset (ENetPeer * peer)
     memset (peer -> unsequencedWindow, 0, sizeof (peer -> unsequencedWindow));
     
     enet_peer_reset_queues (peer);
+
+    enet_host_unindex_peer (peer -> host, peer);
+    enet_host_release_peer (peer -> host, peer);
 }
 
 /** Sends a ping request to a peer.
@@ -475,6 +523,26 @@ void
 enet_peer_ping_interval (ENetPeer * peer, enet_uint32 pingInterval)
 {
     peer -> pingInterval = pingInterval ? pingInterval : ENET_PEER_PING_INTERVAL;
+
+    enet_host_schedule_peer (peer -> host, peer);
+}
+
+/** Sets the priority of one of a peer's channels.
+
+    Commands queued on the channel from now on are packed into datagrams ahead of those of
+    lower priority channels; see enet_host_channel_priority().
+
+    @param peer the peer to adjust
+    @param channelID the channel to adjust
+    @param priority the priority of the channel, 0 being lowest
+*/
+void
+enet_peer_channel_priority (ENetPeer * peer, enet_uint8 channelID, enet_uint8 priority)
+{
+    if (channelID >= peer -> channelCount)
+      return;
+
+    peer -> channels [channelID].priority = priority;
 }
 
 /** Sets the timeout parameters for a peer.
@@ -625,7 +693,7 @@ enet_peer_queue_acknowledgement (ENetPeer * peer, const ENetProtocol * command,
           return NULL;
     }
 
-    acknowledgement = (ENetAcknowledgement *) enet_malloc (sizeof (ENetAcknowledgement));
+    acknowledgement = (ENetAcknowledgement *) enet_pool_acquire (& peer -> host -> acknowledgementPool);
     if (acknowledgement == NULL)
       return NULL;
 
@@ -635,10 +703,32 @@ enet_peer_queue_acknowledgement (ENetPeer * peer, const ENetProtocol * command,
     acknowledgement -> command = * command;
     
     enet_list_insert (enet_list_end (& peer -> acknowledgements), acknowledgement);
+
+    enet_host_mark_peer_dirty (peer -> host, peer);
     
     return acknowledgement;
 }
 
+/* Outgoing queues are kept in priority order and in queue order within a
+   priority. Appending is the usual case; a command that outranks the tail is
+   placed after the commands of its own or higher priority, which are the ones
+   sent next anyway. */
+static void
+enet_peer_insert_outgoing_command (ENetList * queue, ENetOutgoingCommand * outgoingCommand)
+{
+    ENetListIterator position = enet_list_end (queue);
+
+    if (! enet_list_empty (queue) &&
+        ((ENetOutgoingCommand *) enet_list_back (queue)) -> priority < outgoingCommand -> priority)
+    {
+       position = enet_list_begin (queue);
+       while (((ENetOutgoingCommand *) position) -> priority >= outgoingCommand -> priority)
+         position = enet_list_next (position);
+    }
+
+    enet_list_insert (position, outgoingCommand);
+}
+
 void
 enet_peer_setup_outgoing_command (ENetPeer * peer, ENetOutgoingCommand * outgoingCommand)
 {
@@ -650,11 +740,14 @@ enet_peer_setup_outgoing_command (ENetPeer * peer, ENetOutgoingCommand * outgoin
 
        outgoingCommand -> reliableSequenceNumber = peer -> outgoingReliableSequenceNumber;
        outgoingCommand -> unreliableSequenceNumber = 0;
+       outgoingCommand -> priority = ENET_PEER_CONTROL_PRIORITY;
     }
     else
     {
         ENetChannel * channel = & peer -> channels [outgoingCommand -> command.header.channelID];
 
+        outgoingCommand -> priority = channel -> priority;
+
         if (outgoingCommand -> command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE)
         {
            ++ channel -> outgoingReliableSequenceNumber;
@@ -682,10 +775,14 @@ enet_peer_setup_outgoing_command (ENetPeer * peer, ENetOutgoingCommand * outgoin
     }
 
     outgoingCommand -> sendAttempts = 0;
+    outgoingCommand -> inFlight = 0;
     outgoingCommand -> sentTime = 0;
     outgoingCommand -> roundTripTimeout = 0;
     outgoingCommand -> command.header.reliableSequenceNumber = ENET_HOST_TO_NET_16 (outgoingCommand -> reliableSequenceNumber);
     outgoingCommand -> queueTime = ++ peer -> host -> totalQueued;
+#ifdef ENET_INSTRUMENT
+    outgoingCommand -> instrumentTime = ENET_INSTRUMENT_NOW (peer -> host);
+#endif
 
     switch (outgoingCommand -> command.header.command & ENET_PROTOCOL_COMMAND_MASK)
     {
@@ -703,15 +800,17 @@ enet_peer_setup_outgoing_command (ENetPeer * peer, ENetOutgoingCommand * outgoin
 
     if ((outgoingCommand -> command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) != 0 &&
         outgoingCommand -> packet != NULL)
-      enet_list_insert (enet_list_end (& peer -> outgoingSendReliableCommands), outgoingCommand);
+      enet_peer_insert_outgoing_command (& peer -> outgoingSendReliableCommands, outgoingCommand);
     else
-      enet_list_insert (enet_list_end (& peer -> outgoingCommands), outgoingCommand);
+      enet_peer_insert_outgoing_command (& peer -> outgoingCommands, outgoingCommand);
+
+    enet_host_mark_peer_dirty (peer -> host, peer);
 }
 
 ENetOutgoingCommand *
 enet_peer_queue_outgoing_command (ENetPeer * peer, const ENetProtocol * command, ENetPacket * packet, enet_uint32 offset, enet_uint16 length)
 {
-    ENetOutgoingCommand * outgoingCommand = (ENetOutgoingCommand *) enet_malloc (sizeof (ENetOutgoingCommand));
+    ENetOutgoingCommand * outgoingCommand = (ENetOutgoingCommand *) enet_pool_acquire (& peer -> host -> outgoingCommandPool);
     if (outgoingCommand == NULL)
       return NULL;
 
@@ -827,6 +926,8 @@ enet_peer_dispatch_incoming_reliable_commands (ENetPeer * peer, ENetChannel * ch
 
        channel -> incomingReliableSequenceNumber = incomingCommand -> reliableSequenceNumber;
 
+       enet_sequence_index_remove (& channel -> incomingReliableIndex, incomingCommand -> reliableSequenceNumber);
+
        if (incomingCommand -> fragmentCount > 0)
          channel -> incomingReliableSequenceNumber += incomingCommand -> fragmentCount - 1;
     } 
@@ -849,6 +950,54 @@ enet_peer_dispatch_incoming_reliable_commands (ENetPeer * peer, ENetChannel * ch
        enet_peer_dispatch_incoming_unreliable_commands (peer, channel, queuedCommand);
 }
 
+#define ENET_PEER_RELIABLE_PREDECESSOR_PROBES 32
+
+/* Returns the node a new reliable command is inserted after: the last queued
+   command when it arrives in order, otherwise the nearest earlier sequence
+   number still waiting. After a loss that is usually only a few numbers back,
+   so a few index probes find it; a wider gap falls back to walking the queue
+   from its end, which costs at most one step per queued command. */
+static ENetListIterator
+enet_peer_find_reliable_predecessor (ENetChannel * channel, enet_uint16 reliableSequenceNumber)
+{
+    ENetIncomingCommand * incomingCommand;
+    ENetListIterator currentCommand;
+    enet_uint16 sequenceNumber,
+                distance = reliableSequenceNumber - channel -> incomingReliableSequenceNumber;
+    int probes;
+
+    if (enet_list_empty (& channel -> incomingReliableCommands))
+      return enet_list_end (& channel -> incomingReliableCommands);
+
+    incomingCommand = (ENetIncomingCommand *) enet_list_back (& channel -> incomingReliableCommands);
+    if ((enet_uint16) (incomingCommand -> reliableSequenceNumber - channel -> incomingReliableSequenceNumber) < distance)
+      return & incomingCommand -> incomingCommandList;
+
+    for (sequenceNumber = reliableSequenceNumber - 1, probes = 0;
+         sequenceNumber != channel -> incomingReliableSequenceNumber && probes < ENET_PEER_RELIABLE_PREDECESSOR_PROBES;
+         -- sequenceNumber, ++ probes)
+    {
+       incomingCommand = (ENetIncomingCommand *) enet_sequence_index_find (& channel -> incomingReliableIndex, sequenceNumber);
+       if (incomingCommand != NULL)
+         return & incomingCommand -> incomingCommandList;
+    }
+
+    if (sequenceNumber == channel -> incomingReliableSequenceNumber)
+      return enet_list_end (& channel -> incomingReliableCommands);
+
+    for (currentCommand = enet_list_previous (enet_list_end (& channel -> incomingReliableCommands));
+         currentCommand != enet_list_end (& channel -> incomingReliableCommands);
+         currentCommand = enet_list_previous (currentCommand))
+    {
+       incomingCommand = (ENetIncomingCommand *) currentCommand;
+
+       if ((enet_uint16) (incomingCommand -> reliableSequenceNumber - channel -> incomingReliableSequenceNumber) < distance)
+         break;
+    }
+
+    return currentCommand;
+}
+
 ENetIncomingCommand *
 enet_peer_queue_incoming_command (ENetPeer * peer, const ENetProtocol * command, const void * data, size_t dataLength, enet_uint32 flags, enet_uint32 fragmentCount)
 {
@@ -881,32 +1030,11 @@ enet_peer_queue_incoming_command (ENetPeer * peer, const ENetProtocol * command,
     {
     case ENET_PROTOCOL_COMMAND_SEND_FRAGMENT:
     case ENET_PROTOCOL_COMMAND_SEND_RELIABLE:
-       if (reliableSequenceNumber == channel -> incomingReliableSequenceNumber)
+       if (reliableSequenceNumber == channel -> incomingReliableSequenceNumber ||
+           enet_sequence_index_find (& channel -> incomingReliableIndex, reliableSequenceNumber) != NULL)
          goto discardCommand;
-       
-       for (currentCommand = enet_list_previous (enet_list_end (& channel -> incomingReliableCommands));
-            currentCommand != enet_list_end (& channel -> incomingReliableCommands);
-            currentCommand = enet_list_previous (currentCommand))
-       {
-          incomingCommand = (ENetIncomingCommand *) currentCommand;
-
-          if (reliableSequenceNumber >= channel -> incomingReliableSequenceNumber)
-          {
-             if (incomingCommand -> reliableSequenceNumber < channel -> incomingReliableSequenceNumber)
-               continue;
-          }
-          else
-          if (incomingCommand -> reliableSequenceNumber >= channel -> incomingReliableSequenceNumber)
-            break;
-
-          if (incomingCommand -> reliableSequenceNumber <= reliableSequenceNumber)
-          {
-             if (incomingCommand -> reliableSequenceNumber < reliableSequenceNumber)
-               break;
 
-             goto discardCommand;
-          }
-       }
+       currentCommand = enet_peer_find_reliable_predecessor (channel, reliableSequenceNumber);
        break;
 
     case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE:
@@ -962,11 +1090,33 @@ enet_peer_queue_incoming_command (ENetPeer * peer, const ENetProtocol * command,
     if (peer -> totalWaitingData >= peer -> host -> maximumWaitingData)
       goto notifyError;
 
+    if (fragmentCount > 0)
+    {
+       size_t size = enet_peer_reassembly_size (dataLength, fragmentCount);
+
+       /* a message larger than the whole budget can never be reassembled, and
+          the sender would retry its reliable fragments until it timed out */
+       if (size > peer -> host -> maximumPeerReassemblyData ||
+           size > peer -> host -> maximumReassemblyData)
+       {
+          if ((command -> header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_SEND_FRAGMENT)
+            enet_peer_disconnect (peer, 0);
+
+          goto notifyError;
+       }
+
+       /* refuse to reserve space for a message that is mostly unsent; the
+          sender retries its reliable fragments once space frees up */
+       if (size > peer -> host -> maximumPeerReassemblyData - ENET_MIN (peer -> host -> maximumPeerReassemblyData, peer -> reassemblyData) ||
+           size > peer -> host -> maximumReassemblyData - ENET_MIN (peer -> host -> maximumReassemblyData, peer -> host -> reassemblyData))
+         goto notifyError;
+    }
+
     packet = enet_packet_create (data, dataLength, flags);
     if (packet == NULL)
       goto notifyError;
 
-    incomingCommand = (ENetIncomingCommand *) enet_malloc (sizeof (ENetIncomingCommand));
+    incomingCommand = (ENetIncomingCommand *) enet_pool_acquire (& peer -> host -> incomingCommandPool);
     if (incomingCommand == NULL)
       goto notifyError;
 
@@ -977,18 +1127,34 @@ enet_peer_queue_incoming_command (ENetPeer * peer, const ENetProtocol * command,
     incomingCommand -> fragmentsRemaining = fragmentCount;
     incomingCommand -> packet = packet;
     incomingCommand -> fragments = NULL;
+
+    if (((command -> header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_SEND_FRAGMENT ||
+         (command -> header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_SEND_RELIABLE) &&
+        enet_sequence_index_insert (& channel -> incomingReliableIndex, reliableSequenceNumber, incomingCommand) < 0)
+    {
+       enet_pool_release (& peer -> host -> incomingCommandPool, incomingCommand);
+
+       goto notifyError;
+    }
     
     if (fragmentCount > 0)
     { 
+       if (fragmentCount <= ENET_HOST_POOL_FRAGMENT_COUNT)
+         incomingCommand -> fragments = (enet_uint32 *) enet_pool_acquire (& peer -> host -> fragmentBitmapPool);
+       else
        if (fragmentCount <= ENET_PROTOCOL_MAXIMUM_FRAGMENT_COUNT)
          incomingCommand -> fragments = (enet_uint32 *) enet_malloc ((fragmentCount + 31) / 32 * sizeof (enet_uint32));
        if (incomingCommand -> fragments == NULL)
        {
-          enet_free (incomingCommand);
+          enet_sequence_index_remove (& channel -> incomingReliableIndex, reliableSequenceNumber);
+          enet_pool_release (& peer -> host -> incomingCommandPool, incomingCommand);
 
           goto notifyError;
        }
        memset (incomingCommand -> fragments, 0, (fragmentCount + 31) / 32 * sizeof (enet_uint32));
+
+       peer -> reassemblyData += enet_peer_reassembly_size (dataLength, fragmentCount);
+       peer -> host -> reassemblyData += enet_peer_reassembly_size (dataLength, fragmentCount);
     }
 
     if (packet != NULL)
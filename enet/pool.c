@@ -0,0 +1,92 @@
+/** 
+ @file pool.c
+ @brief ENet fixed size object pools
+*/
+#define ENET_BUILDING_LIB 1
+#include "enet/enet.h"
+
+/** 
+    @defgroup pool ENet object pool functions
+    @ingroup private
+    @{
+*/
+
+/** Objects kept on a free list beyond this are handed back to enet_free, so a
+    burst does not pin its peak memory for the lifetime of the host.
+*/
+#define ENET_POOL_MAXIMUM_FREE 4096
+
+void
+enet_pool_init (ENetPool * pool, size_t objectSize)
+{
+   pool -> freeList = NULL;
+   pool -> objectSize = objectSize < sizeof (void *) ? sizeof (void *) : objectSize;
+   pool -> freeCount = 0;
+   pool -> inUse = 0;
+   pool -> peakInUse = 0;
+   pool -> allocations = 0;
+   pool -> reuses = 0;
+}
+
+void
+enet_pool_destroy (ENetPool * pool)
+{
+   while (pool -> freeList != NULL)
+   {
+      void * object = pool -> freeList;
+
+      pool -> freeList = * (void **) object;
+
+      enet_free (object);
+   }
+
+   pool -> freeCount = 0;
+}
+
+void *
+enet_pool_acquire (ENetPool * pool)
+{
+   void * object = pool -> freeList;
+
+   if (object != NULL)
+   {
+      pool -> freeList = * (void **) object;
+      -- pool -> freeCount;
+      ++ pool -> reuses;
+   }
+   else
+   {
+      object = enet_malloc (pool -> objectSize);
+      if (object == NULL)
+        return NULL;
+
+      ++ pool -> allocations;
+   }
+
+   if (++ pool -> inUse > pool -> peakInUse)
+     pool -> peakInUse = pool -> inUse;
+
+   return object;
+}
+
+void
+enet_pool_release (ENetPool * pool, void * object)
+{
+   if (object == NULL)
+     return;
+
+   -- pool -> inUse;
+
+   if (pool -> freeCount >= ENET_POOL_MAXIMUM_FREE)
+   {
+      enet_free (object);
+
+      return;
+   }
+
+   * (void **) object = pool -> freeList;
+   pool -> freeList = object;
+   ++ pool -> freeCount;
+}
+
+/** @} */
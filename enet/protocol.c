@@ -39,6 +39,22 @@ static void enet_protocol_change_state(ENetHost *host, ENetPeer *peer,
   peer->state = state;
 }
 
+/* A peer takes commands once it is connected. When commands are handled
+   without an event to fill in, the connect is only queued for dispatch, so the
+   commands that follow it in the same datagram are taken as well. */
+static int enet_protocol_peer_accepts_commands(const ENetPeer *peer) {
+  switch (peer->state) {
+  case ENET_PEER_STATE_CONNECTION_PENDING:
+  case ENET_PEER_STATE_CONNECTION_SUCCEEDED:
+  case ENET_PEER_STATE_CONNECTED:
+  case ENET_PEER_STATE_DISCONNECT_LATER:
+    return 1;
+
+  default:
+    return 0;
+  }
+}
+
 static void enet_protocol_dispatch_state(ENetHost *host, ENetPeer *peer,
                                          ENetPeerState state) {
   enet_protocol_change_state(host, peer, state);
@@ -55,6 +71,7 @@ static int enet_protocol_dispatch_incoming_commands(ENetHost *host,
   while (!enet_list_empty(&host->dispatchQueue)) {
     ENetPeer *peer =
         (ENetPeer *)enet_list_remove(enet_list_begin(&host->dispatchQueue));
+    ENET_INSTRUMENT_BEGIN(host, dispatchStart);
 
     peer->flags &= ~ENET_PEER_FLAG_NEEDS_DISPATCH;
 
@@ -67,6 +84,15 @@ static int enet_protocol_dispatch_incoming_commands(ENetHost *host,
       event->peer = peer;
       event->data = peer->eventData;
 
+      /* data that arrived with the connect follows it */
+      if (!enet_list_empty(&peer->dispatchedCommands)) {
+        peer->flags |= ENET_PEER_FLAG_NEEDS_DISPATCH;
+
+        enet_list_insert(enet_list_end(&host->dispatchQueue),
+                         &peer->dispatchList);
+      }
+
+      ENET_INSTRUMENT_END(host, ENET_INSTRUMENT_STAGE_DISPATCH, dispatchStart);
       return 1;
 
     case ENET_PEER_STATE_ZOMBIE:
@@ -78,17 +104,34 @@ static int enet_protocol_dispatch_incoming_commands(ENetHost *host,
 
       enet_peer_reset(peer);
 
+      ENET_INSTRUMENT_END(host, ENET_INSTRUMENT_STAGE_DISPATCH, dispatchStart);
       return 1;
 
     case ENET_PEER_STATE_CONNECTED:
       if (enet_list_empty(&peer->dispatchedCommands))
         continue;
 
+      {
+        const ENetIncomingCommand *incomingCommand =
+            (const ENetIncomingCommand *)enet_list_front(
+                &peer->dispatchedCommands);
+
+        /* a streamed fragment is queued without a reassembly bitmap */
+        if ((incomingCommand->command.header.command &
+             ENET_PROTOCOL_COMMAND_MASK) ==
+                ENET_PROTOCOL_COMMAND_SEND_FRAGMENT &&
+            incomingCommand->fragmentCount == 0) {
+          event->type = ENET_EVENT_TYPE_RECEIVE_CHUNK;
+          event->data = ENET_NET_TO_HOST_32(
+              incomingCommand->command.sendFragment.fragmentOffset);
+        } else
+          event->type = ENET_EVENT_TYPE_RECEIVE;
+      }
+
       event->packet = enet_peer_receive(peer, &event->channelID);
       if (event->packet == NULL)
         continue;
 
-      event->type = ENET_EVENT_TYPE_RECEIVE;
       event->peer = peer;
 
       if (!enet_list_empty(&peer->dispatchedCommands)) {
@@ -98,6 +141,7 @@ static int enet_protocol_dispatch_incoming_commands(ENetHost *host,
                          &peer->dispatchList);
       }
 
+      ENET_INSTRUMENT_END(host, ENET_INSTRUMENT_STAGE_DISPATCH, dispatchStart);
       return 1;
 
     default:
@@ -169,7 +213,7 @@ static void enet_protocol_remove_sent_unreliable_commands(
       }
     }
 
-    enet_free(outgoingCommand);
+    enet_pool_release(&peer->host->outgoingCommandPool, outgoingCommand);
   } while (!enet_list_empty(sentUnreliableCommands));
 
   if (peer->state == ENET_PEER_STATE_DISCONNECT_LATER &&
@@ -177,62 +221,30 @@ static void enet_protocol_remove_sent_unreliable_commands(
     enet_peer_disconnect(peer, peer->eventData);
 }
 
-static ENetOutgoingCommand *enet_protocol_find_sent_reliable_command(
-    ENetList *list, enet_uint16 reliableSequenceNumber, enet_uint8 channelID) {
-  ENetListIterator currentCommand;
-
-  for (currentCommand = enet_list_begin(list);
-       currentCommand != enet_list_end(list);
-       currentCommand = enet_list_next(currentCommand)) {
-    ENetOutgoingCommand *outgoingCommand =
-        (ENetOutgoingCommand *)currentCommand;
-
-    if (!(outgoingCommand->command.header.command &
-          ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE))
-      continue;
-
-    if (outgoingCommand->sendAttempts < 1)
-      break;
-
-    if (outgoingCommand->reliableSequenceNumber == reliableSequenceNumber &&
-        outgoingCommand->command.header.channelID == channelID)
-      return outgoingCommand;
-  }
-
-  return NULL;
+static ENetSequenceIndex *enet_protocol_sent_reliable_index(ENetPeer *peer,
+                                                            enet_uint8 channelID) {
+  return channelID < peer->channelCount
+             ? &peer->channels[channelID].sentReliableIndex
+             : &peer->sentControlIndex;
 }
 
 static ENetProtocolCommand enet_protocol_remove_sent_reliable_command(
     ENetPeer *peer, enet_uint16 reliableSequenceNumber, enet_uint8 channelID) {
-  ENetOutgoingCommand *outgoingCommand = NULL;
-  ENetListIterator currentCommand;
+  ENetSequenceIndex *index =
+      enet_protocol_sent_reliable_index(peer, channelID);
+  ENetOutgoingCommand *outgoingCommand;
   ENetProtocolCommand commandNumber;
-  int wasSent = 1;
-
-  for (currentCommand = enet_list_begin(&peer->sentReliableCommands);
-       currentCommand != enet_list_end(&peer->sentReliableCommands);
-       currentCommand = enet_list_next(currentCommand)) {
-    outgoingCommand = (ENetOutgoingCommand *)currentCommand;
-
-    if (outgoingCommand->reliableSequenceNumber == reliableSequenceNumber &&
-        outgoingCommand->command.header.channelID == channelID)
-      break;
-  }
-
-  if (currentCommand == enet_list_end(&peer->sentReliableCommands)) {
-    outgoingCommand = enet_protocol_find_sent_reliable_command(
-        &peer->outgoingCommands, reliableSequenceNumber, channelID);
-    if (outgoingCommand == NULL)
-      outgoingCommand = enet_protocol_find_sent_reliable_command(
-          &peer->outgoingSendReliableCommands, reliableSequenceNumber,
-          channelID);
-
-    wasSent = 0;
-  }
 
-  if (outgoingCommand == NULL)
+  /* the command may sit in sentReliableCommands or, after a timeout, back in
+     an outgoing queue waiting to be resent */
+  outgoingCommand = (ENetOutgoingCommand *)enet_sequence_index_find(
+      index, reliableSequenceNumber);
+  if (outgoingCommand == NULL ||
+      outgoingCommand->command.header.channelID != channelID)
     return ENET_PROTOCOL_COMMAND_NONE;
 
+  enet_sequence_index_remove(index, reliableSequenceNumber);
+
   if (channelID < peer->channelCount) {
     ENetChannel *channel = &peer->channels[channelID];
     enet_uint16 reliableWindow =
@@ -251,7 +263,7 @@ static ENetProtocolCommand enet_protocol_remove_sent_reliable_command(
   enet_list_remove(&outgoingCommand->outgoingCommandList);
 
   if (outgoingCommand->packet != NULL) {
-    if (wasSent)
+    if (outgoingCommand->inFlight)
       peer->reliableDataInTransit -= outgoingCommand->fragmentLength;
 
     --outgoingCommand->packet->referenceCount;
@@ -263,7 +275,7 @@ static ENetProtocolCommand enet_protocol_remove_sent_reliable_command(
     }
   }
 
-  enet_free(outgoingCommand);
+  enet_pool_release(&peer->host->outgoingCommandPool, outgoingCommand);
 
   if (enet_list_empty(&peer->sentReliableCommands))
     return commandNumber;
@@ -274,6 +286,13 @@ static ENetProtocolCommand enet_protocol_remove_sent_reliable_command(
   peer->nextTimeout =
       outgoingCommand->sentTime + outgoingCommand->roundTripTimeout;
 
+  /* a later command may carry a shorter timeout than the one the peer is
+     filed under, and a datagram of acknowledgements alone leaves the peer
+     clean, so file it again here or the retransmit fires late */
+  if (peer->timer.slot != ENET_TIMER_UNSCHEDULED &&
+      ENET_TIME_LESS(peer->nextTimeout, peer->timer.deadline))
+    enet_host_schedule_peer(peer->host, peer);
+
   return commandNumber;
 }
 
@@ -293,14 +312,12 @@ static ENetPeer *enet_protocol_handle_connect(ENetHost *host,
       channelCount > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT)
     return NULL;
 
-  for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount];
-       ++currentPeer) {
-    if (currentPeer->state == ENET_PEER_STATE_DISCONNECTED) {
-      if (peer == NULL)
-        peer = currentPeer;
-    } else if (currentPeer->state != ENET_PEER_STATE_CONNECTING &&
-               enet_address_equal_host(&currentPeer->address,
-                                       &host->receivedAddress)) {
+  for (currentPeer = enet_host_peer_bucket(host, &host->receivedAddress);
+       currentPeer != NULL; currentPeer = currentPeer->addressHashNext) {
+    if (currentPeer->state != ENET_PEER_STATE_DISCONNECTED &&
+        currentPeer->state != ENET_PEER_STATE_CONNECTING &&
+        enet_address_equal_host(&currentPeer->address,
+                                &host->receivedAddress)) {
       if (currentPeer->address.port == host->receivedAddress.port &&
           currentPeer->connectID == command->connect.connectID)
         return NULL;
@@ -309,19 +326,27 @@ static ENetPeer *enet_protocol_handle_connect(ENetHost *host,
     }
   }
 
-  if (peer == NULL || duplicatePeers >= host->duplicatePeers)
+  if (duplicatePeers >= host->duplicatePeers)
+    return NULL;
+
+  peer = enet_host_acquire_peer(host);
+  if (peer == NULL)
     return NULL;
 
   if (channelCount > host->channelLimit)
     channelCount = host->channelLimit;
   peer->channels =
       (ENetChannel *)enet_malloc(channelCount * sizeof(ENetChannel));
-  if (peer->channels == NULL)
+  if (peer->channels == NULL) {
+    enet_host_release_peer(host, peer);
+
     return NULL;
+  }
   peer->channelCount = channelCount;
   peer->state = ENET_PEER_STATE_ACKNOWLEDGING_CONNECT;
   peer->connectID = command->connect.connectID;
   peer->address = host->receivedAddress;
+  enet_host_index_peer(host, peer);
   peer->mtu = host->mtu;
   peer->outgoingPeerID = ENET_NET_TO_HOST_16(command->connect.outgoingPeerID);
   peer->incomingBandwidth =
@@ -369,6 +394,9 @@ static ENetPeer *enet_protocol_handle_connect(ENetHost *host,
 
     enet_list_clear(&channel->incomingReliableCommands);
     enet_list_clear(&channel->incomingUnreliableCommands);
+    channel->priority = host->channelPriorities[channel - peer->channels];
+    enet_sequence_index_init(&channel->incomingReliableIndex);
+    enet_sequence_index_init(&channel->sentReliableIndex);
 
     channel->usedReliableWindows = 0;
     memset(channel->reliableWindows, 0, sizeof(channel->reliableWindows));
@@ -449,8 +477,7 @@ static int enet_protocol_handle_send_reliable(ENetHost *host, ENetPeer *peer,
   size_t dataLength;
 
   if (command->header.channelID >= peer->channelCount ||
-      (peer->state != ENET_PEER_STATE_CONNECTED &&
-       peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
+      !enet_protocol_peer_accepts_commands(peer))
     return -1;
 
   dataLength = ENET_NET_TO_HOST_16(command->sendReliable.dataLength);
@@ -476,8 +503,7 @@ static int enet_protocol_handle_send_unsequenced(ENetHost *host, ENetPeer *peer,
   size_t dataLength;
 
   if (command->header.channelID >= peer->channelCount ||
-      (peer->state != ENET_PEER_STATE_CONNECTED &&
-       peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
+      !enet_protocol_peer_accepts_commands(peer))
     return -1;
 
   dataLength = ENET_NET_TO_HOST_16(command->sendUnsequenced.dataLength);
@@ -525,8 +551,7 @@ static int enet_protocol_handle_send_unreliable(ENetHost *host, ENetPeer *peer,
   size_t dataLength;
 
   if (command->header.channelID >= peer->channelCount ||
-      (peer->state != ENET_PEER_STATE_CONNECTED &&
-       peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
+      !enet_protocol_peer_accepts_commands(peer))
     return -1;
 
   dataLength = ENET_NET_TO_HOST_16(command->sendUnreliable.dataLength);
@@ -545,6 +570,46 @@ static int enet_protocol_handle_send_unreliable(ENetHost *host, ENetPeer *peer,
   return 0;
 }
 
+/* On a streaming channel every fragment keeps its own reliable sequence
+   number and is queued like a reliable send of its own, so ordered dispatch
+   hands it out as soon as everything before it has arrived and nothing the
+   size of the whole message is ever allocated. */
+static int enet_protocol_handle_send_chunk(ENetHost *host, ENetPeer *peer,
+                                           const ENetProtocol *command,
+                                           enet_uint32 fragmentLength) {
+  enet_uint32 fragmentNumber =
+                  ENET_NET_TO_HOST_32(command->sendFragment.fragmentNumber),
+              fragmentCount =
+                  ENET_NET_TO_HOST_32(command->sendFragment.fragmentCount),
+              fragmentOffset =
+                  ENET_NET_TO_HOST_32(command->sendFragment.fragmentOffset),
+              totalLength =
+                  ENET_NET_TO_HOST_32(command->sendFragment.totalLength);
+
+  if (fragmentCount > ENET_PROTOCOL_MAXIMUM_FRAGMENT_COUNT ||
+      fragmentNumber >= fragmentCount ||
+      totalLength > host->maximumPacketSize || totalLength < fragmentCount ||
+      fragmentOffset >= totalLength ||
+      fragmentLength > totalLength - fragmentOffset ||
+      ((ENET_NET_TO_HOST_16(command->sendFragment.startSequenceNumber) +
+        fragmentNumber) &
+       0xFFFF) != command->header.reliableSequenceNumber)
+    return -1;
+
+  if (enet_peer_queue_incoming_command(
+          peer, command,
+          (const enet_uint8 *)command + sizeof(ENetProtocolSendFragment),
+          fragmentLength,
+          ENET_PACKET_FLAG_RELIABLE |
+              (fragmentNumber == fragmentCount - 1
+                   ? ENET_PACKET_FLAG_LAST_CHUNK
+                   : 0),
+          0) == NULL)
+    return -1;
+
+  return 0;
+}
+
 static int enet_protocol_handle_send_fragment(ENetHost *host, ENetPeer *peer,
                                               const ENetProtocol *command,
                                               enet_uint8 **currentData) {
@@ -552,12 +617,10 @@ static int enet_protocol_handle_send_fragment(ENetHost *host, ENetPeer *peer,
       startSequenceNumber, totalLength;
   ENetChannel *channel;
   enet_uint16 startWindow, currentWindow;
-  ENetListIterator currentCommand;
-  ENetIncomingCommand *startCommand = NULL;
+  ENetIncomingCommand *startCommand;
 
   if (command->header.channelID >= peer->channelCount ||
-      (peer->state != ENET_PEER_STATE_CONNECTED &&
-       peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
+      !enet_protocol_peer_accepts_commands(peer))
     return -1;
 
   fragmentLength = ENET_NET_TO_HOST_16(command->sendFragment.dataLength);
@@ -570,6 +633,12 @@ static int enet_protocol_handle_send_fragment(ENetHost *host, ENetPeer *peer,
   channel = &peer->channels[command->header.channelID];
   startSequenceNumber =
       ENET_NET_TO_HOST_16(command->sendFragment.startSequenceNumber);
+
+  if (host->streamingChannels[command->header.channelID / 32] &
+      (1u << (command->header.channelID % 32)))
+    return enet_protocol_handle_send_chunk(host, peer, command,
+                                           fragmentLength);
+
   startWindow = startSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
   currentWindow =
       channel->incomingReliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
@@ -593,35 +662,14 @@ static int enet_protocol_handle_send_fragment(ENetHost *host, ENetPeer *peer,
       fragmentLength > totalLength - fragmentOffset)
     return -1;
 
-  for (currentCommand = enet_list_previous(
-           enet_list_end(&channel->incomingReliableCommands));
-       currentCommand != enet_list_end(&channel->incomingReliableCommands);
-       currentCommand = enet_list_previous(currentCommand)) {
-    ENetIncomingCommand *incomingCommand =
-        (ENetIncomingCommand *)currentCommand;
-
-    if (startSequenceNumber >= channel->incomingReliableSequenceNumber) {
-      if (incomingCommand->reliableSequenceNumber <
-          channel->incomingReliableSequenceNumber)
-        continue;
-    } else if (incomingCommand->reliableSequenceNumber >=
-               channel->incomingReliableSequenceNumber)
-      break;
-
-    if (incomingCommand->reliableSequenceNumber <= startSequenceNumber) {
-      if (incomingCommand->reliableSequenceNumber < startSequenceNumber)
-        break;
-
-      if ((incomingCommand->command.header.command &
-           ENET_PROTOCOL_COMMAND_MASK) != ENET_PROTOCOL_COMMAND_SEND_FRAGMENT ||
-          totalLength != incomingCommand->packet->dataLength ||
-          fragmentCount != incomingCommand->fragmentCount)
-        return -1;
-
-      startCommand = incomingCommand;
-      break;
-    }
-  }
+  startCommand = (ENetIncomingCommand *)enet_sequence_index_find(
+      &channel->incomingReliableIndex, startSequenceNumber);
+  if (startCommand != NULL &&
+      ((startCommand->command.header.command & ENET_PROTOCOL_COMMAND_MASK) !=
+           ENET_PROTOCOL_COMMAND_SEND_FRAGMENT ||
+       totalLength != startCommand->packet->dataLength ||
+       fragmentCount != startCommand->fragmentCount))
+    return -1;
 
   if (startCommand == NULL) {
     ENetProtocol hostCommand = *command;
@@ -649,8 +697,10 @@ static int enet_protocol_handle_send_fragment(ENetHost *host, ENetPeer *peer,
            (enet_uint8 *)command + sizeof(ENetProtocolSendFragment),
            fragmentLength);
 
-    if (startCommand->fragmentsRemaining <= 0)
+    if (startCommand->fragmentsRemaining <= 0) {
+      enet_peer_release_reassembly(peer, startCommand);
       enet_peer_dispatch_incoming_reliable_commands(peer, channel, NULL);
+    }
   }
 
   return 0;
@@ -668,8 +718,7 @@ enet_protocol_handle_send_unreliable_fragment(ENetHost *host, ENetPeer *peer,
   ENetIncomingCommand *startCommand = NULL;
 
   if (command->header.channelID >= peer->channelCount ||
-      (peer->state != ENET_PEER_STATE_CONNECTED &&
-       peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
+      !enet_protocol_peer_accepts_commands(peer))
     return -1;
 
   fragmentLength = ENET_NET_TO_HOST_16(command->sendFragment.dataLength);
@@ -770,8 +819,10 @@ enet_protocol_handle_send_unreliable_fragment(ENetHost *host, ENetPeer *peer,
            (enet_uint8 *)command + sizeof(ENetProtocolSendFragment),
            fragmentLength);
 
-    if (startCommand->fragmentsRemaining <= 0)
+    if (startCommand->fragmentsRemaining <= 0) {
+      enet_peer_release_reassembly(peer, startCommand);
       enet_peer_dispatch_incoming_unreliable_commands(peer, channel, NULL);
+    }
   }
 
   return 0;
@@ -779,8 +830,7 @@ enet_protocol_handle_send_unreliable_fragment(ENetHost *host, ENetPeer *peer,
 
 static int enet_protocol_handle_ping(ENetHost *host, ENetPeer *peer,
                                      const ENetProtocol *command) {
-  if (peer->state != ENET_PEER_STATE_CONNECTED &&
-      peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
+  if (!enet_protocol_peer_accepts_commands(peer))
     return -1;
 
   return 0;
@@ -788,8 +838,7 @@ static int enet_protocol_handle_ping(ENetHost *host, ENetPeer *peer,
 
 static int enet_protocol_handle_bandwidth_limit(ENetHost *host, ENetPeer *peer,
                                                 const ENetProtocol *command) {
-  if (peer->state != ENET_PEER_STATE_CONNECTED &&
-      peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
+  if (!enet_protocol_peer_accepts_commands(peer))
     return -1;
 
   if (peer->incomingBandwidth != 0)
@@ -827,8 +876,7 @@ static int enet_protocol_handle_bandwidth_limit(ENetHost *host, ENetPeer *peer,
 static int
 enet_protocol_handle_throttle_configure(ENetHost *host, ENetPeer *peer,
                                         const ENetProtocol *command) {
-  if (peer->state != ENET_PEER_STATE_CONNECTED &&
-      peer->state != ENET_PEER_STATE_DISCONNECT_LATER)
+  if (!enet_protocol_peer_accepts_commands(peer))
     return -1;
 
   peer->packetThrottleInterval =
@@ -1150,9 +1198,16 @@ static int enet_protocol_handle_incoming_commands(ENetHost *host,
   }
 
   if (peer != NULL) {
+    int rehash = memcmp(&peer->address.host, &host->receivedAddress.host,
+                        sizeof(peer->address.host)) != 0;
+
     peer->address.host = host->receivedAddress.host;
     peer->address.port = host->receivedAddress.port;
+    if (rehash)
+      enet_host_index_peer(host, peer);
     peer->incomingDataTotal += host->receivedDataLength;
+    peer->totalReceivedData += host->receivedDataLength;
+    peer->totalReceivedPackets++;
   }
 
   currentData = host->receivedData + headerSize;
@@ -1304,24 +1359,95 @@ static int enet_protocol_receive_incoming_commands(ENetHost *host,
 
   for (packets = 0; packets < 256; ++packets) {
     int receivedLength;
-    ENetBuffer buffer;
+    size_t slot;
 
-    buffer.data = host->packetData[0];
-    buffer.dataLength = sizeof(host->packetData[0]);
+    /* Datagrams left over from a batch that was cut short by an event are
+       handled before the socket is read again. */
+    if (host->receiveBatchIndex >= host->receiveBatchCount &&
+        (host->offloadFlags & ENET_HOST_OFFLOAD_GRO)) {
+      ENetBuffer buffer;
+      size_t segmentSize = 0;
+      ENET_INSTRUMENT_BEGIN(host, receiveStart);
 
-    receivedLength =
-        enet_socket_receive(host->socket, &host->receivedAddress, &buffer, 1);
+      buffer.data = host->receiveSegmentData;
+      buffer.dataLength = ENET_HOST_OFFLOAD_BUFFER_SIZE;
 
-    if (receivedLength == -2)
-      continue;
+      host->receiveBatchIndex = 0;
+      host->receiveBatchCount = 0;
 
-    if (receivedLength < 0)
-      return -1;
+      receivedLength = enet_socket_receive_segments(
+          host->socket, &host->receiveBatchAddresses[0], &buffer, &segmentSize);
+      ENET_INSTRUMENT_END(host, ENET_INSTRUMENT_STAGE_SOCKET_RECEIVE,
+                          receiveStart);
 
-    if (receivedLength == 0)
-      return 0;
+      if (receivedLength == -2)
+        continue;
+
+      if (receivedLength < 0)
+        return -1;
+
+      if (receivedLength == 0)
+        return 0;
+
+      if (segmentSize == 0 || segmentSize > (size_t)receivedLength)
+        segmentSize = receivedLength;
+
+      host->receiveSegmentSize = segmentSize;
+      host->receiveSegmentLength = receivedLength;
+      host->receiveBatchCount =
+          (receivedLength + segmentSize - 1) / segmentSize;
+    } else if (host->receiveBatchIndex >= host->receiveBatchCount) {
+      ENetBuffer buffers[ENET_SOCKET_BATCH_MAXIMUM];
+      int receivedCount;
+      ENET_INSTRUMENT_BEGIN(host, receiveStart);
+
+      for (slot = 0; slot < ENET_SOCKET_BATCH_MAXIMUM; ++slot) {
+        buffers[slot].data =
+            &host->receiveBatchData[slot * ENET_PROTOCOL_MAXIMUM_MTU];
+        buffers[slot].dataLength = ENET_PROTOCOL_MAXIMUM_MTU;
+      }
+
+      host->receiveBatchIndex = 0;
+      host->receiveBatchCount = 0;
+
+      receivedCount = enet_socket_receive_batch(
+          host->socket, host->receiveBatchAddresses, buffers,
+          host->receiveBatchLengths, ENET_SOCKET_BATCH_MAXIMUM);
+      ENET_INSTRUMENT_END(host, ENET_INSTRUMENT_STAGE_SOCKET_RECEIVE,
+                          receiveStart);
+
+      if (receivedCount < 0)
+        return -1;
+
+      if (receivedCount == 0)
+        return 0;
+
+      host->receiveSegmentSize = 0;
+      host->receiveBatchCount = receivedCount;
+    }
+
+    slot = host->receiveBatchIndex++;
+
+    if (host->receiveSegmentSize > 0) {
+      size_t offset = slot * host->receiveSegmentSize;
+
+      receivedLength = host->receiveSegmentLength - offset;
+      if ((size_t)receivedLength > host->receiveSegmentSize)
+        receivedLength = host->receiveSegmentSize;
+
+      host->receivedAddress = host->receiveBatchAddresses[0];
+      host->receivedData = &host->receiveSegmentData[offset];
+    } else {
+      receivedLength = host->receiveBatchLengths[slot];
+
+      if (receivedLength == -2)
+        continue;
+
+      host->receivedAddress = host->receiveBatchAddresses[slot];
+      host->receivedData =
+          &host->receiveBatchData[slot * ENET_PROTOCOL_MAXIMUM_MTU];
+    }
 
-    host->receivedData = host->packetData[0];
     host->receivedDataLength = receivedLength;
 
     host->totalReceivedData += receivedLength;
@@ -1343,15 +1469,23 @@ static int enet_protocol_receive_incoming_commands(ENetHost *host,
       }
     }
 
-    switch (enet_protocol_handle_incoming_commands(host, event)) {
-    case 1:
-      return 1;
+    {
+      int result;
+      ENET_INSTRUMENT_BEGIN(host, protocolStart);
 
-    case -1:
-      return -1;
+      result = enet_protocol_handle_incoming_commands(host, event);
+      ENET_INSTRUMENT_END(host, ENET_INSTRUMENT_STAGE_PROTOCOL, protocolStart);
 
-    default:
-      break;
+      switch (result) {
+      case 1:
+        return 1;
+
+      case -1:
+        return -1;
+
+      default:
+        break;
+      }
     }
   }
 
@@ -1403,7 +1537,7 @@ static void enet_protocol_send_acknowledgements(ENetHost *host,
       enet_protocol_dispatch_state(host, peer, ENET_PEER_STATE_ZOMBIE);
 
     enet_list_remove(&acknowledgement->acknowledgementList);
-    enet_free(acknowledgement);
+    enet_pool_release(&host->acknowledgementPool, acknowledgement);
 
     ++command;
     ++buffer;
@@ -1448,8 +1582,11 @@ static int enet_protocol_check_timeouts(ENetHost *host, ENetPeer *peer,
     }
 
     ++peer->packetsLost;
+    ++peer->totalRetransmits;
+    ++host->totalRetransmits;
 
     outgoingCommand->roundTripTimeout *= 2;
+    outgoingCommand->inFlight = 0;
 
     if (outgoingCommand->packet != NULL) {
       peer->reliableDataInTransit -= outgoingCommand->fragmentLength;
@@ -1483,21 +1620,29 @@ enet_protocol_check_outgoing_commands(ENetHost *host, ENetPeer *peer,
   enet_uint16 reliableWindow = 0;
   size_t commandSize;
   int windowWrap = 0, canPing = 1;
+  ENET_INSTRUMENT_BEGIN(host, wireTime);
 
   currentCommand = enet_list_begin(&peer->outgoingCommands);
   currentSendReliableCommand =
       enet_list_begin(&peer->outgoingSendReliableCommands);
 
+  /* both queues are kept in priority order, so merging them by priority and
+     then by queue time fills the datagram from the highest priority first */
   for (;;) {
     if (currentCommand != enet_list_end(&peer->outgoingCommands)) {
       outgoingCommand = (ENetOutgoingCommand *)currentCommand;
 
       if (currentSendReliableCommand !=
-              enet_list_end(&peer->outgoingSendReliableCommands) &&
-          ENET_TIME_LESS(
-              ((ENetOutgoingCommand *)currentSendReliableCommand)->queueTime,
-              outgoingCommand->queueTime))
-        goto useSendReliableCommand;
+          enet_list_end(&peer->outgoingSendReliableCommands)) {
+        ENetOutgoingCommand *sendReliableCommand =
+            (ENetOutgoingCommand *)currentSendReliableCommand;
+
+        if (sendReliableCommand->priority > outgoingCommand->priority ||
+            (sendReliableCommand->priority == outgoingCommand->priority &&
+             ENET_TIME_LESS(sendReliableCommand->queueTime,
+                            outgoingCommand->queueTime)))
+          goto useSendReliableCommand;
+      }
 
       currentCommand = enet_list_next(currentCommand);
     } else if (currentSendReliableCommand !=
@@ -1571,12 +1716,22 @@ enet_protocol_check_outgoing_commands(ENetHost *host, ENetPeer *peer,
 
     if (outgoingCommand->command.header.command &
         ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) {
+      /* acknowledgements find the command by sequence number from its first
+         send on; if the index cannot grow, try again next time */
+      if (outgoingCommand->sendAttempts < 1 &&
+          enet_sequence_index_insert(
+              enet_protocol_sent_reliable_index(
+                  peer, outgoingCommand->command.header.channelID),
+              outgoingCommand->reliableSequenceNumber, outgoingCommand) < 0)
+        break;
+
       if (channel != NULL && outgoingCommand->sendAttempts < 1) {
         channel->usedReliableWindows |= 1u << reliableWindow;
         ++channel->reliableWindows[reliableWindow];
       }
 
       ++outgoingCommand->sendAttempts;
+      outgoingCommand->inFlight = 1;
 
       if (outgoingCommand->roundTripTimeout == 0)
         outgoingCommand->roundTripTimeout =
@@ -1612,7 +1767,7 @@ enet_protocol_check_outgoing_commands(ENetHost *host, ENetPeer *peer,
               enet_packet_destroy(outgoingCommand->packet);
 
             enet_list_remove(&outgoingCommand->outgoingCommandList);
-            enet_free(outgoingCommand);
+            enet_pool_release(&host->outgoingCommandPool, outgoingCommand);
 
             if (currentCommand == enet_list_end(&peer->outgoingCommands))
               break;
@@ -1645,6 +1800,13 @@ enet_protocol_check_outgoing_commands(ENetHost *host, ENetPeer *peer,
 
     *command = outgoingCommand->command;
 
+#ifdef ENET_INSTRUMENT
+    if (outgoingCommand->sendAttempts <= 1 &&
+        outgoingCommand->instrumentTime != 0)
+      ENET_INSTRUMENT_RECORD(host, ENET_INSTRUMENT_STAGE_QUEUE_TO_WIRE,
+                             wireTime - outgoingCommand->instrumentTime);
+#endif
+
     if (outgoingCommand->packet != NULL) {
       ++buffer;
 
@@ -1655,7 +1817,7 @@ enet_protocol_check_outgoing_commands(ENetHost *host, ENetPeer *peer,
       host->packetSize += outgoingCommand->fragmentLength;
     } else if (!(outgoingCommand->command.header.command &
                  ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE))
-      enet_free(outgoingCommand);
+      enet_pool_release(&host->outgoingCommandPool, outgoingCommand);
 
     ++peer->packetsSent;
 
@@ -1674,6 +1836,142 @@ enet_protocol_check_outgoing_commands(ENetHost *host, ENetPeer *peer,
   return canPing;
 }
 
+/* Hands every datagram collected in the host's send batch to the socket in
+   one call and accounts for them. */
+static int enet_protocol_send_datagram_range(ENetHost *host, size_t first,
+                                             size_t last) {
+  size_t datagram;
+  int sentCount;
+
+  if (first >= last)
+    return 0;
+
+  sentCount = enet_socket_send_batch(host->socket,
+                                     &host->sendBatchAddresses[first],
+                                     &host->sendBatchBuffers[first], last - first);
+
+  if (sentCount < 0)
+    return -1;
+
+  for (datagram = first; datagram < first + sentCount; ++datagram)
+    host->totalSentData += host->sendBatchBuffers[datagram].dataLength;
+  host->totalSentPackets += last - first;
+
+  return 0;
+}
+
+/* Sends runs of queued datagrams to the same address as single segmented
+   writes; a run only continues while datagrams match the first one's size,
+   and a shorter datagram ends it, as UDP_SEGMENT requires. Everything else
+   goes out through the regular batched send. */
+static int enet_protocol_send_segmented_datagrams(ENetHost *host) {
+  size_t pending = 0, first = 0;
+
+  while (first < host->sendBatchCount) {
+    size_t last = first + 1,
+           segmentSize = host->sendBatchBuffers[first].dataLength,
+           totalSize = segmentSize;
+    int sentLength;
+
+    while (last < host->sendBatchCount &&
+           last - first < ENET_HOST_OFFLOAD_MAXIMUM_SEGMENTS &&
+           host->sendBatchBuffers[last].dataLength <= segmentSize &&
+           totalSize + host->sendBatchBuffers[last].dataLength <=
+               ENET_HOST_OFFLOAD_MAXIMUM_SIZE &&
+           enet_address_equal(&host->sendBatchAddresses[last],
+                              &host->sendBatchAddresses[first])) {
+      totalSize += host->sendBatchBuffers[last].dataLength;
+      if (host->sendBatchBuffers[last++].dataLength < segmentSize)
+        break;
+    }
+
+    if (last - first < 2) {
+      first = last;
+      continue;
+    }
+
+    if (enet_protocol_send_datagram_range(host, pending, first) < 0)
+      return -1;
+
+    sentLength = enet_socket_send_segments(
+        host->socket, &host->sendBatchAddresses[first],
+        &host->sendBatchBuffers[first], last - first, segmentSize);
+
+    if (sentLength == -2) {
+      host->offloadFlags &= ~ENET_HOST_OFFLOAD_GSO;
+      pending = first;
+      break;
+    }
+
+    if (sentLength < 0)
+      return -1;
+
+    host->totalSentData += sentLength;
+    host->totalSentPackets += last - first;
+
+    pending = first = last;
+  }
+
+  return enet_protocol_send_datagram_range(host, pending, host->sendBatchCount);
+}
+
+/* Hands every datagram collected in the host's send batch to the socket and
+   accounts for them. */
+static int enet_protocol_flush_datagrams(ENetHost *host) {
+  int result;
+
+  if (host->sendBatchCount == 0)
+    return 0;
+
+  if (host->offloadFlags & ENET_HOST_OFFLOAD_GSO)
+    result = enet_protocol_send_segmented_datagrams(host);
+  else
+    result = enet_protocol_send_datagram_range(host, 0, host->sendBatchCount);
+
+  host->sendBatchCount = 0;
+
+  return result;
+}
+
+/* Returns the length of the datagram assembled in host->buffers. */
+static size_t enet_protocol_datagram_length(const ENetHost *host) {
+  size_t length = 0, i;
+
+  for (i = 0; i < host->bufferCount; ++i)
+    length += host->buffers[i].dataLength;
+
+  return length;
+}
+
+/* Copies the datagram assembled in host->buffers into the send batch, since
+   the buffers point at command data released right after sending. */
+static int enet_protocol_queue_datagram(ENetHost *host,
+                                        const ENetAddress *address) {
+  enet_uint8 *data;
+  size_t length = 0, i;
+
+  if (host->sendBatchCount >= ENET_SOCKET_BATCH_MAXIMUM &&
+      enet_protocol_flush_datagrams(host) < 0)
+    return -1;
+
+  data = &host->sendBatchData[host->sendBatchCount * ENET_PROTOCOL_MAXIMUM_MTU];
+
+  for (i = 0; i < host->bufferCount; ++i) {
+    if (length + host->buffers[i].dataLength > ENET_PROTOCOL_MAXIMUM_MTU)
+      return -1;
+
+    memcpy(&data[length], host->buffers[i].data, host->buffers[i].dataLength);
+    length += host->buffers[i].dataLength;
+  }
+
+  host->sendBatchAddresses[host->sendBatchCount] = *address;
+  host->sendBatchBuffers[host->sendBatchCount].data = data;
+  host->sendBatchBuffers[host->sendBatchCount].dataLength = length;
+  host->sendBatchCount++;
+
+  return (int)length;
+}
+
 static int enet_protocol_send_outgoing_commands(ENetHost *host,
                                                 ENetEvent *event,
                                                 int checkForTimeouts) {
@@ -1698,16 +1996,25 @@ static int enet_protocol_send_outgoing_commands(ENetHost *host,
         ENET_HOST_TO_NET_16(enet_host_random(host) & 0x61D2 | 0x920D);
   }
 
+  /* only peers with something queued are visited; servicing first adds the
+     ones whose retransmit or ping deadline has passed */
+  if (checkForTimeouts)
+    enet_host_expire_peers(host);
+
   for (int sendPass = 0, continueSending = 0; sendPass <= continueSending;
        ++sendPass)
-    for (ENetPeer *currentPeer = host->peers;
-         currentPeer < &host->peers[host->peerCount]; ++currentPeer) {
+    for (ENetPeer *currentPeer = host->dirtyPeers, *followingPeer;
+         currentPeer != NULL; currentPeer = followingPeer) {
+      /* the current peer may leave the list while it is handled */
+      followingPeer = currentPeer->dirtyNext;
+
       if (currentPeer->state == ENET_PEER_STATE_DISCONNECTED ||
           currentPeer->state == ENET_PEER_STATE_ZOMBIE ||
           (sendPass > 0 &&
            !(currentPeer->flags & ENET_PEER_FLAG_CONTINUE_SENDING)))
         continue;
 
+    nextDatagram:
       currentPeer->flags &= ~ENET_PEER_FLAG_CONTINUE_SENDING;
 
       host->headerFlags = 0;
@@ -1724,7 +2031,7 @@ static int enet_protocol_send_outgoing_commands(ENetHost *host,
                                   currentPeer->nextTimeout) &&
           enet_protocol_check_timeouts(host, currentPeer, event) == 1) {
         if (event != NULL && event->type != ENET_EVENT_TYPE_NONE)
-          return 1;
+          return enet_protocol_flush_datagrams(host) < 0 ? -1 : 1;
         else
           goto nextPeer;
       }
@@ -1858,24 +2165,63 @@ static int enet_protocol_send_outgoing_commands(ENetHost *host,
 
       currentPeer->lastSendTime = host->serviceTime;
 
-      sentLength = enet_socket_send(host->socket, &currentPeer->address,
-                                    host->buffers, host->bufferCount);
+      if (host->interceptSend != NULL) {
+        switch (host->interceptSend(host, &currentPeer->address, host->buffers,
+                                    host->bufferCount)) {
+        case 1:
+          /* counted as sent, so host and peer totals keep agreeing */
+          sentLength = (int)enet_protocol_datagram_length(host);
+          host->totalSentData += sentLength;
+          host->totalSentPackets++;
+          goto datagramSent;
+
+        case -1:
+          return -1;
+
+        default:
+          break;
+        }
+      }
+
+      if (host->sendBatchData != NULL)
+        sentLength = enet_protocol_queue_datagram(host, &currentPeer->address);
+      else {
+        sentLength = enet_socket_send(host->socket, &currentPeer->address,
+                                      host->buffers, host->bufferCount);
+
+        if (sentLength >= 0) {
+          host->totalSentData += sentLength;
+          host->totalSentPackets++;
+        }
+      }
 
+    datagramSent:
       enet_protocol_remove_sent_unreliable_commands(currentPeer,
                                                     &sentUnreliableCommands);
 
       if (sentLength < 0)
         return -1;
 
-      host->totalSentData += sentLength;
-      host->totalSentPackets++;
+      currentPeer->totalSentData += sentLength;
+      currentPeer->totalSentPackets++;
 
     nextPeer:
-      if (currentPeer->flags & ENET_PEER_FLAG_CONTINUE_SENDING)
+      enet_host_update_peer_dirty(host, currentPeer);
+      enet_host_schedule_peer(host, currentPeer);
+
+      if (currentPeer->flags & ENET_PEER_FLAG_CONTINUE_SENDING) {
+        /* keep the peer's datagrams adjacent so they can leave as one
+           segmented write */
+        if ((host->offloadFlags & ENET_HOST_OFFLOAD_GSO) &&
+            currentPeer->state != ENET_PEER_STATE_DISCONNECTED &&
+            currentPeer->state != ENET_PEER_STATE_ZOMBIE)
+          goto nextDatagram;
+
         continueSending = sendPass + 1;
+      }
     }
 
-  return 0;
+  return enet_protocol_flush_datagrams(host) < 0 ? -1 : 0;
 }
 
 /** Sends any queued packets on the host specified to its designated peers.
@@ -1886,11 +2232,80 @@ static int enet_protocol_send_outgoing_commands(ENetHost *host,
     @ingroup host
 */
 void enet_host_flush(ENetHost *host) {
-  host->serviceTime = enet_time_get();
+  host->serviceTime = enet_host_time(host);
 
   enet_protocol_send_outgoing_commands(host, NULL, 0);
 }
 
+/** Computes how long the host can sit idle before it needs to be serviced
+    again, so that event-driven callers can sleep on the socket instead of
+    polling.
+
+    @param host    host to inspect
+    @param timeout receives the number of milliseconds until the next
+   retransmit, ping or throttle deadline; 0 if work is already pending
+    @retval 1 if a deadline exists and was written to timeout
+    @retval 0 if the host has no pending deadlines and only needs servicing
+   when the socket becomes readable
+    @ingroup host
+*/
+int enet_host_next_timeout(ENetHost *host, enet_uint32 *timeout) {
+  enet_uint32 currentTime = enet_host_time(host), nextTime = 0, peerTime;
+  int hasDeadline = 0;
+
+  /* datagrams left in the receive batch by an event are already off the
+     socket, so it will not become readable for them */
+  if (!enet_list_empty(&host->dispatchQueue) ||
+      host->receiveBatchIndex < host->receiveBatchCount) {
+    *timeout = 0;
+    return 1;
+  }
+
+  if (host->connectedPeers > 0) {
+    if (host->bandwidthThrottleInterval != 0) {
+      nextTime = host->bandwidthThrottleEpoch + host->bandwidthThrottleInterval;
+      hasDeadline = 1;
+    } else if (host->recalculateBandwidthLimits) {
+      *timeout = 0;
+      return 1;
+    }
+  }
+
+  /* Queued commands that survived a send pass while reliable data is in
+     flight are waiting on the window, and an acknowledgement will wake the
+     socket, so only an unblocked queue means immediate work. */
+  for (ENetPeer *currentPeer = host->dirtyPeers; currentPeer != NULL;
+       currentPeer = currentPeer->dirtyNext) {
+    if (currentPeer->state == ENET_PEER_STATE_DISCONNECTED ||
+        currentPeer->state == ENET_PEER_STATE_ZOMBIE)
+      continue;
+
+    if (!enet_list_empty(&currentPeer->acknowledgements) ||
+        (enet_list_empty(&currentPeer->sentReliableCommands) &&
+         (!enet_list_empty(&currentPeer->outgoingCommands) ||
+          !enet_list_empty(&currentPeer->outgoingSendReliableCommands)))) {
+      *timeout = 0;
+      return 1;
+    }
+  }
+
+  /* every other peer is filed in the wheel under its retransmit or ping
+     deadline */
+  if (enet_timer_wheel_next(&host->timerWheel, &peerTime) &&
+      (!hasDeadline || ENET_TIME_LESS(peerTime, nextTime))) {
+    nextTime = peerTime;
+    hasDeadline = 1;
+  }
+
+  if (!hasDeadline)
+    return 0;
+
+  *timeout = ENET_TIME_LESS_EQUAL(nextTime, currentTime)
+                 ? 0
+                 : ENET_TIME_DIFFERENCE(nextTime, currentTime);
+  return 1;
+}
+
 /** Checks for any queued events on the host and dispatches one if available.
 
     @param host    host to check for events
@@ -1912,6 +2327,127 @@ int enet_host_check_events(ENetHost *host, ENetEvent *event) {
   return enet_protocol_dispatch_incoming_commands(host, event);
 }
 
+/** Reads and handles the datagrams waiting on the host's socket without
+    sending anything, then dispatches one queued event. Acknowledgements,
+    retransmits and the commands this produces stay queued until the next
+    enet_host_transmit(), enet_host_flush() or enet_host_service().
+
+    @param host    host to receive on
+    @param event   an event structure where event details will be placed if
+   one occurs
+    @retval > 0 if an event was dispatched
+    @retval 0 if no event occurred
+    @retval < 0 on failure
+    @remarks like enet_host_service(), at most 256 datagrams are read per call
+    @ingroup host
+*/
+int enet_host_receive(ENetHost *host, ENetEvent *event) {
+  if (event == NULL)
+    return -1;
+
+  event->type = ENET_EVENT_TYPE_NONE;
+  event->peer = NULL;
+  event->packet = NULL;
+
+  switch (enet_protocol_dispatch_incoming_commands(host, event)) {
+  case 1:
+    return 1;
+
+  case -1:
+    return -1;
+
+  default:
+    break;
+  }
+
+  host->serviceTime = enet_host_time(host);
+
+  switch (enet_protocol_receive_incoming_commands(host, event)) {
+  case 1:
+    return 1;
+
+  case -1:
+    return -1;
+
+  default:
+    break;
+  }
+
+  return enet_protocol_dispatch_incoming_commands(host, event);
+}
+
+/** Sends everything queued on the host in a single pass over its peers:
+    acknowledgements, retransmits, pings and outgoing commands, packed into as
+    few datagrams as the peers' MTUs allow. Unlike enet_host_flush() this also
+    checks for timeouts, so it can stand in for the send half of
+    enet_host_service() in a fixed-rate loop. Peers that time out are reported
+    through the next enet_host_receive() or enet_host_check_events().
+
+    @param host    host to transmit on
+    @retval 0 on success
+    @retval < 0 on failure
+    @ingroup host
+*/
+int enet_host_transmit(ENetHost *host) {
+  host->serviceTime = enet_host_time(host);
+
+  if (host->bandwidthThrottleInterval != 0
+          ? ENET_TIME_DIFFERENCE(host->serviceTime,
+                                 host->bandwidthThrottleEpoch) >=
+                host->bandwidthThrottleInterval
+          : host->recalculateBandwidthLimits)
+    enet_host_bandwidth_throttle(host);
+
+  return enet_protocol_send_outgoing_commands(host, NULL, 1) < 0 ? -1 : 0;
+}
+
+/** Handles a datagram as though it had just been read from the host's socket.
+    The intercept callback is not consulted, so this can feed captured or
+    synthetic traffic to a host for testing, replay or benchmarking.
+    @param host    host to deliver the datagram to
+    @param address address the datagram appears to come from
+    @param data    datagram contents, starting with the protocol header
+    @param dataLength length of the datagram, at most ENET_PROTOCOL_MAXIMUM_MTU
+    @param event   an event structure where event details will be placed if the
+   datagram completes one, or NULL
+    @retval > 0 if an event was produced
+    @retval 0 if no event was produced
+    @retval < 0 on failure
+    @ingroup host
+*/
+int enet_host_inject(ENetHost *host, const ENetAddress *address,
+                     const void *data, size_t dataLength, ENetEvent *event) {
+  int result;
+
+  if (dataLength > sizeof(host->packetData[0]))
+    return -1;
+
+  if (event != NULL) {
+    event->type = ENET_EVENT_TYPE_NONE;
+    event->peer = NULL;
+    event->packet = NULL;
+  }
+
+  memcpy(host->packetData[0], data, dataLength);
+
+  host->serviceTime = enet_host_time(host);
+  host->receivedAddress = *address;
+  host->receivedData = host->packetData[0];
+  host->receivedDataLength = dataLength;
+
+  host->totalReceivedData += dataLength;
+  host->totalReceivedPackets++;
+
+  {
+    ENET_INSTRUMENT_BEGIN(host, protocolStart);
+
+    result = enet_protocol_handle_incoming_commands(host, event);
+    ENET_INSTRUMENT_END(host, ENET_INSTRUMENT_STAGE_PROTOCOL, protocolStart);
+  }
+
+  return result;
+}
+
 /** Waits for events on the host specified and shuttles packets between
     the host and its peers.
 
@@ -1950,13 +2486,16 @@ int enet_host_service(ENetHost *host, ENetEvent *event, enet_uint32 timeout) {
     }
   }
 
-  host->serviceTime = enet_time_get();
+  host->serviceTime = enet_host_time(host);
 
   timeout += host->serviceTime;
 
   do {
-    if (ENET_TIME_DIFFERENCE(host->serviceTime, host->bandwidthThrottleEpoch) >=
-        ENET_HOST_BANDWIDTH_THROTTLE_INTERVAL)
+    if (host->bandwidthThrottleInterval != 0
+            ? ENET_TIME_DIFFERENCE(host->serviceTime,
+                                   host->bandwidthThrottleEpoch) >=
+                  host->bandwidthThrottleInterval
+            : host->recalculateBandwidthLimits)
       enet_host_bandwidth_throttle(host);
 
     switch (enet_protocol_send_outgoing_commands(host, event, 1)) {
@@ -2025,7 +2564,7 @@ int enet_host_service(ENetHost *host, ENetEvent *event, enet_uint32 timeout) {
       return 0;
 
     do {
-      host->serviceTime = enet_time_get();
+      host->serviceTime = enet_host_time(host);
 
       if (ENET_TIME_GREATER_EQUAL(host->serviceTime, timeout))
         return 0;
@@ -2038,7 +2577,7 @@ int enet_host_service(ENetHost *host, ENetEvent *event, enet_uint32 timeout) {
         return -1;
     } while (waitCondition & ENET_SOCKET_WAIT_INTERRUPT);
 
-    host->serviceTime = enet_time_get();
+    host->serviceTime = enet_host_time(host);
   } while (waitCondition & ENET_SOCKET_WAIT_RECEIVE);
 
   return 0;
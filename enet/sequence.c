@@ -0,0 +1,149 @@
+/**
+ @file sequence.c
+ @brief ENet reliable sequence number index
+*/
+#include <string.h>
+#define ENET_BUILDING_LIB 1
+#include "enet/enet.h"
+
+/**
+    @defgroup sequence ENet sequence index functions
+    @ingroup private
+    @{
+*/
+
+void
+enet_sequence_index_init (ENetSequenceIndex * index)
+{
+   index -> slots = NULL;
+   index -> size = 0;
+   index -> count = 0;
+}
+
+void
+enet_sequence_index_destroy (ENetSequenceIndex * index)
+{
+   if (index -> slots != NULL)
+     enet_free (index -> slots);
+
+   enet_sequence_index_init (index);
+}
+
+#define ENET_SEQUENCE_INDEX_HOME(index, sequenceNumber) ((sequenceNumber) & ((index) -> size - 1))
+
+static ENetSequenceSlot *
+enet_sequence_index_probe (const ENetSequenceIndex * index, enet_uint16 sequenceNumber)
+{
+   size_t position = ENET_SEQUENCE_INDEX_HOME (index, sequenceNumber);
+
+   /* the table is never more than half full, so a free slot ends every probe */
+   while (index -> slots [position].item != NULL &&
+          index -> slots [position].sequenceNumber != sequenceNumber)
+     position = (position + 1) & (index -> size - 1);
+
+   return & index -> slots [position];
+}
+
+static int
+enet_sequence_index_resize (ENetSequenceIndex * index, size_t size)
+{
+   ENetSequenceSlot * slots = (ENetSequenceSlot *) enet_malloc (size * sizeof (ENetSequenceSlot)),
+                    * oldSlots = index -> slots,
+                    * slot;
+   size_t oldSize = index -> size;
+
+   if (slots == NULL)
+     return -1;
+
+   memset (slots, 0, size * sizeof (ENetSequenceSlot));
+
+   index -> slots = slots;
+   index -> size = size;
+
+   if (oldSlots != NULL)
+   {
+      for (slot = oldSlots; slot < & oldSlots [oldSize]; ++ slot)
+        if (slot -> item != NULL)
+          * enet_sequence_index_probe (index, slot -> sequenceNumber) = * slot;
+
+      enet_free (oldSlots);
+   }
+
+   return 0;
+}
+
+/** Files item under sequenceNumber, replacing whatever was filed under the
+    same number.
+    @returns 0 on success, < 0 if the table could not grow
+*/
+int
+enet_sequence_index_insert (ENetSequenceIndex * index, enet_uint16 sequenceNumber, void * item)
+{
+   ENetSequenceSlot * slot;
+
+   if (index -> slots == NULL &&
+       enet_sequence_index_resize (index, ENET_SEQUENCE_INDEX_MINIMUM_SIZE) < 0)
+     return -1;
+
+   slot = enet_sequence_index_probe (index, sequenceNumber);
+   if (slot -> item == NULL)
+   {
+      if ((index -> count + 1) * 2 > index -> size)
+      {
+         if (enet_sequence_index_resize (index, index -> size * 2) < 0)
+           return -1;
+
+         slot = enet_sequence_index_probe (index, sequenceNumber);
+      }
+
+      ++ index -> count;
+   }
+
+   slot -> item = item;
+   slot -> sequenceNumber = sequenceNumber;
+
+   return 0;
+}
+
+void
+enet_sequence_index_remove (ENetSequenceIndex * index, enet_uint16 sequenceNumber)
+{
+   size_t hole, position, home, mask;
+
+   if (index -> count == 0)
+     return;
+
+   mask = index -> size - 1;
+   hole = enet_sequence_index_probe (index, sequenceNumber) - index -> slots;
+   if (index -> slots [hole].item == NULL)
+     return;
+
+   /* pull later members of the probe run back over the hole, so that no run
+      is cut short by an empty slot */
+   for (position = (hole + 1) & mask;
+        index -> slots [position].item != NULL;
+        position = (position + 1) & mask)
+   {
+      home = ENET_SEQUENCE_INDEX_HOME (index, index -> slots [position].sequenceNumber);
+      if (((position - home) & mask) >= ((position - hole) & mask))
+      {
+         index -> slots [hole] = index -> slots [position];
+         hole = position;
+      }
+   }
+
+   index -> slots [hole].item = NULL;
+   -- index -> count;
+}
+
+/** Returns the item filed under sequenceNumber, or NULL. */
+void *
+enet_sequence_index_find (const ENetSequenceIndex * index, enet_uint16 sequenceNumber)
+{
+   if (index -> count == 0)
+     return NULL;
+
+   return enet_sequence_index_probe (index, sequenceNumber) -> item;
+}
+
+/** @} */
@@ -0,0 +1,234 @@
+/** 
+ @file timer.c
+ @brief ENet hierarchical timer wheel
+*/
+#include <string.h>
+#define ENET_BUILDING_LIB 1
+#include "enet/enet.h"
+#include "enet/time.h"
+
+/** 
+    @defgroup timer ENet timer wheel functions
+    @ingroup private
+    @{
+*/
+
+#define ENET_TIMER_WHEEL_MASK (ENET_TIMER_WHEEL_SLOTS - 1)
+#define ENET_TIMER_WHEEL_SPAN(level) ((enet_uint32) 1 << (ENET_TIMER_WHEEL_BITS * (level)))
+
+void
+enet_timer_wheel_init (ENetTimerWheel * wheel, enet_uint32 now)
+{
+   int level, index;
+
+   wheel -> current = now;
+   wheel -> count = 0;
+
+   memset (wheel -> occupied, 0, sizeof (wheel -> occupied));
+
+   for (level = 0; level < ENET_TIMER_WHEEL_LEVELS; ++ level)
+     for (index = 0; index < ENET_TIMER_WHEEL_SLOTS; ++ index)
+       enet_list_clear (& wheel -> slots [level] [index]);
+}
+
+/** Files a timer under deadline, moving it if it was already scheduled. A
+    deadline that has already passed expires on the next enet_timer_wheel_expire().
+*/
+void
+enet_timer_schedule (ENetTimerWheel * wheel, ENetTimer * timer, enet_uint32 deadline)
+{
+   enet_uint32 delta, placed = deadline;
+   int level, index;
+
+   if (timer -> slot != ENET_TIMER_UNSCHEDULED)
+     enet_timer_cancel (wheel, timer);
+
+   timer -> deadline = deadline;
+
+   if (ENET_TIME_LESS (placed, wheel -> current))
+     placed = wheel -> current;
+
+   delta = placed - wheel -> current;
+   if (delta >= ENET_TIMER_WHEEL_SPAN (ENET_TIMER_WHEEL_LEVELS))
+   {
+      delta = ENET_TIMER_WHEEL_SPAN (ENET_TIMER_WHEEL_LEVELS) - 1;
+      placed = wheel -> current + delta;
+   }
+
+   for (level = 0; delta >= ENET_TIMER_WHEEL_SPAN (level + 1); ++ level)
+     ;
+
+   index = (placed >> (ENET_TIMER_WHEEL_BITS * level)) & ENET_TIMER_WHEEL_MASK;
+
+   enet_list_insert (enet_list_end (& wheel -> slots [level] [index]), & timer -> node);
+   wheel -> occupied [level] [index / 32] |= 1u << (index % 32);
+   timer -> slot = (enet_uint16) (level * ENET_TIMER_WHEEL_SLOTS + index);
+   ++ wheel -> count;
+}
+
+void
+enet_timer_cancel (ENetTimerWheel * wheel, ENetTimer * timer)
+{
+   int level, index;
+
+   if (timer -> slot == ENET_TIMER_UNSCHEDULED)
+     return;
+
+   level = timer -> slot / ENET_TIMER_WHEEL_SLOTS;
+   index = timer -> slot % ENET_TIMER_WHEEL_SLOTS;
+
+   enet_list_remove (& timer -> node);
+   if (enet_list_empty (& wheel -> slots [level] [index]))
+     wheel -> occupied [level] [index / 32] &= ~ (1u << (index % 32));
+
+   timer -> slot = ENET_TIMER_UNSCHEDULED;
+   -- wheel -> count;
+}
+
+/** Returns the first occupied slot at or after index on a level, or
+    ENET_TIMER_WHEEL_SLOTS if there is none before the end of the level.
+*/
+static int
+enet_timer_wheel_find (const ENetTimerWheel * wheel, int level, int index)
+{
+   while (index < ENET_TIMER_WHEEL_SLOTS)
+   {
+      enet_uint32 bits = wheel -> occupied [level] [index / 32] >> (index % 32);
+
+      if (bits != 0)
+      {
+         while (! (bits & 1))
+         {
+            bits >>= 1;
+            ++ index;
+         }
+         return index;
+      }
+
+      index = (index / 32 + 1) * 32;
+   }
+
+   return ENET_TIMER_WHEEL_SLOTS;
+}
+
+static void
+enet_timer_wheel_cascade (ENetTimerWheel * wheel, int level, int index)
+{
+   ENetList * slot = & wheel -> slots [level] [index];
+
+   wheel -> occupied [level] [index / 32] &= ~ (1u << (index % 32));
+
+   while (! enet_list_empty (slot))
+   {
+      ENetTimer * timer = (ENetTimer *) enet_list_remove (enet_list_begin (slot));
+
+      timer -> slot = ENET_TIMER_UNSCHEDULED;
+      -- wheel -> count;
+
+      enet_timer_schedule (wheel, timer, timer -> deadline);
+   }
+}
+
+/** Moves every timer whose deadline is at or before now onto expired, marking
+    each one unscheduled. Empty stretches of the wheel are skipped a whole
+    level 0 span at a time.
+*/
+void
+enet_timer_wheel_expire (ENetTimerWheel * wheel, enet_uint32 now, ENetList * expired)
+{
+   while (ENET_TIME_LESS_EQUAL (wheel -> current, now))
+   {
+      int index = wheel -> current & ENET_TIMER_WHEEL_MASK, next;
+      enet_uint32 step, remaining;
+
+      if (wheel -> count == 0)
+      {
+         wheel -> current = now + 1;
+         return;
+      }
+
+      if (index == 0)
+      {
+         int middle = (wheel -> current >> ENET_TIMER_WHEEL_BITS) & ENET_TIMER_WHEEL_MASK;
+
+         if (middle == 0)
+           enet_timer_wheel_cascade (wheel, 2, (wheel -> current >> (ENET_TIMER_WHEEL_BITS * 2)) & ENET_TIMER_WHEEL_MASK);
+
+         enet_timer_wheel_cascade (wheel, 1, middle);
+      }
+
+      if (wheel -> occupied [0] [index / 32] & (1u << (index % 32)))
+      {
+         ENetList * slot = & wheel -> slots [0] [index];
+
+         wheel -> occupied [0] [index / 32] &= ~ (1u << (index % 32));
+
+         while (! enet_list_empty (slot))
+         {
+            ENetTimer * timer = (ENetTimer *) enet_list_remove (enet_list_begin (slot));
+
+            timer -> slot = ENET_TIMER_UNSCHEDULED;
+            -- wheel -> count;
+
+            enet_list_insert (enet_list_end (expired), & timer -> node);
+         }
+      }
+
+      next = enet_timer_wheel_find (wheel, 0, index + 1);
+      step = (enet_uint32) (next - index);
+      remaining = now - wheel -> current + 1;
+
+      wheel -> current += step < remaining ? step : remaining;
+   }
+}
+
+/** Computes the earliest time the wheel needs expiring again: the exact
+    deadline of a level 0 timer, or the moment a higher slot cascades, which
+    is never after the deadlines filed under it.
+
+    @retval 1 if the wheel holds a timer and next was written
+    @retval 0 if the wheel is empty
+*/
+int
+enet_timer_wheel_next (const ENetTimerWheel * wheel, enet_uint32 * next)
+{
+   int level, found = 0;
+
+   if (wheel -> count == 0)
+     return 0;
+
+   for (level = 0; level < ENET_TIMER_WHEEL_LEVELS; ++ level)
+   {
+      int shift = ENET_TIMER_WHEEL_BITS * level, start, index, distance;
+      enet_uint32 base = wheel -> current >> shift, candidate;
+
+      /* a higher slot cascades when current enters its span, so the one
+         current is already inside holds the next lap */
+      if (level > 0 && (wheel -> current & (ENET_TIMER_WHEEL_SPAN (level) - 1)) != 0)
+        ++ base;
+
+      start = base & ENET_TIMER_WHEEL_MASK;
+      index = enet_timer_wheel_find (wheel, level, start);
+      if (index < ENET_TIMER_WHEEL_SLOTS)
+        distance = index - start;
+      else
+      {
+         index = enet_timer_wheel_find (wheel, level, 0);
+         if (index >= ENET_TIMER_WHEEL_SLOTS)
+           continue;
+         distance = index + ENET_TIMER_WHEEL_SLOTS - start;
+      }
+
+      candidate = (base + distance) << shift;
+
+      if (! found || ENET_TIME_LESS (candidate, * next))
+      {
+         * next = candidate;
+         found = 1;
+      }
+   }
+
+   return found;
+}
+
+/** @} */
@@ -4,6 +4,10 @@
 */
 #ifndef _WIN32
 
+#if (defined(linux) || defined(__linux) || defined(__linux__)) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE 1
+#endif
+
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
@@ -45,6 +49,28 @@
 #endif
 #endif
 
+#if defined(linux) || defined(__linux) || defined(__linux__)
+#ifndef HAS_RECVMMSG
+#define HAS_RECVMMSG 1
+#endif
+#ifndef HAS_SENDMMSG
+#define HAS_SENDMMSG 1
+#endif
+#endif
+
+#if defined(linux) || defined(__linux) || defined(__linux__)
+#include <netinet/udp.h>
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif
+
 #ifdef HAS_FCNTL
 #include <fcntl.h>
 #endif
@@ -61,6 +87,12 @@ typedef int socklen_t;
 #define MSG_NOSIGNAL 0
 #endif
 
+/* CLOCK_MONOTONIC is served from the vDSO on Linux; builds that can live with
+   scheduler-tick resolution may define ENET_TIME_CLOCK=CLOCK_MONOTONIC_COARSE */
+#ifndef ENET_TIME_CLOCK
+#define ENET_TIME_CLOCK CLOCK_MONOTONIC
+#endif
+
 static enet_uint32 timeBase = 0;
 
 static int addressFamily[] = {
@@ -191,24 +223,32 @@ enet_host_random_seed (void)
     return (enet_uint32) time (NULL);
 }
 
-enet_uint32
-enet_time_get (void)
+enet_uint64
+enet_time_get_ns (void)
 {
-    struct timeval timeVal;
+    struct timespec timeSpec;
 
-    gettimeofday (& timeVal, NULL);
+    clock_gettime (ENET_TIME_CLOCK, & timeSpec);
 
-    return timeVal.tv_sec * 1000 + timeVal.tv_usec / 1000 - timeBase;
+    return (enet_uint64) timeSpec.tv_sec * 1000000000ULL + (enet_uint64) timeSpec.tv_nsec;
+}
+
+enet_uint32
+enet_time_from_ns (enet_uint64 time)
+{
+    return (enet_uint32) (time / 1000000) - timeBase;
+}
+
+enet_uint32
+enet_time_get (void)
+{
+    return enet_time_from_ns (enet_time_get_ns ());
 }
 
 void
 enet_time_set (enet_uint32 newTimeBase)
 {
-    struct timeval timeVal;
-
-    gettimeofday (& timeVal, NULL);
-    
-    timeBase = timeVal.tv_sec * 1000 + timeVal.tv_usec / 1000 - newTimeBase;
+    timeBase = (enet_uint32) (enet_time_get_ns () / 1000000) - newTimeBase;
 }
 
 int
@@ -444,6 +484,24 @@ enet_socket_set_option (ENetSocket socket, ENetSocketOption option, int value)
             result = setsockopt(socket, IPPROTO_IPV6, IPV6_V6ONLY, (char *) & value, sizeof(int));
             break;
 
+#ifdef UDP_SEGMENT
+        case ENET_SOCKOPT_UDP_SEGMENT:
+            result = setsockopt (socket, SOL_UDP, UDP_SEGMENT, (char *) & value, sizeof (int));
+            break;
+#endif
+
+#ifdef UDP_GRO
+        case ENET_SOCKOPT_UDP_GRO:
+            result = setsockopt (socket, SOL_UDP, UDP_GRO, (char *) & value, sizeof (int));
+            break;
+#endif
+
+#ifdef SO_REUSEPORT
+        case ENET_SOCKOPT_REUSEPORT:
+            result = setsockopt (socket, SOL_SOCKET, SO_REUSEPORT, (char *) & value, sizeof (int));
+            break;
+#endif
+
         default:
             break;
     }
@@ -607,6 +665,299 @@ enet_socket_receive (ENetSocket socket,
     return recvLength;
 }
 
+int
+enet_socket_send_batch (ENetSocket socket,
+                        const ENetAddress * addresses,
+                        const ENetBuffer * buffers,
+                        size_t datagramCount)
+{
+#ifdef HAS_SENDMMSG
+    unsigned char sockAddrBufs [ENET_SOCKET_BATCH_MAXIMUM] [sizeof(struct sockaddr_in6)];
+    struct mmsghdr msgHdrs [ENET_SOCKET_BATCH_MAXIMUM];
+    size_t sentCount = 0;
+
+    while (sentCount < datagramCount)
+    {
+        size_t chunkCount = datagramCount - sentCount, chunkSent = 0, i;
+
+        if (chunkCount > ENET_SOCKET_BATCH_MAXIMUM)
+          chunkCount = ENET_SOCKET_BATCH_MAXIMUM;
+
+        memset (msgHdrs, 0, chunkCount * sizeof (struct mmsghdr));
+
+        for (i = 0; i < chunkCount; ++ i)
+        {
+            struct msghdr * msgHdr = & msgHdrs [i].msg_hdr;
+
+            if (addresses != NULL)
+            {
+                msgHdr -> msg_namelen = enet_address_to_sock_addr (& addresses [sentCount + i], sockAddrBufs [i]);
+                if (msgHdr -> msg_namelen == 0)
+                  return -1;
+
+                msgHdr -> msg_name = (struct sockaddr *) sockAddrBufs [i];
+            }
+
+            msgHdr -> msg_iov = (struct iovec *) & buffers [sentCount + i];
+            msgHdr -> msg_iovlen = 1;
+        }
+
+        while (chunkSent < chunkCount)
+        {
+            int result = sendmmsg (socket, & msgHdrs [chunkSent], chunkCount - chunkSent, MSG_NOSIGNAL);
+
+            if (result == -1)
+            {
+               /* like enet_socket_send, datagrams that would block are dropped */
+               if (errno == EWOULDBLOCK)
+                 return (int) (sentCount + chunkSent);
+
+               return -1;
+            }
+
+            chunkSent += result;
+        }
+
+        sentCount += chunkCount;
+    }
+
+    return (int) sentCount;
+#else
+    size_t sentCount;
+
+    for (sentCount = 0; sentCount < datagramCount; ++ sentCount)
+    {
+        int sentLength = enet_socket_send (socket, addresses != NULL ? & addresses [sentCount] : NULL, & buffers [sentCount], 1);
+
+        if (sentLength < 0)
+          return -1;
+
+        if (sentLength == 0)
+          break;
+    }
+
+    return (int) sentCount;
+#endif
+}
+
+int
+enet_socket_receive_batch (ENetSocket socket,
+                           ENetAddress * addresses,
+                           ENetBuffer * buffers,
+                           int * receivedLengths,
+                           size_t datagramCount)
+{
+#ifdef HAS_RECVMMSG
+    unsigned char sockAddrBufs [ENET_SOCKET_BATCH_MAXIMUM] [sizeof(struct sockaddr_in6)];
+    struct mmsghdr msgHdrs [ENET_SOCKET_BATCH_MAXIMUM];
+    int receivedCount, i;
+
+    if (datagramCount > ENET_SOCKET_BATCH_MAXIMUM)
+      datagramCount = ENET_SOCKET_BATCH_MAXIMUM;
+
+    memset (msgHdrs, 0, datagramCount * sizeof (struct mmsghdr));
+
+    for (i = 0; i < (int) datagramCount; ++ i)
+    {
+        struct msghdr * msgHdr = & msgHdrs [i].msg_hdr;
+
+        if (addresses != NULL)
+        {
+            memset (sockAddrBufs [i], 0, sizeof (sockAddrBufs [i]));
+            msgHdr -> msg_name = (struct sockaddr *) sockAddrBufs [i];
+            msgHdr -> msg_namelen = sizeof (sockAddrBufs [i]);
+        }
+
+        msgHdr -> msg_iov = (struct iovec *) & buffers [i];
+        msgHdr -> msg_iovlen = 1;
+    }
+
+    receivedCount = recvmmsg (socket, msgHdrs, datagramCount, MSG_NOSIGNAL, NULL);
+
+    if (receivedCount == -1)
+    {
+       if (errno == EWOULDBLOCK)
+         return 0;
+
+       return -1;
+    }
+
+    for (i = 0; i < receivedCount; ++ i)
+    {
+        receivedLengths [i] = (int) msgHdrs [i].msg_len;
+
+#ifdef HAS_MSGHDR_FLAGS
+        if (msgHdrs [i].msg_hdr.msg_flags & MSG_TRUNC)
+        {
+            receivedLengths [i] = -2;
+            continue;
+        }
+#endif
+
+        if (addresses != NULL &&
+            enet_address_from_sock_addr (& addresses [i], (struct sockaddr *) sockAddrBufs [i]) != 0)
+          return -1;
+    }
+
+    return receivedCount;
+#else
+    size_t receivedCount;
+
+    for (receivedCount = 0; receivedCount < datagramCount; ++ receivedCount)
+    {
+        int receivedLength = enet_socket_receive (socket, addresses != NULL ? & addresses [receivedCount] : NULL, & buffers [receivedCount], 1);
+
+        if (receivedLength < 0 && receivedLength != -2)
+          return receivedCount > 0 ? (int) receivedCount : -1;
+
+        if (receivedLength == 0)
+          break;
+
+        receivedLengths [receivedCount] = receivedLength;
+    }
+
+    return (int) receivedCount;
+#endif
+}
+
+int
+enet_socket_send_segments (ENetSocket socket,
+                           const ENetAddress * address,
+                           const ENetBuffer * buffers,
+                           size_t bufferCount,
+                           size_t segmentSize)
+{
+#ifdef UDP_SEGMENT
+    unsigned char sockAddrBuf[sizeof(struct sockaddr_in6)];
+    union
+    {
+        char buffer [CMSG_SPACE (sizeof (enet_uint16))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msgHdr;
+    struct cmsghdr * cmsg;
+    enet_uint16 gsoSize = (enet_uint16) segmentSize;
+    int sentLength;
+
+    memset (& msgHdr, 0, sizeof (struct msghdr));
+    memset (& control, 0, sizeof (control));
+
+    if (address != NULL)
+    {
+        msgHdr.msg_namelen = enet_address_to_sock_addr(address, sockAddrBuf);
+        if (msgHdr.msg_namelen == 0)
+            return -1;
+
+        msgHdr.msg_name = (struct sockaddr *) sockAddrBuf;
+    }
+
+    msgHdr.msg_iov = (struct iovec *) buffers;
+    msgHdr.msg_iovlen = bufferCount;
+    msgHdr.msg_control = control.buffer;
+    msgHdr.msg_controllen = sizeof (control.buffer);
+
+    cmsg = CMSG_FIRSTHDR (& msgHdr);
+    cmsg -> cmsg_level = SOL_UDP;
+    cmsg -> cmsg_type = UDP_SEGMENT;
+    cmsg -> cmsg_len = CMSG_LEN (sizeof (enet_uint16));
+    memcpy (CMSG_DATA (cmsg), & gsoSize, sizeof (enet_uint16));
+
+    sentLength = sendmsg (socket, & msgHdr, MSG_NOSIGNAL);
+
+    if (sentLength == -1)
+    {
+       if (errno == EWOULDBLOCK)
+         return 0;
+
+       /* the device or path cannot segment, callers fall back to plain sends */
+       if (errno == EIO || errno == EINVAL || errno == EOPNOTSUPP || errno == ENOPROTOOPT)
+         return -2;
+
+       return -1;
+    }
+
+    return sentLength;
+#else
+    return -2;
+#endif
+}
+
+int
+enet_socket_receive_segments (ENetSocket socket,
+                              ENetAddress * address,
+                              ENetBuffer * buffer,
+                              size_t * segmentSize)
+{
+    unsigned char sockAddrBuf[sizeof(struct sockaddr_in6)] = { 0 };
+    struct msghdr msgHdr;
+    int recvLength;
+#ifdef UDP_GRO
+    union
+    {
+        char buffer [CMSG_SPACE (sizeof (int))];
+        struct cmsghdr align;
+    } control;
+    struct cmsghdr * cmsg;
+#endif
+
+    memset (& msgHdr, 0, sizeof (struct msghdr));
+
+    if (address != NULL)
+    {
+        msgHdr.msg_name = (struct sockaddr*) &sockAddrBuf;
+        msgHdr.msg_namelen = sizeof(sockAddrBuf);
+    }
+
+    msgHdr.msg_iov = (struct iovec *) buffer;
+    msgHdr.msg_iovlen = 1;
+
+#ifdef UDP_GRO
+    memset (& control, 0, sizeof (control));
+    msgHdr.msg_control = control.buffer;
+    msgHdr.msg_controllen = sizeof (control.buffer);
+#endif
+
+    recvLength = recvmsg (socket, & msgHdr, MSG_NOSIGNAL);
+
+    if (recvLength == -1)
+    {
+       if (errno == EWOULDBLOCK)
+         return 0;
+
+       return -1;
+    }
+
+#ifdef HAS_MSGHDR_FLAGS
+    if (msgHdr.msg_flags & MSG_TRUNC)
+      return -2;
+#endif
+
+    * segmentSize = (size_t) recvLength;
+
+#ifdef UDP_GRO
+    for (cmsg = CMSG_FIRSTHDR (& msgHdr); cmsg != NULL; cmsg = CMSG_NXTHDR (& msgHdr, cmsg))
+    {
+        if (cmsg -> cmsg_level == SOL_UDP && cmsg -> cmsg_type == UDP_GRO)
+        {
+            int gsoSize;
+
+            memcpy (& gsoSize, CMSG_DATA (cmsg), sizeof (int));
+            if (gsoSize > 0)
+              * segmentSize = (size_t) gsoSize;
+            break;
+        }
+    }
+#endif
+
+    if (address != NULL)
+    {
+        if (enet_address_from_sock_addr(address, (struct sockaddr*) sockAddrBuf) != 0)
+            return -1;
+    }
+
+    return recvLength;
+}
+
 int
 enet_socketset_select (ENetSocket maxSocket, ENetSocketSet * readSet, ENetSocketSet * writeSet, enet_uint32 timeout)
 {
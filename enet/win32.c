@@ -166,16 +166,39 @@ enet_host_random_seed (void)
     return (enet_uint32) timeGetTime ();
 }
 
+enet_uint64
+enet_time_get_ns (void)
+{
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0)
+      QueryPerformanceFrequency (& frequency);
+    QueryPerformanceCounter (& counter);
+
+    /* split the conversion so the multiplication cannot overflow */
+    return (enet_uint64) (counter.QuadPart / frequency.QuadPart) * 1000000000ULL +
+           (enet_uint64) (counter.QuadPart % frequency.QuadPart) * 1000000000ULL / (enet_uint64) frequency.QuadPart;
+}
+
+/* the performance counter rather than timeGetTime (), so that the millisecond
+   clock shares its origin with enet_time_get_ns () */
+enet_uint32
+enet_time_from_ns (enet_uint64 time)
+{
+    return (enet_uint32) (time / 1000000) - timeBase;
+}
+
 enet_uint32
 enet_time_get (void)
 {
-    return (enet_uint32) timeGetTime () - timeBase;
+    return enet_time_from_ns (enet_time_get_ns ());
 }
 
 void
 enet_time_set (enet_uint32 newTimeBase)
 {
-    timeBase = (enet_uint32) timeGetTime () - newTimeBase;
+    timeBase = (enet_uint32) (enet_time_get_ns () / 1000000) - newTimeBase;
 }
 
 int
@@ -506,6 +529,77 @@ enet_socket_receive (ENetSocket socket,
     return (int) recvLength;
 }
 
+int
+enet_socket_send_batch (ENetSocket socket,
+                        const ENetAddress * addresses,
+                        const ENetBuffer * buffers,
+                        size_t datagramCount)
+{
+    size_t sentCount;
+
+    for (sentCount = 0; sentCount < datagramCount; ++ sentCount)
+    {
+        int sentLength = enet_socket_send (socket, addresses != NULL ? & addresses [sentCount] : NULL, & buffers [sentCount], 1);
+
+        if (sentLength < 0)
+          return -1;
+
+        if (sentLength == 0)
+          break;
+    }
+
+    return (int) sentCount;
+}
+
+int
+enet_socket_receive_batch (ENetSocket socket,
+                           ENetAddress * addresses,
+                           ENetBuffer * buffers,
+                           int * receivedLengths,
+                           size_t datagramCount)
+{
+    size_t receivedCount;
+
+    for (receivedCount = 0; receivedCount < datagramCount; ++ receivedCount)
+    {
+        int receivedLength = enet_socket_receive (socket, addresses != NULL ? & addresses [receivedCount] : NULL, & buffers [receivedCount], 1);
+
+        if (receivedLength < 0 && receivedLength != -2)
+          return receivedCount > 0 ? (int) receivedCount : -1;
+
+        if (receivedLength == 0)
+          break;
+
+        receivedLengths [receivedCount] = receivedLength;
+    }
+
+    return (int) receivedCount;
+}
+
+int
+enet_socket_send_segments (ENetSocket socket,
+                           const ENetAddress * address,
+                           const ENetBuffer * buffers,
+                           size_t bufferCount,
+                           size_t segmentSize)
+{
+    return -2;
+}
+
+int
+enet_socket_receive_segments (ENetSocket socket,
+                              ENetAddress * address,
+                              ENetBuffer * buffer,
+                              size_t * segmentSize)
+{
+    int recvLength = enet_socket_receive (socket, address, buffer, 1);
+
+    if (recvLength > 0)
+      * segmentSize = (size_t) recvLength;
+
+    return recvLength;
+}
+
 int
 enet_socketset_select (ENetSocket maxSocket, ENetSocketSet * readSet, ENetSocketSet * writeSet, enet_uint32 timeout)
 {
@@ -24,7 +24,9 @@
 
 // @note type declarations for gtenet to improve editor intellisense
 
-export type PeerId = bigint;
+// @note (generation << 12) | slot; a handle stops matching once its peer disconnects, so stale ids are
+// @note rejected instead of reaching freed memory (sends return -1, disconnects do nothing)
+export type PeerId = number;
 
 export interface ConnectEvent {
   type: 'connect';
@@ -44,6 +46,18 @@ export interface ReceiveEvent {
   data: Buffer;
 }
 
+// @note one fragment of a reliable message on a streaming channel; fragments arrive in order
+export interface ReceiveChunkEvent {
+  type: 'receiveChunk';
+  peer: PeerId;
+  channelID: number;
+  // @note byte offset of this chunk within its message
+  offset: number;
+  // @note true on the chunk that completes the message
+  final: boolean;
+  data: Buffer;
+}
+
 export interface UnknownEvent {
   type: 'unknown';
 }
@@ -52,9 +66,140 @@ export type ENetEvent =
   | ConnectEvent
   | DisconnectEvent
   | ReceiveEvent
+  | ReceiveChunkEvent
   | UnknownEvent;
 
-export type BaseEventName = 'connect' | 'disconnect' | 'receive' | 'error';
+export type BaseEventName = 'connect' | 'disconnect' | 'receive' | 'receiveChunk' | 'error';
+
+export interface PoolStats {
+  inUse: number;
+  free: number;
+  peakInUse: number;
+  allocations: number;
+  reuses: number;
+}
+
+export interface HostPoolStats {
+  outgoingCommands: PoolStats;
+  acknowledgements: PoolStats;
+  incomingCommands: PoolStats;
+  fragmentBitmaps: PoolStats;
+}
+
+export interface MemoryStats {
+  inUse: number;
+  highWater: number;
+  reserved: number;
+  limit: number;
+  failures: number;
+}
+
+export type CompressionAlgorithm = 'range' | 'lz4';
+
+export interface CompressionStats {
+  algorithm: CompressionAlgorithm;
+  threshold: number;
+  // @note packets sent compressed, tried but sent as-is, and below the threshold
+  compressed: number;
+  incompressible: number;
+  skipped: number;
+  // @note bytes before and after compression for the packets sent compressed; ratio is bytesOut / bytesIn
+  bytesIn: number;
+  bytesOut: number;
+  ratio: number;
+  compressNs: number;
+  decompressed: number;
+  decompressedBytesIn: number;
+  decompressedBytesOut: number;
+  decompressNs: number;
+}
+
+// @note a Float64Array loses precision past 2^53; use a BigUint64Array for exact totals
+export type StatsArray = Float64Array | BigUint64Array;
+
+// @note durations in nanoseconds; percentiles are within 1/16th of the recorded value
+export interface LatencyHistogram {
+  count: number;
+  min: number;
+  max: number;
+  mean: number;
+  p50: number;
+  p90: number;
+  p99: number;
+  p999: number;
+}
+
+export interface NetworkConditions {
+  // @note probability in [0, 1] that a received datagram is dropped
+  loss?: number;
+  // @note milliseconds every received datagram is held back
+  latency?: number;
+  // @note up to this many extra milliseconds per datagram, which may reorder them
+  jitter?: number;
+}
+
+export interface NetworkConditionStats extends Required<NetworkConditions> {
+  dropped: number;
+  delayed: number;
+  // @note datagrams currently held back
+  pending: number;
+}
+
+export interface CaptureOptions {
+  // @note also record sent datagrams (default false)
+  send?: boolean;
+  // @note bytes buffered between the host and the file writer, a power of two (default 4 MiB)
+  bufferSize?: number;
+}
+
+export interface CaptureStats {
+  records: number;
+  // @note file size, header included
+  bytes: number;
+  // @note datagrams lost because the writer fell behind or the file could not grow
+  dropped: number;
+}
+
+export interface ReplayOptions {
+  // @note multiplier on the captured timing, 0 replays as fast as possible (default 1)
+  speed?: number;
+}
+
+export interface ReplayStats {
+  delivered: number;
+  total: number;
+  done: boolean;
+  // @note the capture started after peers had connected; their datagrams are dropped
+  partial: boolean;
+}
+
+export interface EventRingOptions {
+  // @note record slots, a power of two (default 4096)
+  capacity?: number;
+  // @note payload bytes, a power of two (default 4 MiB); larger packets are dropped and counted
+  arenaSize?: number;
+  // @note receive handler without allocation; arena[offset, offset + length) is only valid during the call
+  onReceive?: (peer: PeerId, channelID: number, arena: Uint8Array, offset: number, length: number) => void;
+}
+
+export interface EventRing {
+  // @note EVENT_RING header followed by the records
+  ring: Uint32Array;
+  arena: Uint8Array;
+}
+
+export interface LatencyHistograms {
+  // @note one receive system call
+  socketReceive: LatencyHistogram;
+  // @note handling the commands of one datagram
+  protocol: LatencyHistogram;
+  // @note producing one event from the dispatch queue
+  dispatch: LatencyHistogram;
+  // @note turning one event into a js object (not recorded in threaded mode)
+  conversion: LatencyHistogram;
+  // @note from queuing an outgoing command to its first transmission
+  queueToWire: LatencyHistogram;
+}
 
 export interface ServerOptions {
   ip?: string;
@@ -66,7 +211,40 @@ export interface ServerOptions {
   incomingBandwidth?: number;
   outgoingBandwidth?: number;
   checksum?: boolean;
-  compression?: boolean;
+  // @note true is the range coder; both ends must use the same algorithm and dictionary
+  compression?: boolean | CompressionAlgorithm;
+  // @note packets with fewer payload bytes are sent uncompressed
+  compressionThreshold?: number;
+  // @note preset dictionary for lz4, up to 32 KiB of typical payload bytes
+  compressionDictionary?: Buffer | Uint8Array | ArrayBuffer;
+  // @note service from a libuv socket watcher (default) instead of timer polling
+  eventDriven?: boolean;
+  // @note service on a native network thread; takes precedence over eventDriven
+  threaded?: boolean;
+  // @note send runs of datagrams to one peer as a single UDP_SEGMENT write (linux)
+  gso?: boolean;
+  // @note receive kernel coalesced datagrams with UDP_GRO (linux)
+  gro?: boolean;
+  // @note cap in bytes on native enet memory, shared by every host in the process; 0 is unlimited.
+  // @note The cap stays in effect for hosts created later, and leaving this out keeps it
+  memoryLimit?: number;
+  // @note record latency histograms of the service pipeline, read with getLatencyHistograms();
+  // @note only in addons built with --enet_instrument=true
+  instrument?: boolean;
+  // @note bind with SO_REUSEPORT so several servers share the port (linux, bsd, macos)
+  reusePort?: boolean;
+  // @note channels whose reliable messages are delivered as receiveChunk events instead of being reassembled
+  streamChannels?: number[];
+  // @note priority of each channel by index, 0-255 (default 0); higher priority channels fill datagrams first
+  channelPriorities?: number[];
+  // @note bytes all peers together may hold in partially reassembled messages (default 256 MiB)
+  maxReassemblyData?: number;
+  // @note the same budget for a single peer (default 32 MiB + 128 KiB); fragments are retried while others hold the budget, a reliable message larger than it disconnects the peer
+  maxPeerReassemblyData?: number;
+  // @note periodic packet throttle rebalancing against bandwidth limits (default true)
+  bandwidthThrottle?: boolean;
+  // @note milliseconds between throttle rebalances (default 1000)
+  bandwidthThrottleInterval?: number;
 }
 
 export interface ClientOptions {
@@ -78,7 +256,38 @@ export interface ClientOptions {
   incomingBandwidth?: number;
   outgoingBandwidth?: number;
   checksum?: boolean;
-  compression?: boolean;
+  // @note true is the range coder; both ends must use the same algorithm and dictionary
+  compression?: boolean | CompressionAlgorithm;
+  // @note packets with fewer payload bytes are sent uncompressed
+  compressionThreshold?: number;
+  // @note preset dictionary for lz4, up to 32 KiB of typical payload bytes
+  compressionDictionary?: Buffer | Uint8Array | ArrayBuffer;
+  // @note service from a libuv socket watcher (default) instead of timer polling
+  eventDriven?: boolean;
+  // @note service on a native network thread; takes precedence over eventDriven
+  threaded?: boolean;
+  // @note send runs of datagrams to one peer as a single UDP_SEGMENT write (linux)
+  gso?: boolean;
+  // @note receive kernel coalesced datagrams with UDP_GRO (linux)
+  gro?: boolean;
+  // @note cap in bytes on native enet memory, shared by every host in the process; 0 is unlimited.
+  // @note The cap stays in effect for hosts created later, and leaving this out keeps it
+  memoryLimit?: number;
+  // @note record latency histograms of the service pipeline, read with getLatencyHistograms();
+  // @note only in addons built with --enet_instrument=true
+  instrument?: boolean;
+  // @note channels whose reliable messages are delivered as receiveChunk events instead of being reassembled
+  streamChannels?: number[];
+  // @note priority of each channel by index, 0-255 (default 0); higher priority channels fill datagrams first
+  channelPriorities?: number[];
+  // @note bytes all peers together may hold in partially reassembled messages (default 256 MiB)
+  maxReassemblyData?: number;
+  // @note the same budget for a single peer (default 32 MiB + 128 KiB); fragments are retried while others hold the budget, a reliable message larger than it disconnects the peer
+  maxPeerReassemblyData?: number;
+  // @note periodic packet throttle rebalancing against bandwidth limits (default true)
+  bandwidthThrottle?: boolean;
+  // @note milliseconds between throttle rebalances (default 1000)
+  bandwidthThrottleInterval?: number;
 }
 
 /**
@@ -91,6 +300,7 @@ export class Server {
   on(event: 'connect', handler: (event: ConnectEvent) => void): this;
   on(event: 'disconnect', handler: (event: DisconnectEvent) => void): this;
   on(event: 'receive', handler: (event: ReceiveEvent) => void): this;
+  on(event: 'receiveChunk', handler: (event: ReceiveChunkEvent) => void): this;
   on(event: 'error', handler: (error: Error) => void): this;
   on(event: 'ready', handler: () => void): this;
   off(event: BaseEventName | 'ready', handler: (...args: any[]) => void): this;
@@ -103,8 +313,31 @@ export class Server {
 
   // @note host/event loop
   service(timeout?: number): ENetEvent | null;
+  serviceBatch(maxEvents?: number, timeout?: number): ENetEvent[];
   listen(pollIntervalMs?: number, maxPollIntervalMs?: number): Promise<void>;
   stop(): void;
+  getPoolStats(): HostPoolStats | null;
+  getMemoryStats(): MemoryStats | null;
+  getCompressionStats(): CompressionStats | null;
+  getHostStats<T extends StatsArray = Float64Array>(out?: T): T | null;
+  getPeerStats(peerIds: PeerId[] | null | undefined, out: StatsArray): number;
+  setInstrument(enable?: boolean): boolean;
+  getLatencyHistograms(): LatencyHistograms | null;
+  setNetworkConditions(conditions?: NetworkConditions | null): boolean;
+  getNetworkConditions(): NetworkConditionStats | null;
+  startCapture(path: string, options?: CaptureOptions): boolean;
+  stopCapture(): CaptureStats | null;
+  getCaptureStats(): CaptureStats | null;
+  startReplay(path: string, options?: ReplayOptions): number | null;
+  stopReplay(): ReplayStats | null;
+  getReplayStats(): ReplayStats | null;
+  enableEventRing(options?: EventRingOptions | null): EventRing | null;
+  drainEventRing(): number;
+  serviceRing(maxEvents?: number, timeout?: number): number;
+  // @note manual tick mode: receiveAll() and flushAll() split enet_host_service into its halves
+  receiveAll(maxEvents?: number): number;
+  flushAll(): void;
+  listenTicked(rate: number, step: (tick: number, missed: number) => void): Promise<void>;
 
   // @note server setup
   createServer(): Promise<boolean>;
@@ -124,10 +357,31 @@ export class Server {
     data: Buffer | Uint8Array | ArrayBuffer,
     flags?: number,
   ): number;
+  // @note pins data until enet releases the packet; do not mutate it meanwhile
+  sendZeroCopy(
+    peerId: PeerId,
+    channelId: number,
+    data: Buffer | Uint8Array | ArrayBuffer,
+    flags?: number,
+  ): number;
   disconnect(peerId: PeerId, data?: number): void;
   disconnectNow(peerId: PeerId, data?: number): void;
   disconnectLater(peerId: PeerId, data?: number): void;
+  // @note priority 0-255 of one channel of a connected peer; new peers start from channelPriorities
+  setChannelPriority(peerId: PeerId, channelId: number, priority: number): boolean;
   broadcast(channelId: number, data: Buffer | string, reliable?: boolean): void;
+  sendToMany(
+    peerIds: PeerId[],
+    channelId: number,
+    data: Buffer | string,
+    reliable?: boolean,
+  ): number;
+  // @note descriptors holds SEND_MANY.RECORD_STRIDE words per message; results is reused when given
+  sendMany(
+    descriptors: Uint32Array,
+    payload: Buffer | Uint8Array | ArrayBuffer,
+    results?: Int32Array,
+  ): Int32Array | null;
 }
 
 /**
@@ -140,6 +394,7 @@ export class Client {
   on(event: 'connect', handler: (event: ConnectEvent) => void): this;
   on(event: 'disconnect', handler: (event: DisconnectEvent) => void): this;
   on(event: 'receive', handler: (event: ReceiveEvent) => void): this;
+  on(event: 'receiveChunk', handler: (event: ReceiveChunkEvent) => void): this;
   on(event: 'error', handler: (error: Error) => void): this;
   off(event: BaseEventName, handler: (...args: any[]) => void): this;
   once(event: BaseEventName, handler: (...args: any[]) => void): this;
@@ -151,11 +406,35 @@ export class Client {
 
   // @note host/event loop
   service(timeout?: number): ENetEvent | null;
+  serviceBatch(maxEvents?: number, timeout?: number): ENetEvent[];
   stop(): void;
+  getPoolStats(): HostPoolStats | null;
+  getMemoryStats(): MemoryStats | null;
+  getCompressionStats(): CompressionStats | null;
+  getHostStats<T extends StatsArray = Float64Array>(out?: T): T | null;
+  getPeerStats(peerIds: PeerId[] | null | undefined, out: StatsArray): number;
+  setInstrument(enable?: boolean): boolean;
+  getLatencyHistograms(): LatencyHistograms | null;
+  setNetworkConditions(conditions?: NetworkConditions | null): boolean;
+  getNetworkConditions(): NetworkConditionStats | null;
+  startCapture(path: string, options?: CaptureOptions): boolean;
+  stopCapture(): CaptureStats | null;
+  getCaptureStats(): CaptureStats | null;
+  startReplay(path: string, options?: ReplayOptions): number | null;
+  stopReplay(): ReplayStats | null;
+  getReplayStats(): ReplayStats | null;
+  enableEventRing(options?: EventRingOptions | null): EventRing | null;
+  drainEventRing(): number;
+  serviceRing(maxEvents?: number, timeout?: number): number;
+  // @note manual tick mode: receiveAll() and flushAll() split enet_host_service into its halves
+  receiveAll(maxEvents?: number): number;
+  flushAll(): void;
+  listenTicked(rate: number, step: (tick: number, missed: number) => void): Promise<void>;
   flush(): void;
 
   // @note connection helpers
-  connect(options?: { timeoutMs?: number }): Promise<void>;
+  // @note channelPriorities overrides the config value for this connection
+  connect(options?: { timeoutMs?: number; channelPriorities?: number[] }): Promise<void>;
 
   // @note instance methods target connected server by default
   send(channelId: number, data: Buffer | string, reliable?: boolean): number;
@@ -164,9 +443,15 @@ export class Client {
     data: Buffer | Uint8Array | ArrayBuffer,
     flags?: number,
   ): number;
+  sendZeroCopy(
+    channelId: number,
+    data: Buffer | Uint8Array | ArrayBuffer,
+    flags?: number,
+  ): number;
   disconnect(data?: number): void;
   disconnectNow(data?: number): void;
   disconnectLater(data?: number): void;
+  setChannelPriority(channelId: number, priority: number): boolean;
 
   // @note still expose low-level methods via Base class through TS, but Client overrides instance signatures
   // The Client instance methods above shadow the base signatures that include peerId.
@@ -175,12 +460,93 @@ export class Client {
   serverPeer: PeerId | null;
 }
 
+// @note fractional milliseconds on ENet's monotonic clock, the one retransmit, timeout and tick deadlines use
+export function now(): number;
+
 // @note packet flags (mirror ENet constants)
 export const PACKET_FLAG_RELIABLE: 1;
 export const PACKET_FLAG_UNSEQUENCED: 2;
 export const PACKET_FLAG_NO_ALLOCATE: 4;
 export const PACKET_FLAG_UNRELIABLE_FRAGMENT: 8;
 export const PACKET_FLAG_SENT: 256;
+// @note set on the flags of the chunk that completes a streamed message
+export const PACKET_FLAG_LAST_CHUNK: 512;
+
+// @note stats layout: index into getHostStats() output, or row * PEER_STATS_STRIDE + field for getPeerStats()
+export const HOST_STATS: {
+  readonly TOTAL_SENT_DATA: 0;
+  readonly TOTAL_SENT_PACKETS: 1;
+  readonly TOTAL_RECEIVED_DATA: 2;
+  readonly TOTAL_RECEIVED_PACKETS: 3;
+  readonly PEER_COUNT: 4;
+  readonly CONNECTED_PEERS: 5;
+  readonly BANDWIDTH_LIMITED_PEERS: 6;
+  readonly INCOMING_BANDWIDTH: 7;
+  readonly OUTGOING_BANDWIDTH: 8;
+  readonly SERVICE_TIME: 9;
+  readonly OUTGOING_COMMANDS: 10;
+  readonly ACKNOWLEDGEMENTS: 11;
+  readonly INCOMING_COMMANDS: 12;
+  readonly TOTAL_RETRANSMITS: 13;
+  readonly RELIABLE_DATA_IN_TRANSIT: 14;
+  readonly TOTAL_WAITING_DATA: 15;
+  readonly REASSEMBLY_DATA: 16;
+};
+export const HOST_STATS_LENGTH: 17;
+
+export const PEER_STATS: {
+  readonly ID: 0;
+  readonly INCOMING_PEER_ID: 1;
+  readonly STATE: 2;
+  readonly ROUND_TRIP_TIME: 3;
+  readonly ROUND_TRIP_TIME_VARIANCE: 4;
+  readonly LOWEST_ROUND_TRIP_TIME: 5;
+  // @note fraction of ENET_PEER_PACKET_LOSS_SCALE (65536)
+  readonly PACKET_LOSS: 6;
+  readonly PACKET_THROTTLE: 7;
+  readonly PACKET_THROTTLE_LIMIT: 8;
+  readonly MTU: 9;
+  readonly RELIABLE_DATA_IN_TRANSIT: 10;
+  readonly TOTAL_WAITING_DATA: 11;
+  readonly TOTAL_SENT_DATA: 12;
+  readonly TOTAL_SENT_PACKETS: 13;
+  readonly TOTAL_RECEIVED_DATA: 14;
+  readonly TOTAL_RECEIVED_PACKETS: 15;
+  readonly TOTAL_RETRANSMITS: 16;
+  readonly REASSEMBLY_DATA: 17;
+};
+export const PEER_STATS_STRIDE: 18;
+
+// @note sendMany() layout: record * RECORD_STRIDE + field
+export const SEND_MANY: {
+  readonly PEER: 0;
+  readonly CHANNEL: 1;
+  readonly FLAGS: 2;
+  readonly OFFSET: 3;
+  readonly LENGTH: 4;
+  readonly RECORD_STRIDE: 5;
+};
+
+// @note event ring layout: header words, then record * RECORD_STRIDE + field from HEADER_LENGTH on
+export const EVENT_RING: {
+  readonly WRITE: 0;
+  readonly READ: 1;
+  readonly CAPACITY: 2;
+  readonly DROPPED: 3;
+  readonly HEADER_LENGTH: 8;
+  readonly TYPE: 0;
+  readonly PEER: 1;
+  readonly CHANNEL: 2;
+  readonly OFFSET: 3;
+  readonly LENGTH: 4;
+  readonly DATA: 5;
+  readonly FLAGS: 6;
+  readonly RECORD_STRIDE: 8;
+  readonly TYPE_CONNECT: 1;
+  readonly TYPE_DISCONNECT: 2;
+  readonly TYPE_RECEIVE: 3;
+  readonly TYPE_RECEIVE_CHUNK: 4;
+};
 
 // @note default export for convenience
 export default {
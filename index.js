@@ -39,11 +39,90 @@ try {
   throw err;
 }
 
+// @note milliseconds on the monotonic clock ENet and the tick scheduler run on
+const now = () => enet.ENet.now();
+
 const PACKET_FLAG_RELIABLE = 1;
 const PACKET_FLAG_UNSEQUENCED = 2;
 const PACKET_FLAG_NO_ALLOCATE = 4;
 const PACKET_FLAG_UNRELIABLE_FRAGMENT = 8;
 const PACKET_FLAG_SENT = 256;
+const PACKET_FLAG_LAST_CHUNK = 512;
+
+// @note field indices of getHostStats() and of each getPeerStats() row; mirrors the native layout
+const HOST_STATS = Object.freeze({
+  TOTAL_SENT_DATA: 0,
+  TOTAL_SENT_PACKETS: 1,
+  TOTAL_RECEIVED_DATA: 2,
+  TOTAL_RECEIVED_PACKETS: 3,
+  PEER_COUNT: 4,
+  CONNECTED_PEERS: 5,
+  BANDWIDTH_LIMITED_PEERS: 6,
+  INCOMING_BANDWIDTH: 7,
+  OUTGOING_BANDWIDTH: 8,
+  SERVICE_TIME: 9,
+  OUTGOING_COMMANDS: 10,
+  ACKNOWLEDGEMENTS: 11,
+  INCOMING_COMMANDS: 12,
+  TOTAL_RETRANSMITS: 13,
+  RELIABLE_DATA_IN_TRANSIT: 14,
+  TOTAL_WAITING_DATA: 15,
+  REASSEMBLY_DATA: 16,
+});
+const HOST_STATS_LENGTH = 17;
+
+const PEER_STATS = Object.freeze({
+  ID: 0,
+  INCOMING_PEER_ID: 1,
+  STATE: 2,
+  ROUND_TRIP_TIME: 3,
+  ROUND_TRIP_TIME_VARIANCE: 4,
+  LOWEST_ROUND_TRIP_TIME: 5,
+  PACKET_LOSS: 6,
+  PACKET_THROTTLE: 7,
+  PACKET_THROTTLE_LIMIT: 8,
+  MTU: 9,
+  RELIABLE_DATA_IN_TRANSIT: 10,
+  TOTAL_WAITING_DATA: 11,
+  TOTAL_SENT_DATA: 12,
+  TOTAL_SENT_PACKETS: 13,
+  TOTAL_RECEIVED_DATA: 14,
+  TOTAL_RECEIVED_PACKETS: 15,
+  TOTAL_RETRANSMITS: 16,
+  REASSEMBLY_DATA: 17,
+});
+const PEER_STATS_STRIDE = 18;
+
+// @note sendMany() descriptor layout: RECORD_STRIDE words per message, byte range into the shared payload
+const SEND_MANY = Object.freeze({
+  PEER: 0,
+  CHANNEL: 1,
+  FLAGS: 2,
+  OFFSET: 3,
+  LENGTH: 4,
+  RECORD_STRIDE: 5,
+});
+
+// @note layout of the event ring: header words, then RECORD_STRIDE words per record; mirrors the native layout
+const EVENT_RING = Object.freeze({
+  WRITE: 0,
+  READ: 1,
+  CAPACITY: 2,
+  DROPPED: 3,
+  HEADER_LENGTH: 8,
+  TYPE: 0,
+  PEER: 1,
+  CHANNEL: 2,
+  OFFSET: 3,
+  LENGTH: 4,
+  DATA: 5,
+  FLAGS: 6,
+  RECORD_STRIDE: 8,
+  TYPE_CONNECT: 1,
+  TYPE_DISCONNECT: 2,
+  TYPE_RECEIVE: 3,
+  TYPE_RECEIVE_CHUNK: 4,
+});
 
 /**
  * base wrapper for common enet host/peer management and event dispatch
@@ -61,6 +140,17 @@ class ENetBase {
     };
     this.running = false;
     this.hostCreated = false;
+    // @note upper bound of events drained per native service call
+    this.maxEventsPerService = 256;
+    // @note service from a native socket watcher instead of timer polling
+    this.eventDriven = true;
+    // @note run enet service on a dedicated native thread; events are posted back to js
+    this.threaded = false;
+    // @note offload modes the socket accepted, set when gso or gro is requested
+    this.offload = null;
+    // @note shared record ring and payload arena while enableEventRing() is on
+    this.eventRing = null;
+    this.stopListening = null;
   }
 
   initialize() {
@@ -118,14 +208,34 @@ class ENetBase {
   }
 
   setupHost(config, isServer = false) {
-    // @note enable compression and checksum
-    this.native.setCompression(!!config.compression);
+    // @note enable compression and checksum; true keeps the range coder, 'lz4' trades ratio for speed
+    if (config.compression) {
+      this.native.setCompression(
+        config.compression === true ? 'range' : config.compression,
+        {
+          threshold: config.compressionThreshold,
+          dictionary: config.compressionDictionary,
+        },
+      );
+    } else {
+      this.native.setCompression(false);
+    }
     this.native.setChecksum(!!config.checksum);
 
     // @note optionally enable new packet mode
     if (config.usingNewPacket || config.usingNewPacketForServer) {
       this.native.setNewPacket(true, isServer);
     }
+
+    // @note optionally record latency histograms of the service pipeline
+    if (config.instrument) {
+      this.native.setInstrument(true);
+    }
+
+    // @note optionally enable udp segmentation offload (linux only, ignored elsewhere)
+    if (config.gso || config.gro) {
+      this.offload = this.native.setOffload(!!config.gso, !!config.gro);
+    }
   }
 
   // @note check if a udp port is available
@@ -167,6 +277,118 @@ class ENetBase {
     return event;
   }
 
+  serviceBatch(maxEvents = this.maxEventsPerService, timeout = 0) {
+    // @note one native call services the host and drains the dispatch queue
+    if (!this.hostCreated) {
+      return [];
+    }
+    const events = this.native.hostServiceBatch(maxEvents, timeout);
+    for (let i = 0; i < events.length; i++) {
+      this.handleEvent(events[i]);
+    }
+    return events;
+  }
+
+  enableEventRing(options = {}) {
+    // @note native code writes events into shared memory instead of building js objects; null turns it off
+    try {
+      if (options === null || options === false) {
+        const pending = this.native.attachEventRing(null);
+        // @note hand out whatever was written before the ring was detached, then the event held back for it
+        this.drainEventRing();
+        this.eventRing = null;
+        if (pending) {
+          this.handleEvent(pending);
+        }
+        return null;
+      }
+      const capacity = options.capacity || 4096;
+      const arenaSize = options.arenaSize || 1 << 22;
+      const ring = new Uint32Array(
+        new SharedArrayBuffer((EVENT_RING.HEADER_LENGTH + capacity * EVENT_RING.RECORD_STRIDE) * 4),
+      );
+      const arena = new Uint8Array(new SharedArrayBuffer(arenaSize));
+      this.drainEventRing();
+      this.native.attachEventRing(ring, arena);
+      this.eventRing = {
+        ring,
+        arena,
+        bytes: Buffer.from(arena.buffer),
+        mask: capacity - 1,
+        read: 0,
+        onReceive: options.onReceive || null,
+      };
+      return this.eventRing;
+    } catch (err) {
+      this.emit('error', err);
+      return null;
+    }
+  }
+
+  drainEventRing() {
+    // @note consume every published record, then give the space back to the native writer
+    const state = this.eventRing;
+    if (!state) {
+      return 0;
+    }
+    const { ring, arena, bytes, mask, onReceive } = state;
+    const write = Atomics.load(ring, EVENT_RING.WRITE);
+    let read = state.read;
+    let count = 0;
+    while (read !== write) {
+      const base = EVENT_RING.HEADER_LENGTH + (read & mask) * EVENT_RING.RECORD_STRIDE;
+      const type = ring[base + EVENT_RING.TYPE];
+      const peer = ring[base + EVENT_RING.PEER];
+      if (type === EVENT_RING.TYPE_RECEIVE) {
+        const offset = ring[base + EVENT_RING.OFFSET];
+        const length = ring[base + EVENT_RING.LENGTH];
+        if (onReceive) {
+          // @note arena bytes are only valid until this drain returns
+          try {
+            onReceive(peer, ring[base + EVENT_RING.CHANNEL], arena, offset, length);
+          } catch (err) {
+            this.emit('error', err);
+          }
+        } else {
+          this.handleEvent({
+            type: 'receive',
+            peer,
+            channelID: ring[base + EVENT_RING.CHANNEL],
+            data: Buffer.from(bytes.subarray(offset, offset + length)),
+          });
+        }
+      } else if (type === EVENT_RING.TYPE_RECEIVE_CHUNK) {
+        const offset = ring[base + EVENT_RING.OFFSET];
+        this.handleEvent({
+          type: 'receiveChunk',
+          peer,
+          channelID: ring[base + EVENT_RING.CHANNEL],
+          offset: ring[base + EVENT_RING.DATA],
+          final: (ring[base + EVENT_RING.FLAGS] & PACKET_FLAG_LAST_CHUNK) !== 0,
+          data: Buffer.from(bytes.subarray(offset, offset + ring[base + EVENT_RING.LENGTH])),
+        });
+      } else if (type === EVENT_RING.TYPE_CONNECT) {
+        this.handleEvent({ type: 'connect', peer });
+      } else if (type === EVENT_RING.TYPE_DISCONNECT) {
+        this.handleEvent({ type: 'disconnect', peer, data: ring[base + EVENT_RING.DATA] });
+      }
+      read = (read + 1) >>> 0;
+      count++;
+    }
+    state.read = read;
+    Atomics.store(ring, EVENT_RING.READ, read);
+    return count;
+  }
+
+  serviceRing(maxEvents = this.maxEventsPerService, timeout = 0) {
+    // @note serviceBatch() through the event ring; returns the number of records consumed
+    if (!this.hostCreated || !this.eventRing) {
+      return 0;
+    }
+    this.native.hostServiceRing(maxEvents, timeout);
+    return this.drainEventRing();
+  }
+
   handleEvent(event) {
     // @note update internal state and re-emit
     try {
@@ -191,6 +413,9 @@ class ENetBase {
         case 'receive':
           this.emit('receive', event);
           break;
+        case 'receiveChunk':
+          this.emit('receiveChunk', event);
+          break;
         default:
           this.emit('error', new Error(`Unknown event type: ${event.type}`));
       }
@@ -220,6 +445,16 @@ class ENetBase {
     }
   }
 
+  sendZeroCopy(peerId, channelId, data, flags = PACKET_FLAG_RELIABLE) {
+    // @note enet reads the given memory in place until the packet is sent; do not mutate it meanwhile
+    try {
+      return this.native.sendZeroCopy(peerId, channelId, data, flags);
+    } catch (err) {
+      this.emit('error', err);
+      return -1;
+    }
+  }
+
   disconnect(peerId, data = 0) {
     // @note request graceful disconnect and clean up
     try {
@@ -250,9 +485,20 @@ class ENetBase {
     }
   }
 
+  setChannelPriority(peerId, channelId, priority) {
+    // @note changes one channel of a connected peer; returns false for an unknown peer or channel
+    try {
+      return this.native.setChannelPriority(peerId, channelId, priority);
+    } catch (err) {
+      this.emit('error', err);
+      return false;
+    }
+  }
+
   destroy() {
     // @note destroy host and reset local state
     try {
+      this.stop();
       this.native.destroyHost();
       this.peers.clear();
       this.hostCreated = false;
@@ -262,13 +508,29 @@ class ENetBase {
   }
 
   async listen(pollIntervalMs = 2, maxPollIntervalMs = 32) {
-    // @note simple loop: poll service and yield briefly (configurable interval)
+    if (this.threaded) {
+      return this.listenThreaded();
+    }
+    if (this.eventDriven) {
+      return this.listenEventDriven();
+    }
+
+    // @note simple loop: drain events in batches and yield briefly (configurable interval)
     this.running = true;
     let currentInterval = pollIntervalMs;
     while (this.running) {
       try {
-        const event = this.service(currentInterval);
-        if (event) {
+        const maxEvents = this.maxEventsPerService;
+        const count = this.eventRing
+          ? this.serviceRing(maxEvents, currentInterval)
+          : this.serviceBatch(maxEvents, currentInterval).length;
+        if (count >= maxEvents) {
+          // @note batch was capped, more events are likely queued; skip the timer hop
+          currentInterval = pollIntervalMs;
+          await new Promise(resolve => setImmediate(resolve));
+          continue;
+        }
+        if (count > 0) {
           currentInterval = pollIntervalMs;
         } else {
           currentInterval = Math.min(currentInterval * 2, maxPollIntervalMs);
@@ -281,9 +543,267 @@ class ENetBase {
     }
   }
 
+  listenEventDriven() {
+    // @note native side services the host when the socket is readable or an enet deadline is due
+    this.running = true;
+    return new Promise(resolve => {
+      if (this.stopListening) {
+        this.stopListening();
+      }
+      this.stopListening = resolve;
+      this.native.startPoll((events, error) => {
+        if (error) {
+          this.emit('error', error);
+          return;
+        }
+        // @note ring mode only passes a record count
+        if (typeof events === 'number') {
+          this.drainEventRing();
+          return;
+        }
+        for (let i = 0; i < events.length; i++) {
+          this.handleEvent(events[i]);
+        }
+      }, this.maxEventsPerService);
+    });
+  }
+
+  listenThreaded() {
+    // @note sends and disconnects are queued to the network thread until stop()
+    this.running = true;
+    return new Promise(resolve => {
+      if (this.stopListening) {
+        this.stopListening();
+      }
+      this.stopListening = resolve;
+      this.native.startThread((events, error) => {
+        if (error) {
+          this.emit('error', error);
+          return;
+        }
+        // @note ring mode only passes a record count
+        if (typeof events === 'number') {
+          this.drainEventRing();
+          return;
+        }
+        for (let i = 0; i < events.length; i++) {
+          this.handleEvent(events[i]);
+        }
+      }, { maxEvents: this.maxEventsPerService });
+    });
+  }
+
+  receiveAll(maxEvents = 0) {
+    // @note read and dispatch everything waiting without sending; acks and replies go out with flushAll()
+    if (!this.hostCreated) {
+      return 0;
+    }
+    try {
+      const result = this.native.receiveAll(maxEvents);
+      if (typeof result === 'number') {
+        return this.drainEventRing();
+      }
+      for (let i = 0; i < result.length; i++) {
+        this.handleEvent(result[i]);
+      }
+      return result.length;
+    } catch (err) {
+      this.emit('error', err);
+      return 0;
+    }
+  }
+
+  flushAll() {
+    // @note one send pass over every peer, packing all queued commands into as few datagrams as possible
+    try {
+      this.native.flushAll();
+    } catch (err) {
+      this.emit('error', err);
+    }
+  }
+
+  listenTicked(rate, step) {
+    // @note fixed-rate manual mode: receiveAll(), step(tick, missed), then a single flushAll() per tick
+    this.running = true;
+    return new Promise(resolve => {
+      if (this.stopListening) {
+        this.stopListening();
+      }
+      this.stopListening = resolve;
+      this.native.startTick(1000 / rate, (tick, missed) => {
+        this.receiveAll();
+        try {
+          step(tick, missed);
+        } catch (err) {
+          this.emit('error', err);
+        }
+        this.flushAll();
+      });
+    });
+  }
+
   stop() {
     // @note stop listen loop
     this.running = false;
+    if (this.stopListening) {
+      const resolve = this.stopListening;
+      this.stopListening = null;
+      if (this.threaded) {
+        this.native.stopThread();
+      } else {
+        this.native.stopPoll();
+        this.native.stopTick();
+      }
+      resolve();
+    }
+  }
+
+  getPoolStats() {
+    // @note usage counters of the host's protocol object pools
+    try {
+      return this.native.getPoolStats();
+    } catch (err) {
+      this.emit('error', err);
+      return null;
+    }
+  }
+
+  getMemoryStats() {
+    // @note process-wide counters of the native allocator backing enet
+    try {
+      return this.native.getMemoryStats();
+    } catch (err) {
+      this.emit('error', err);
+      return null;
+    }
+  }
+
+  getCompressionStats() {
+    // @note packet counts, bytes and time spent in the host's compressor; null when compression is off
+    try {
+      return this.native.getCompressionStats();
+    } catch (err) {
+      this.emit('error', err);
+      return null;
+    }
+  }
+
+  getHostStats(out = new Float64Array(HOST_STATS_LENGTH)) {
+    // @note writes HOST_STATS fields into out; reuse one array when polling to avoid allocating
+    try {
+      return this.native.getHostStats(out);
+    } catch (err) {
+      this.emit('error', err);
+      return null;
+    }
+  }
+
+  getPeerStats(peerIds, out) {
+    // @note writes PEER_STATS_STRIDE fields per peer into out, every occupied slot when peerIds is omitted; returns the row count
+    try {
+      return this.native.getPeerStats(peerIds || null, out);
+    } catch (err) {
+      this.emit('error', err);
+      return 0;
+    }
+  }
+
+  setInstrument(enable = true) {
+    // @note start (and clear) or stop the latency histograms; false if the addon was built without them
+    try {
+      return this.native.setInstrument(!!enable);
+    } catch (err) {
+      this.emit('error', err);
+      return false;
+    }
+  }
+
+  getLatencyHistograms() {
+    // @note per stage count, min, max, mean and percentiles in nanoseconds; null when not instrumenting
+    try {
+      return this.native.getLatencyHistograms();
+    } catch (err) {
+      this.emit('error', err);
+      return null;
+    }
+  }
+
+  setNetworkConditions(conditions = null) {
+    // @note drop or delay received datagrams for testing; null or all zero restores the plain network
+    try {
+      return this.native.setNetworkConditions(conditions);
+    } catch (err) {
+      this.emit('error', err);
+      return false;
+    }
+  }
+
+  getNetworkConditions() {
+    // @note current settings plus dropped, delayed and pending datagram counts; null when unconditioned
+    try {
+      return this.native.getNetworkConditions();
+    } catch (err) {
+      this.emit('error', err);
+      return null;
+    }
+  }
+
+  startCapture(path, options = {}) {
+    // @note record received datagrams, and sent ones with send: true, to a file until stopCapture
+    try {
+      return this.native.startCapture(path, options);
+    } catch (err) {
+      this.emit('error', err);
+      return false;
+    }
+  }
+
+  stopCapture() {
+    // @note finishes the file and returns the final stats; null when not capturing
+    try {
+      return this.native.stopCapture();
+    } catch (err) {
+      this.emit('error', err);
+      return null;
+    }
+  }
+
+  getCaptureStats() {
+    try {
+      return this.native.getCaptureStats();
+    } catch (err) {
+      this.emit('error', err);
+      return null;
+    }
+  }
+
+  startReplay(path, options = {}) {
+    // @note feeds a capture's received datagrams back in; returns how many there are, null on failure
+    try {
+      return this.native.startReplay(path, options);
+    } catch (err) {
+      this.emit('error', err);
+      return null;
+    }
+  }
+
+  stopReplay() {
+    // @note resets the replayed peers and returns the final stats; null when not replaying
+    try {
+      return this.native.stopReplay();
+    } catch (err) {
+      this.emit('error', err);
+      return null;
+    }
+  }
+
+  getReplayStats() {
+    try {
+      return this.native.getReplayStats();
+    } catch (err) {
+      this.emit('error', err);
+      return null;
+    }
   }
 
   flush() {
@@ -319,20 +839,39 @@ class Server extends ENetBase {
       incomingBandwidth: options.incomingBandwidth || 0,
       outgoingBandwidth: options.outgoingBandwidth || 0,
       checksum: !!options.checksum,
-      compression: !!options.compression,
+      compression: options.compression || false,
+      compressionThreshold: options.compressionThreshold || 0,
+      compressionDictionary: options.compressionDictionary || null,
+      eventDriven: options.eventDriven !== false,
+      threaded: !!options.threaded,
+      gso: !!options.gso,
+      gro: !!options.gro,
+      memoryLimit: options.memoryLimit,
+      instrument: !!options.instrument,
+      reusePort: !!options.reusePort,
+      streamChannels: options.streamChannels || [],
+      channelPriorities: options.channelPriorities || [],
+      maxReassemblyData: options.maxReassemblyData || 0,
+      maxPeerReassemblyData: options.maxPeerReassemblyData || 0,
+      bandwidthThrottle: options.bandwidthThrottle !== false,
+      bandwidthThrottleInterval:
+        options.bandwidthThrottleInterval !== undefined
+          ? options.bandwidthThrottleInterval
+          : 1000,
     };
 
     this.config = config;
+    this.eventDriven = config.eventDriven;
+    this.threaded = config.threaded;
     this.initialize();
   }
 
   async createServer() {
     try {
-      // @note ensure port is free before binding
-      const isPortAvailable = await this.checkPortAvailable(
-        this.config.port,
-        this.config.ip,
-      );
+      // @note ensure port is free before binding; a shared port is expected to be taken
+      const isPortAvailable =
+        this.config.reusePort ||
+        (await this.checkPortAvailable(this.config.port, this.config.ip));
       if (!isPortAvailable) {
         const error = new Error(
           `Port ${this.config.port} is already in use on ${this.config.ip}`,
@@ -351,6 +890,14 @@ class Server extends ENetBase {
         channelLimit: this.config.channelLimit,
         incomingBandwidth: this.config.incomingBandwidth,
         outgoingBandwidth: this.config.outgoingBandwidth,
+        memoryLimit: this.config.memoryLimit,
+        reusePort: this.config.reusePort,
+        streamChannels: this.config.streamChannels,
+        channelPriorities: this.config.channelPriorities,
+        maxReassemblyData: this.config.maxReassemblyData,
+        maxPeerReassemblyData: this.config.maxPeerReassemblyData,
+        bandwidthThrottle: this.config.bandwidthThrottle,
+        bandwidthThrottleInterval: this.config.bandwidthThrottleInterval,
         checksum: this.config.checksum,
         compression: this.config.compression,
       };
@@ -374,14 +921,31 @@ class Server extends ENetBase {
   }
 
   broadcast(channelId, data, reliable = true) {
-    for (const [peerId, peerInfo] of this.peers) {
-      if (peerInfo && peerInfo.connected) {
-        try {
-          super.send(peerId, channelId, data, reliable);
-        } catch (err) {
-          this.emit('error', err);
-        }
-      }
+    // @note one native call and one shared packet for every connected peer
+    try {
+      this.native.broadcast(channelId, data, reliable ? 1 : 0);
+    } catch (err) {
+      this.emit('error', err);
+    }
+  }
+
+  sendToMany(peerIds, channelId, data, reliable = true) {
+    // @note one shared packet for a subset of peers; returns how many accepted it
+    try {
+      return this.native.sendToMany(peerIds, channelId, data, reliable ? 1 : 0);
+    } catch (err) {
+      this.emit('error', err);
+      return -1;
+    }
+  }
+
+  sendMany(descriptors, payload, results) {
+    // @note queue every SEND_MANY record in one native call; results gets 0 or -1 per record
+    try {
+      return this.native.sendMany(descriptors, payload, results);
+    } catch (err) {
+      this.emit('error', err);
+      return null;
     }
   }
 
@@ -425,10 +989,29 @@ class Client extends ENetBase {
       incomingBandwidth: options.incomingBandwidth || 0,
       outgoingBandwidth: options.outgoingBandwidth || 0,
       checksum: !!options.checksum,
-      compression: !!options.compression,
+      compression: options.compression || false,
+      compressionThreshold: options.compressionThreshold || 0,
+      compressionDictionary: options.compressionDictionary || null,
+      eventDriven: options.eventDriven !== false,
+      threaded: !!options.threaded,
+      gso: !!options.gso,
+      gro: !!options.gro,
+      memoryLimit: options.memoryLimit,
+      instrument: !!options.instrument,
+      streamChannels: options.streamChannels || [],
+      channelPriorities: options.channelPriorities || [],
+      maxReassemblyData: options.maxReassemblyData || 0,
+      maxPeerReassemblyData: options.maxPeerReassemblyData || 0,
+      bandwidthThrottle: options.bandwidthThrottle !== false,
+      bandwidthThrottleInterval:
+        options.bandwidthThrottleInterval !== undefined
+          ? options.bandwidthThrottleInterval
+          : 1000,
     };
 
     this.config = config;
+    this.eventDriven = config.eventDriven;
+    this.threaded = config.threaded;
     this.serverPeer = null;
     this.initialize();
     this.createClient();
@@ -441,6 +1024,13 @@ class Client extends ENetBase {
         channelLimit: this.config.channelLimit,
         incomingBandwidth: this.config.incomingBandwidth,
         outgoingBandwidth: this.config.outgoingBandwidth,
+        memoryLimit: this.config.memoryLimit,
+        streamChannels: this.config.streamChannels,
+        channelPriorities: this.config.channelPriorities,
+        maxReassemblyData: this.config.maxReassemblyData,
+        maxPeerReassemblyData: this.config.maxPeerReassemblyData,
+        bandwidthThrottle: this.config.bandwidthThrottle,
+        bandwidthThrottleInterval: this.config.bandwidthThrottleInterval,
         checksum: this.config.checksum,
         compression: this.config.compression,
       };
@@ -473,10 +1063,13 @@ class Client extends ENetBase {
         this.config.port,
         this.config.channelLimit,
         0,
+        options && Array.isArray(options.channelPriorities)
+          ? options.channelPriorities
+          : this.config.channelPriorities,
       );
 
       if (peerId) {
-        this.serverPeer = peerId; // bigint from native
+        this.serverPeer = peerId; // small integer handle from native
         this.peers.set(peerId, {
           address: this.config.ip,
           port: this.config.port,
@@ -544,6 +1137,26 @@ class Client extends ENetBase {
     }
   }
 
+  // Override to send zero-copy packets to the connected server peer by default
+  sendZeroCopy(channelId, data, flags = PACKET_FLAG_RELIABLE) {
+    if (this.serverPeer) {
+      return super.sendZeroCopy(this.serverPeer, channelId, data, flags);
+    } else {
+      this.emit('error', new Error('Not connected to server'));
+      return -1;
+    }
+  }
+
+  // Override to set priorities on the connected server peer by default
+  setChannelPriority(channelId, priority) {
+    if (this.serverPeer) {
+      return super.setChannelPriority(this.serverPeer, channelId, priority);
+    } else {
+      this.emit('error', new Error('Not connected to server'));
+      return false;
+    }
+  }
+
   // Override to disconnect from the connected server peer by default
   disconnect(data = 0) {
     if (this.serverPeer) {
@@ -575,6 +1188,14 @@ module.exports = {
   PACKET_FLAG_NO_ALLOCATE,
   PACKET_FLAG_UNRELIABLE_FRAGMENT,
   PACKET_FLAG_SENT,
+  PACKET_FLAG_LAST_CHUNK,
+  HOST_STATS,
+  HOST_STATS_LENGTH,
+  PEER_STATS,
+  PEER_STATS_STRIDE,
+  SEND_MANY,
+  EVENT_RING,
+  now,
   Client,
   Server
 };
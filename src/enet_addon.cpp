@@ -1,35 +1,782 @@
 #include <napi.h>
+#include <uv.h>
 #include <enet/enet.h>
+#include "slab_allocator.h"
+#include "traffic_capture.h"
 #include <memory>
 #include <vector>
+#include <map>
+#include <random>
 #include <cstdio>
+#include <cstring>
 // @note bigint-safe peer id handling
 #include <cstdint>
 #include <atomic>
+#include <mutex>
+#include <thread>
+#ifndef _WIN32
+#include <poll.h>
+#endif
 
 // @note reference count for global enet initialize/deinitialize
 static std::atomic<uint32_t> g_enetInitCount{0};
 
-static ENetPeer* JsValueToPeer(const Napi::Value& value, bool& outOk) {
-    outOk = false;
+// @note peers are named in js by (generation << 12) | incomingPeerID, which stays a Smi and goes
+// @note stale as soon as enet_peer_reset bumps the slot's generation
+static const uint32_t kPeerHandleSlotBits = 12;
+static const uint32_t kPeerHandleSlotMask = (1u << kPeerHandleSlotBits) - 1;
+static const uint32_t kPeerHandleGenerationMask = (1u << 18) - 1;
+static const uint32_t kPeerHandleMax = (kPeerHandleGenerationMask << kPeerHandleSlotBits) | kPeerHandleSlotMask;
+
+static uint32_t PeerHandle(ENetPeer* peer, enet_uint32 generation) {
+    return ((generation & kPeerHandleGenerationMask) << kPeerHandleSlotBits) | peer->incomingPeerID;
+}
+
+// @note the peer a handle names; nullptr if it is out of range or the slot was reset since
+static ENetPeer* PeerFromHandle(ENetHost* host, uint32_t handle) {
+    if (!host) {
+        return nullptr;
+    }
+    uint32_t slot = handle & kPeerHandleSlotMask;
+    if (slot >= host->peerCount) {
+        return nullptr;
+    }
+    ENetPeer* peer = &host->peers[slot];
+    if ((peer->generation & kPeerHandleGenerationMask) != (handle >> kPeerHandleSlotBits)) {
+        return nullptr;
+    }
+    return peer;
+}
+
+// @note parses a handle without touching the host, so it is safe while the network thread owns it
+static bool JsValueToPeerHandle(const Napi::Value& value, uint32_t& outHandle) {
+    if (value.IsNumber()) {
+        double id = value.As<Napi::Number>().DoubleValue();
+        if (!(id >= 0 && id <= kPeerHandleMax) || static_cast<double>(static_cast<uint32_t>(id)) != id) {
+            return false;
+        }
+        outHandle = static_cast<uint32_t>(id);
+        return true;
+    }
     if (value.IsBigInt()) {
+        // @note tolerated for callers that still wrap ids in BigInt
         bool lossless = false;
         uint64_t id = value.As<Napi::BigInt>().Uint64Value(&lossless);
-        if (!lossless) {
+        if (!lossless || id > kPeerHandleMax) {
+            return false;
+        }
+        outHandle = static_cast<uint32_t>(id);
+        return true;
+    }
+    return false;
+}
+
+// @note enet resets a peer before returning its disconnect event, so that event names the previous generation
+static uint32_t EventPeerHandle(const ENetEvent& event) {
+    enet_uint32 generation = event.peer->generation;
+    if (event.type == ENET_EVENT_TYPE_DISCONNECT) {
+        generation--;
+    }
+    return PeerHandle(event.peer, generation);
+}
+
+// @note below this size a copy is cheaper than the finalizer and reference bookkeeping
+static const size_t kExternalBufferMinSize = 512;
+
+// @note takes ownership of the packet; large payloads are lent to js and destroyed on gc
+static Napi::Buffer<enet_uint8> PacketToBuffer(Napi::Env env, ENetPacket* packet) {
+    if (packet->dataLength < kExternalBufferMinSize) {
+        auto buffer = Napi::Buffer<enet_uint8>::Copy(env, packet->data, packet->dataLength);
+        enet_packet_destroy(packet);
+        return buffer;
+    }
+    
+    // @note let the gc see the native payload it is keeping alive
+    int64_t externalSize = static_cast<int64_t>(packet->dataLength);
+    Napi::MemoryManagement::AdjustExternalMemory(env, externalSize);
+    
+    // @note where external buffers are disallowed this copies and finalizes immediately
+    return Napi::Buffer<enet_uint8>::NewOrCopy(env, packet->data, packet->dataLength,
+        [](Napi::Env env, enet_uint8*, ENetPacket* packet) {
+            Napi::MemoryManagement::AdjustExternalMemory(env, -static_cast<int64_t>(packet->dataLength));
+            enet_packet_destroy(packet);
+        }, packet);
+}
+
+static Napi::Object PoolToObject(Napi::Env env, const ENetPool& pool) {
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("inUse", Napi::Number::New(env, static_cast<double>(pool.inUse)));
+    stats.Set("free", Napi::Number::New(env, static_cast<double>(pool.freeCount)));
+    stats.Set("peakInUse", Napi::Number::New(env, static_cast<double>(pool.peakInUse)));
+    stats.Set("allocations", Napi::Number::New(env, static_cast<double>(pool.allocations)));
+    stats.Set("reuses", Napi::Number::New(env, static_cast<double>(pool.reuses)));
+    return stats;
+}
+
+// @note field order of getHostStats and getPeerStats rows; mirrored by HOST_STATS and PEER_STATS in index.js
+enum HostStatsField {
+    kHostStatsTotalSentData,
+    kHostStatsTotalSentPackets,
+    kHostStatsTotalReceivedData,
+    kHostStatsTotalReceivedPackets,
+    kHostStatsPeerCount,
+    kHostStatsConnectedPeers,
+    kHostStatsBandwidthLimitedPeers,
+    kHostStatsIncomingBandwidth,
+    kHostStatsOutgoingBandwidth,
+    kHostStatsServiceTime,
+    kHostStatsOutgoingCommands,
+    kHostStatsAcknowledgements,
+    kHostStatsIncomingCommands,
+    kHostStatsTotalRetransmits,
+    kHostStatsReliableDataInTransit,
+    kHostStatsTotalWaitingData,
+    kHostStatsReassemblyData,
+    kHostStatsLength
+};
+
+enum PeerStatsField {
+    kPeerStatsId,
+    kPeerStatsIncomingPeerID,
+    kPeerStatsState,
+    kPeerStatsRoundTripTime,
+    kPeerStatsRoundTripTimeVariance,
+    kPeerStatsLowestRoundTripTime,
+    kPeerStatsPacketLoss,
+    kPeerStatsPacketThrottle,
+    kPeerStatsPacketThrottleLimit,
+    kPeerStatsMtu,
+    kPeerStatsReliableDataInTransit,
+    kPeerStatsTotalWaitingData,
+    kPeerStatsTotalSentData,
+    kPeerStatsTotalSentPackets,
+    kPeerStatsTotalReceivedData,
+    kPeerStatsTotalReceivedPackets,
+    kPeerStatsTotalRetransmits,
+    kPeerStatsReassemblyData,
+    kPeerStatsStride
+};
+
+// @note a caller owned Float64Array or BigUint64Array that stats are written into without allocating
+class StatsArray {
+public:
+    bool Bind(const Napi::Value& value) {
+        if (!value.IsTypedArray()) {
+            return false;
+        }
+        Napi::TypedArray typedArray = value.As<Napi::TypedArray>();
+        void* data = static_cast<uint8_t*>(typedArray.ArrayBuffer().Data()) + typedArray.ByteOffset();
+        length = typedArray.ElementLength();
+        if (typedArray.TypedArrayType() == napi_float64_array) {
+            doubles = static_cast<double*>(data);
+            return true;
+        }
+        if (typedArray.TypedArrayType() == napi_biguint64_array) {
+            integers = static_cast<uint64_t*>(data);
+            return true;
+        }
+        return false;
+    }
+
+    size_t Length() const {
+        return length;
+    }
+
+    void Set(size_t index, uint64_t value) {
+        if (doubles) {
+            doubles[index] = static_cast<double>(value);
+        } else {
+            integers[index] = value;
+        }
+    }
+
+private:
+    double* doubles = nullptr;
+    uint64_t* integers = nullptr;
+    size_t length = 0;
+};
+
+static void WritePeerStats(StatsArray& out, size_t offset, ENetPeer* peer) {
+    out.Set(offset + kPeerStatsId, PeerHandle(peer, peer->generation));
+    out.Set(offset + kPeerStatsIncomingPeerID, peer->incomingPeerID);
+    out.Set(offset + kPeerStatsState, peer->state);
+    out.Set(offset + kPeerStatsRoundTripTime, peer->roundTripTime);
+    out.Set(offset + kPeerStatsRoundTripTimeVariance, peer->roundTripTimeVariance);
+    out.Set(offset + kPeerStatsLowestRoundTripTime, peer->lowestRoundTripTime);
+    out.Set(offset + kPeerStatsPacketLoss, peer->packetLoss);
+    out.Set(offset + kPeerStatsPacketThrottle, peer->packetThrottle);
+    out.Set(offset + kPeerStatsPacketThrottleLimit, peer->packetThrottleLimit);
+    out.Set(offset + kPeerStatsMtu, peer->mtu);
+    out.Set(offset + kPeerStatsReliableDataInTransit, peer->reliableDataInTransit);
+    out.Set(offset + kPeerStatsTotalWaitingData, peer->totalWaitingData);
+    out.Set(offset + kPeerStatsTotalSentData, peer->totalSentData);
+    out.Set(offset + kPeerStatsTotalSentPackets, peer->totalSentPackets);
+    out.Set(offset + kPeerStatsTotalReceivedData, peer->totalReceivedData);
+    out.Set(offset + kPeerStatsTotalReceivedPackets, peer->totalReceivedPackets);
+    out.Set(offset + kPeerStatsTotalRetransmits, peer->totalRetransmits);
+    out.Set(offset + kPeerStatsReassemblyData, peer->reassemblyData);
+}
+
+// @note convert a serviced enet event into a js object; takes ownership of the packet
+static Napi::Object EventToObject(Napi::Env env, ENetEvent& event, uint32_t peer) {
+    Napi::Object eventObj = Napi::Object::New(env);
+    
+    switch (event.type) {
+        case ENET_EVENT_TYPE_CONNECT:
+            eventObj.Set("type", "connect");
+            eventObj.Set("peer", Napi::Number::New(env, peer));
+            break;
+            
+        case ENET_EVENT_TYPE_DISCONNECT:
+            eventObj.Set("type", "disconnect");
+            eventObj.Set("peer", Napi::Number::New(env, peer));
+            eventObj.Set("data", Napi::Number::New(env, event.data));
+            break;
+            
+        case ENET_EVENT_TYPE_RECEIVE:
+            eventObj.Set("type", "receive");
+            eventObj.Set("peer", Napi::Number::New(env, peer));
+            eventObj.Set("channelID", Napi::Number::New(env, event.channelID));
+            
+            // Convert packet data to Buffer
+            if (event.packet) {
+                eventObj.Set("data", PacketToBuffer(env, event.packet));
+            }
+            break;
+            
+        case ENET_EVENT_TYPE_RECEIVE_CHUNK:
+            eventObj.Set("type", "receiveChunk");
+            eventObj.Set("peer", Napi::Number::New(env, peer));
+            eventObj.Set("channelID", Napi::Number::New(env, event.channelID));
+            eventObj.Set("offset", Napi::Number::New(env, event.data));
+            eventObj.Set("final", Napi::Boolean::New(env, (event.packet->flags & ENET_PACKET_FLAG_LAST_CHUNK) != 0));
+            eventObj.Set("data", PacketToBuffer(env, event.packet));
+            break;
+            
+        default:
+            eventObj.Set("type", "unknown");
+            break;
+    }
+    
+    return eventObj;
+}
+
+// @note EventToObject, timed into the host's conversion histogram while it is instrumented
+static Napi::Object ConvertEvent(Napi::Env env, ENetHost* host, ENetEvent& event) {
+#ifdef ENET_INSTRUMENT
+    if (host->histograms != nullptr) {
+        enet_uint64 start = enet_time_get_ns();
+        Napi::Object eventObj = EventToObject(env, event, EventPeerHandle(event));
+        enet_histogram_record(&host->histograms[ENET_INSTRUMENT_STAGE_CONVERSION], enet_time_get_ns() - start);
+        return eventObj;
+    }
+#endif
+    return EventToObject(env, event, EventPeerHandle(event));
+}
+
+static Napi::Object HistogramToObject(Napi::Env env, const ENetHistogram& histogram) {
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("count", Napi::Number::New(env, static_cast<double>(histogram.count)));
+    stats.Set("min", Napi::Number::New(env, static_cast<double>(histogram.minimum)));
+    stats.Set("max", Napi::Number::New(env, static_cast<double>(histogram.maximum)));
+    stats.Set("mean", Napi::Number::New(env, histogram.count ? static_cast<double>(histogram.total) / histogram.count : 0.0));
+    stats.Set("p50", Napi::Number::New(env, static_cast<double>(enet_histogram_percentile(&histogram, 50.0))));
+    stats.Set("p90", Napi::Number::New(env, static_cast<double>(enet_histogram_percentile(&histogram, 90.0))));
+    stats.Set("p99", Napi::Number::New(env, static_cast<double>(enet_histogram_percentile(&histogram, 99.0))));
+    stats.Set("p999", Napi::Number::New(env, static_cast<double>(enet_histogram_percentile(&histogram, 99.9))));
+    return stats;
+}
+
+// @note work handed from js to the network thread
+// @note sendMany() descriptor layout: kSendRecordWords uint32 words per message
+enum SendRecordField : uint32_t {
+    kSendRecordPeer = 0,
+    kSendRecordChannel = 1,
+    kSendRecordFlags = 2,
+    kSendRecordOffset = 3,
+    kSendRecordLength = 4,
+    kSendRecordWords = 5
+};
+
+struct QueuedSend {
+    uint32_t peer;
+    enet_uint8 channelID;
+    ENetPacket* packet;
+};
+
+struct NetCommand {
+    enum Type {
+        Send,
+        SendMany,
+        SendBatch,
+        Broadcast,
+        Disconnect,
+        DisconnectNow,
+        DisconnectLater
+    };
+    
+    std::atomic<NetCommand*> next{nullptr};
+    Type type = Send;
+    // @note peer handles, resolved on the network thread
+    uint32_t peer = 0;
+    enet_uint8 channelID = 0;
+    ENetPacket* packet = nullptr;
+    enet_uint32 data = 0;
+    std::vector<uint32_t> peers;
+    std::vector<QueuedSend> sends;
+};
+
+// @note an event taken on the network thread, with its handle fixed before the peer can be reset again
+struct ThreadEvent {
+    ENetEvent event;
+    uint32_t peer;
+};
+
+// @note intrusive lock-free multi-producer/single-consumer queue (vyukov)
+class NetCommandQueue {
+public:
+    NetCommandQueue() : head(&stub), tail(&stub) {}
+    
+    void Push(NetCommand* command) {
+        command->next.store(nullptr, std::memory_order_relaxed);
+        NetCommand* prev = head.exchange(command, std::memory_order_acq_rel);
+        prev->next.store(command, std::memory_order_release);
+    }
+    
+    // @note consumer side only; returns nullptr when empty or a push is mid-flight
+    NetCommand* Pop() {
+        NetCommand* current = tail;
+        NetCommand* next = current->next.load(std::memory_order_acquire);
+        if (current == &stub) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            tail = next;
+            current = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            tail = next;
+            return current;
+        }
+        if (current != head.load(std::memory_order_acquire)) {
             return nullptr;
         }
-        outOk = true;
-        return reinterpret_cast<ENetPeer*>(static_cast<uintptr_t>(id));
+        Push(&stub);
+        next = current->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            tail = next;
+            return current;
+        }
+        return nullptr;
     }
-    if (value.IsNumber()) {
-        // @note legacy support (unsafe but tolerated): accept 53-bit numbers
-        uint64_t id = static_cast<uint64_t>(value.As<Napi::Number>().Int64Value());
-        outOk = true;
-        return reinterpret_cast<ENetPeer*>(static_cast<uintptr_t>(id));
+    
+private:
+    std::atomic<NetCommand*> head;
+    NetCommand* tail;
+    NetCommand stub;
+};
+
+class ENetWrapper;
+
+// @note js memory lent to a NO_ALLOCATE packet; the reference keeps it from being collected
+struct PinnedPacket {
+    Napi::ObjectReference reference;
+    ENetWrapper* owner = nullptr;
+};
+
+// @note copies a Buffer, TypedArray, ArrayBuffer or string into a new packet; nullptr if unsupported
+static ENetPacket* CreatePacketFromValue(const Napi::Value& value, enet_uint32 flags) {
+    flags &= ~ENET_PACKET_FLAG_NO_ALLOCATE;
+    
+    if (value.IsTypedArray()) {
+        Napi::TypedArray typedArray = value.As<Napi::TypedArray>();
+        uint8_t* data = static_cast<uint8_t*>(typedArray.ArrayBuffer().Data()) + typedArray.ByteOffset();
+        return enet_packet_create(data, typedArray.ByteLength(), flags);
+    }
+    if (value.IsArrayBuffer()) {
+        Napi::ArrayBuffer arrayBuffer = value.As<Napi::ArrayBuffer>();
+        return enet_packet_create(arrayBuffer.Data(), arrayBuffer.ByteLength(), flags);
+    }
+    if (value.IsString()) {
+        std::string str = value.As<Napi::String>().Utf8Value();
+        return enet_packet_create(str.c_str(), str.length(), flags);
     }
     return nullptr;
 }
 
+// @note queues one shared packet on every listed peer that is still current; destroys it if nobody took a reference
+static int SendToPeers(ENetHost* host, const std::vector<uint32_t>& handles, enet_uint8 channelID, ENetPacket* packet) {
+    int sent = 0;
+    for (uint32_t handle : handles) {
+        ENetPeer* peer = PeerFromHandle(host, handle);
+        if (peer && enet_peer_send(peer, channelID, packet) == 0) {
+            sent++;
+        }
+    }
+    if (packet->referenceCount == 0) {
+        enet_packet_destroy(packet);
+    }
+    return sent;
+}
+
+// @note wraps the selected codec to skip small packets and count ratio and time for getCompressionStats
+struct MeteredCompressor {
+    ENetCompressor inner;
+    const char* algorithm = "";
+    size_t threshold = 0;
+    uint64_t skipped = 0;
+    uint64_t compressed = 0;
+    uint64_t incompressible = 0;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    uint64_t compressNs = 0;
+    uint64_t decompressed = 0;
+    uint64_t decompressedBytesIn = 0;
+    uint64_t decompressedBytesOut = 0;
+    uint64_t decompressNs = 0;
+
+    static size_t ENET_CALLBACK Compress(void* context, const ENetBuffer* inBuffers, size_t inBufferCount,
+                                         size_t inLimit, enet_uint8* outData, size_t outLimit) {
+        MeteredCompressor* self = static_cast<MeteredCompressor*>(context);
+        if (inLimit < self->threshold) {
+            self->skipped++;
+            return 0;
+        }
+        uint64_t start = uv_hrtime();
+        size_t result = self->inner.compress(self->inner.context, inBuffers, inBufferCount, inLimit, outData, outLimit);
+        self->compressNs += uv_hrtime() - start;
+        // @note enet sends the original when the output is not smaller, so count what goes on the wire
+        if (result > 0 && result < inLimit) {
+            self->compressed++;
+            self->bytesIn += inLimit;
+            self->bytesOut += result;
+        } else {
+            self->incompressible++;
+        }
+        return result;
+    }
+
+    static size_t ENET_CALLBACK Decompress(void* context, const enet_uint8* inData, size_t inLimit,
+                                           enet_uint8* outData, size_t outLimit) {
+        MeteredCompressor* self = static_cast<MeteredCompressor*>(context);
+        uint64_t start = uv_hrtime();
+        size_t result = self->inner.decompress(self->inner.context, inData, inLimit, outData, outLimit);
+        self->decompressNs += uv_hrtime() - start;
+        if (result > 0) {
+            self->decompressed++;
+            self->decompressedBytesIn += inLimit;
+            self->decompressedBytesOut += result;
+        }
+        return result;
+    }
+
+    static void ENET_CALLBACK Destroy(void* context) {
+        MeteredCompressor* self = static_cast<MeteredCompressor*>(context);
+        if (self->inner.destroy) {
+            self->inner.destroy(self->inner.context);
+        }
+        delete self;
+    }
+};
+
+// @note the host's compressor if it was installed by setCompression, nullptr otherwise
+static MeteredCompressor* GetMeteredCompressor(ENetHost* host) {
+    if (host->compressor.context == nullptr || host->compressor.destroy != MeteredCompressor::Destroy) {
+        return nullptr;
+    }
+    return static_cast<MeteredCompressor*>(host->compressor.context);
+}
+
+// @note loss and latency injection for load tests: runs as the host's intercept with itself in host->data
+struct NetworkConditioner {
+    struct Datagram {
+        ENetAddress address;
+        std::vector<enet_uint8> data;
+    };
+    
+    double loss = 0.0;
+    enet_uint32 latency = 0;
+    enet_uint32 jitter = 0;
+    uint64_t dropped = 0;
+    uint64_t delayed = 0;
+    std::mt19937 random{std::random_device{}()};
+    // @note keyed by the uv_hrtime() at which the datagram reaches the protocol, jitter may reorder
+    std::multimap<uint64_t, Datagram> pending;
+    
+    static int ENET_CALLBACK Intercept(ENetHost* host, ENetEvent* event) {
+        NetworkConditioner* self = static_cast<NetworkConditioner*>(host->data);
+        if (self->loss > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(self->random) < self->loss) {
+            self->dropped++;
+            return 1;
+        }
+        enet_uint32 delay = self->latency;
+        if (self->jitter > 0) {
+            delay += std::uniform_int_distribution<enet_uint32>(0, self->jitter)(self->random);
+        }
+        if (delay == 0) {
+            return 0;
+        }
+        Datagram datagram;
+        datagram.address = host->receivedAddress;
+        datagram.data.assign(host->receivedData, host->receivedData + host->receivedDataLength);
+        self->pending.emplace(uv_hrtime() + static_cast<uint64_t>(delay) * 1000000, std::move(datagram));
+        self->delayed++;
+        // @note enet_host_inject counts the datagram again when it is released
+        host->totalReceivedData -= host->receivedDataLength;
+        host->totalReceivedPackets--;
+        return 1;
+    }
+    
+    // @note hands due datagrams to the protocol; must not run inside enet_host_service
+    void Release(ENetHost* host, bool all = false) {
+        uint64_t now = uv_hrtime();
+        while (!pending.empty() && (all || pending.begin()->first <= now)) {
+            auto it = pending.begin();
+            enet_host_inject(host, &it->second.address, it->second.data.data(), it->second.data.size(), nullptr);
+            pending.erase(it);
+        }
+    }
+    
+    // @note lowers timeout to the next release, false when nothing is held back
+    bool NextTimeout(enet_uint32& timeout) const {
+        if (pending.empty()) {
+            return false;
+        }
+        uint64_t now = uv_hrtime();
+        uint64_t due = pending.begin()->first;
+        enet_uint32 wait = due > now ? static_cast<enet_uint32>((due - now + 999999) / 1000000) : 0;
+        if (wait < timeout) {
+            timeout = wait;
+        }
+        return true;
+    }
+};
+
+// @note the host's conditioner if it was installed by setNetworkConditions, nullptr otherwise
+static NetworkConditioner* GetNetworkConditioner(ENetHost* host) {
+    if (host->intercept != NetworkConditioner::Intercept) {
+        return nullptr;
+    }
+    return static_cast<NetworkConditioner*>(host->data);
+}
+
+// @note optionally delivers anything still held back, then removes the conditioner
+static void RemoveNetworkConditioner(ENetHost* host, bool deliver) {
+    NetworkConditioner* conditioner = GetNetworkConditioner(host);
+    if (conditioner == nullptr) {
+        return;
+    }
+    if (deliver) {
+        conditioner->Release(host, true);
+    }
+    host->intercept = nullptr;
+    host->data = nullptr;
+    delete conditioner;
+}
+
+// @note true while any peer slot is connecting, connected or disconnecting
+static bool HostHasPeers(ENetHost* host) {
+    for (ENetPeer* peer = host->activePeers; peer != nullptr; peer = peer->activeNext) {
+        if (peer->state != ENET_PEER_STATE_DISCONNECTED) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// @note the host's capture if it was installed by startCapture, nullptr otherwise
+static TrafficCapture* GetTrafficCapture(ENetHost* host) {
+    if (host->intercept != TrafficCapture::Intercept) {
+        return nullptr;
+    }
+    return static_cast<TrafficCapture*>(host->data);
+}
+
+// @note the host's replay if it was installed by startReplay, nullptr otherwise
+static TrafficReplay* GetTrafficReplay(ENetHost* host) {
+    if (host->intercept != TrafficReplay::Intercept) {
+        return nullptr;
+    }
+    return static_cast<TrafficReplay*>(host->data);
+}
+
+// @note finishes the capture file; stats receive the final counts when given
+static void RemoveTrafficCapture(ENetHost* host, TrafficCaptureStats* stats = nullptr) {
+    TrafficCapture* capture = GetTrafficCapture(host);
+    if (capture == nullptr) {
+        return;
+    }
+    host->intercept = nullptr;
+    host->interceptSend = nullptr;
+    host->data = nullptr;
+    capture->Close();
+    if (stats != nullptr) {
+        *stats = capture->Stats();
+    }
+    delete capture;
+}
+
+static void RemoveTrafficReplay(ENetHost* host, TrafficReplayStats* stats = nullptr) {
+    TrafficReplay* replay = GetTrafficReplay(host);
+    if (replay == nullptr) {
+        return;
+    }
+    // @note replayed peers live on the captured timeline, so they go with it; a reset unlinks the peer from activePeers
+    for (ENetPeer* peer = host->activePeers; peer != nullptr; ) {
+        ENetPeer* next = peer->activeNext;
+        if (peer->state != ENET_PEER_STATE_DISCONNECTED) {
+            enet_peer_reset(peer);
+        }
+        peer = next;
+    }
+    enet_host_set_clock(host, nullptr);
+    host->intercept = nullptr;
+    host->interceptSend = nullptr;
+    host->data = nullptr;
+    if (stats != nullptr) {
+        *stats = replay->Stats();
+    }
+    delete replay;
+}
+
+// @note everything that owns the host's intercept slot, removed before the host goes away
+static void RemoveInterceptors(ENetHost* host) {
+    RemoveNetworkConditioner(host, false);
+    RemoveTrafficCapture(host);
+    RemoveTrafficReplay(host);
+}
+
+// @note runs held back or replayed datagrams that are due before a service pass
+static void ReleaseHeldDatagrams(ENetHost* host) {
+    NetworkConditioner* conditioner = GetNetworkConditioner(host);
+    if (conditioner != nullptr) {
+        conditioner->Release(host);
+    }
+    TrafficReplay* replay = GetTrafficReplay(host);
+    if (replay != nullptr) {
+        replay->Release(host);
+    }
+}
+
+// @note lowers timeout to the next held back or replayed datagram, false when there is none
+static bool HeldDatagramTimeout(ENetHost* host, enet_uint32& timeout) {
+    NetworkConditioner* conditioner = GetNetworkConditioner(host);
+    if (conditioner != nullptr) {
+        return conditioner->NextTimeout(timeout);
+    }
+    TrafficReplay* replay = GetTrafficReplay(host);
+    if (replay != nullptr) {
+        return replay->NextTimeout(timeout);
+    }
+    return false;
+}
+
+// @note opt-in event ring: fixed-size records in a js-owned Uint32Array, receive payloads copied
+// @note into a companion Uint8Array arena; both are normally views over SharedArrayBuffers
+enum EventRingHeader : uint32_t {
+    kEventRingWrite = 0,    // @note records produced; only native writes it, with release order
+    kEventRingRead = 1,     // @note records consumed; only js writes it
+    kEventRingCapacity = 2,
+    kEventRingDropped = 3,  // @note receives whose payload is larger than the whole arena
+    kEventRingHeaderWords = 8
+};
+
+enum EventRecordField : uint32_t {
+    kEventRecordType = 0,
+    kEventRecordPeer = 1,
+    kEventRecordChannel = 2,
+    kEventRecordOffset = 3,
+    kEventRecordLength = 4,
+    kEventRecordData = 5,
+    kEventRecordFlags = 6,  // @note packet flags, so chunk records can mark the end of their message
+    kEventRecordWords = 8
+};
+
+struct EventRing {
+    Napi::ObjectReference headerRef;
+    Napi::ObjectReference arenaRef;
+    uint32_t* header = nullptr;
+    uint32_t* records = nullptr;
+    uint32_t capacity = 0;
+    uint8_t* arena = nullptr;
+    uint32_t arenaSize = 0;
+    // @note free-running arena cursors; arenaEnds[slot] is the write cursor after that record
+    uint32_t arenaWrite = 0;
+    uint32_t arenaRead = 0;
+    uint32_t lastRead = 0;
+    std::vector<uint32_t> arenaEnds;
+    // @note an event already taken from enet that did not fit; it goes out before anything else
+    bool hasPending = false;
+    ThreadEvent pending;
+    
+    ~EventRing() {
+        if (hasPending && pending.event.packet) {
+            enet_packet_destroy(pending.event.packet);
+        }
+    }
+    
+    static std::atomic<uint32_t>& Word(uint32_t* word) {
+        return *reinterpret_cast<std::atomic<uint32_t>*>(word);
+    }
+    
+    // @note returns false when there is no room yet; the event is left untouched for a retry
+    bool Push(const ThreadEvent& item) {
+        const ENetEvent& event = item.event;
+        uint32_t write = Word(&header[kEventRingWrite]).load(std::memory_order_relaxed);
+        uint32_t read = Word(&header[kEventRingRead]).load(std::memory_order_acquire);
+        if (read != lastRead) {
+            arenaRead = arenaEnds[(read - 1) & (capacity - 1)];
+            lastRead = read;
+        }
+        if (write - read >= capacity) {
+            return false;
+        }
+        
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        uint32_t flags = 0;
+        if (event.packet) {
+            if (event.packet->dataLength > arenaSize) {
+                Word(&header[kEventRingDropped]).fetch_add(1, std::memory_order_relaxed);
+                enet_packet_destroy(event.packet);
+                return true;
+            }
+            length = static_cast<uint32_t>(event.packet->dataLength);
+            if (arenaWrite == arenaRead) {
+                // @note nothing is in use, so restart at the front and any payload up to arenaSize fits
+                arenaWrite = arenaRead = (arenaWrite + arenaSize - 1) & ~(arenaSize - 1);
+            }
+            // @note payloads never wrap: skip the tail of the arena instead
+            uint32_t position = arenaWrite & (arenaSize - 1);
+            uint32_t skip = position + length > arenaSize ? arenaSize - position : 0;
+            if (arenaWrite + skip + length - arenaRead > arenaSize) {
+                return false;
+            }
+            offset = skip ? 0 : position;
+            if (length > 0) {
+                memcpy(arena + offset, event.packet->data, length);
+            }
+            arenaWrite += skip + length;
+            flags = event.packet->flags;
+            enet_packet_destroy(event.packet);
+        }
+        
+        uint32_t slot = write & (capacity - 1);
+        uint32_t* record = records + slot * kEventRecordWords;
+        record[kEventRecordType] = static_cast<uint32_t>(event.type);
+        record[kEventRecordPeer] = item.peer;
+        record[kEventRecordChannel] = event.channelID;
+        record[kEventRecordOffset] = offset;
+        record[kEventRecordLength] = length;
+        record[kEventRecordData] = event.data;
+        record[kEventRecordFlags] = flags;
+        arenaEnds[slot] = arenaWrite;
+        Word(&header[kEventRingWrite]).store(write + 1, std::memory_order_release);
+        return true;
+    }
+};
+
 class ENetWrapper : public Napi::ObjectWrap<ENetWrapper> {
 public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
@@ -37,7 +784,6 @@ public:
     ~ENetWrapper();
 
 private:
-    static Napi::FunctionReference constructor;
     
     // Methods
     Napi::Value Initialize(const Napi::CallbackInfo& info);
@@ -45,23 +791,118 @@ private:
     Napi::Value CreateHost(const Napi::CallbackInfo& info);
     Napi::Value DestroyHost(const Napi::CallbackInfo& info);
     Napi::Value HostService(const Napi::CallbackInfo& info);
+    Napi::Value HostServiceBatch(const Napi::CallbackInfo& info);
     Napi::Value Flush(const Napi::CallbackInfo& info);
     Napi::Value Connect(const Napi::CallbackInfo& info);
     Napi::Value Disconnect(const Napi::CallbackInfo& info);
     Napi::Value DisconnectNow(const Napi::CallbackInfo& info);
     Napi::Value DisconnectLater(const Napi::CallbackInfo& info);
+    Napi::Value SetChannelPriority(const Napi::CallbackInfo& info);
     Napi::Value SendPacket(const Napi::CallbackInfo& info);
     Napi::Value SendRawPacket(const Napi::CallbackInfo& info);
+    Napi::Value SendZeroCopy(const Napi::CallbackInfo& info);
+    Napi::Value Broadcast(const Napi::CallbackInfo& info);
+    Napi::Value SendToMany(const Napi::CallbackInfo& info);
+    Napi::Value SendMany(const Napi::CallbackInfo& info);
     Napi::Value SetCompression(const Napi::CallbackInfo& info);
     Napi::Value SetChecksum(const Napi::CallbackInfo& info);
     Napi::Value SetNewPacket(const Napi::CallbackInfo& info);
+    Napi::Value SetOffload(const Napi::CallbackInfo& info);
+    Napi::Value GetPoolStats(const Napi::CallbackInfo& info);
+    Napi::Value GetMemoryStats(const Napi::CallbackInfo& info);
+    Napi::Value GetCompressionStats(const Napi::CallbackInfo& info);
+    Napi::Value GetHostStats(const Napi::CallbackInfo& info);
+    Napi::Value GetPeerStats(const Napi::CallbackInfo& info);
+    Napi::Value SetInstrument(const Napi::CallbackInfo& info);
+    Napi::Value GetLatencyHistograms(const Napi::CallbackInfo& info);
+    Napi::Value SetNetworkConditions(const Napi::CallbackInfo& info);
+    Napi::Value GetNetworkConditions(const Napi::CallbackInfo& info);
+    Napi::Value StartCapture(const Napi::CallbackInfo& info);
+    Napi::Value StopCapture(const Napi::CallbackInfo& info);
+    Napi::Value GetCaptureStats(const Napi::CallbackInfo& info);
+    Napi::Value StartReplay(const Napi::CallbackInfo& info);
+    Napi::Value StopReplay(const Napi::CallbackInfo& info);
+    Napi::Value GetReplayStats(const Napi::CallbackInfo& info);
+    Napi::Value AttachEventRing(const Napi::CallbackInfo& info);
+    Napi::Value HostServiceRing(const Napi::CallbackInfo& info);
+    Napi::Value StartPoll(const Napi::CallbackInfo& info);
+    Napi::Value StopPoll(const Napi::CallbackInfo& info);
+    Napi::Value ReceiveAll(const Napi::CallbackInfo& info);
+    Napi::Value FlushAll(const Napi::CallbackInfo& info);
+    Napi::Value StartTick(const Napi::CallbackInfo& info);
+    static Napi::Value Now(const Napi::CallbackInfo& info);
+    Napi::Value StopTick(const Napi::CallbackInfo& info);
+    Napi::Value StartThread(const Napi::CallbackInfo& info);
+    Napi::Value StopThread(const Napi::CallbackInfo& info);
+    
+    int ServiceEvents(Napi::Env env, Napi::Array& events, uint32_t maxEvents, enet_uint32 timeout);
+    int ServiceRing(uint32_t maxEvents, enet_uint32 timeout, uint32_t& written);
+    
+    // @note event-driven mode: uv poll handle on host->socket plus a timer for enet deadlines
+    void ServicePoll();
+    void ArmPollTimer(bool morePending);
+    void ScheduleFlush();
+    void ClosePoll();
+    static void OnPollReadable(uv_poll_t* handle, int status, int events);
+    static void OnPollTimer(uv_timer_t* handle);
+    
+    // @note manual tick mode: a fixed-rate timer; js receives, steps and flushes once per tick
+    void RunTick();
+    void ArmTickTimer();
+    void CloseTick();
+    static void OnTickTimer(uv_timer_t* handle);
+    
+    // @note threaded mode: a native thread owns the host; js talks to it through the command queue
+    bool QueueThreadCommand(NetCommand::Type type, uint32_t peer, enet_uint8 channelID, ENetPacket* packet, enet_uint32 data);
+    void ApplyThreadCommands();
+    void WakeThread();
+    void WaitForNetwork(enet_uint32 timeout);
+    void NetworkThreadMain();
+    void JoinThread();
+    
+    // @note zero-copy sends: pinned js memory is only unreferenced on the js thread
+    ENetPacket* CreatePinnedPacket(const Napi::Value& value, enet_uint32 flags);
+    void DrainPins();
+    static void ENET_CALLBACK OnPinnedPacketFree(ENetPacket* packet);
     
     ENetHost* host = nullptr;
     bool initialized = false;
+    
+    napi_env pollEnv = nullptr;
+    uv_poll_t* pollHandle = nullptr;
+    uv_timer_t* pollTimer = nullptr;
+    Napi::FunctionReference pollCallback;
+    uint32_t pollMaxEvents = 256;
+    bool flushScheduled = false;
+    
+    napi_env tickEnv = nullptr;
+    uv_timer_t* tickTimer = nullptr;
+    Napi::FunctionReference tickCallback;
+    uint64_t tickOrigin = 0;
+    uint64_t tickPeriodNs = 0;
+    uint64_t tickCount = 0;
+    
+    std::thread networkThread;
+    std::atomic<bool> threadRunning{false};
+    std::atomic<bool> wakePending{false};
+    std::mutex hostMutex;
+    NetCommandQueue commandQueue;
+    Napi::ThreadSafeFunction threadCallback;
+    ENetSocket wakeSocket = ENET_SOCKET_NULL;
+    ENetAddress wakeAddress;
+    uint32_t threadMaxEvents = 256;
+    enet_uint32 threadWaitMs = 100;
+    
+    // @note guarded by hostMutex; shared with the network thread in threaded mode
+    std::unique_ptr<EventRing> eventRing;
+    // @note set while a ring wakeup is queued on the tsfn so bursts coalesce into one callback
+    std::shared_ptr<std::atomic<bool>> ringSignalPending = std::make_shared<std::atomic<bool>>(false);
+    
+    std::thread::id jsThreadId;
+    std::mutex pinMutex;
+    std::vector<PinnedPacket*> pendingPins;
 };
 
-Napi::FunctionReference ENetWrapper::constructor;
-
 Napi::Object ENetWrapper::Init(Napi::Env env, Napi::Object exports) {
     Napi::HandleScope scope(env);
 
@@ -71,33 +912,69 @@ Napi::Object ENetWrapper::Init(Napi::Env env, Napi::Object exports) {
         InstanceMethod("createHost", &ENetWrapper::CreateHost),
         InstanceMethod("destroyHost", &ENetWrapper::DestroyHost),
         InstanceMethod("hostService", &ENetWrapper::HostService),
+        InstanceMethod("hostServiceBatch", &ENetWrapper::HostServiceBatch),
         InstanceMethod("flush", &ENetWrapper::Flush),
         InstanceMethod("connect", &ENetWrapper::Connect),
         InstanceMethod("disconnect", &ENetWrapper::Disconnect),
         InstanceMethod("disconnectNow", &ENetWrapper::DisconnectNow),
         InstanceMethod("disconnectLater", &ENetWrapper::DisconnectLater),
+        InstanceMethod("setChannelPriority", &ENetWrapper::SetChannelPriority),
         InstanceMethod("sendPacket", &ENetWrapper::SendPacket),
         InstanceMethod("sendRawPacket", &ENetWrapper::SendRawPacket),
+        InstanceMethod("sendZeroCopy", &ENetWrapper::SendZeroCopy),
+        InstanceMethod("broadcast", &ENetWrapper::Broadcast),
+        InstanceMethod("sendToMany", &ENetWrapper::SendToMany),
+        InstanceMethod("sendMany", &ENetWrapper::SendMany),
         InstanceMethod("setCompression", &ENetWrapper::SetCompression),
         InstanceMethod("setChecksum", &ENetWrapper::SetChecksum),
-        InstanceMethod("setNewPacket", &ENetWrapper::SetNewPacket)
+        InstanceMethod("setNewPacket", &ENetWrapper::SetNewPacket),
+        InstanceMethod("setOffload", &ENetWrapper::SetOffload),
+        InstanceMethod("getPoolStats", &ENetWrapper::GetPoolStats),
+        InstanceMethod("getMemoryStats", &ENetWrapper::GetMemoryStats),
+        InstanceMethod("getCompressionStats", &ENetWrapper::GetCompressionStats),
+        InstanceMethod("getHostStats", &ENetWrapper::GetHostStats),
+        InstanceMethod("getPeerStats", &ENetWrapper::GetPeerStats),
+        InstanceMethod("setInstrument", &ENetWrapper::SetInstrument),
+        InstanceMethod("getLatencyHistograms", &ENetWrapper::GetLatencyHistograms),
+        InstanceMethod("setNetworkConditions", &ENetWrapper::SetNetworkConditions),
+        InstanceMethod("getNetworkConditions", &ENetWrapper::GetNetworkConditions),
+        InstanceMethod("startCapture", &ENetWrapper::StartCapture),
+        InstanceMethod("stopCapture", &ENetWrapper::StopCapture),
+        InstanceMethod("getCaptureStats", &ENetWrapper::GetCaptureStats),
+        InstanceMethod("startReplay", &ENetWrapper::StartReplay),
+        InstanceMethod("stopReplay", &ENetWrapper::StopReplay),
+        InstanceMethod("getReplayStats", &ENetWrapper::GetReplayStats),
+        InstanceMethod("attachEventRing", &ENetWrapper::AttachEventRing),
+        InstanceMethod("hostServiceRing", &ENetWrapper::HostServiceRing),
+        InstanceMethod("startPoll", &ENetWrapper::StartPoll),
+        InstanceMethod("stopPoll", &ENetWrapper::StopPoll),
+        InstanceMethod("receiveAll", &ENetWrapper::ReceiveAll),
+        InstanceMethod("flushAll", &ENetWrapper::FlushAll),
+        InstanceMethod("startTick", &ENetWrapper::StartTick),
+        InstanceMethod("stopTick", &ENetWrapper::StopTick),
+        InstanceMethod("startThread", &ENetWrapper::StartThread),
+        InstanceMethod("stopThread", &ENetWrapper::StopThread),
+        StaticMethod("now", &ENetWrapper::Now)
     });
 
-    constructor = Napi::Persistent(func);
-    constructor.SuppressDestruct();
-
     exports.Set("ENet", func);
     return exports;
 }
 
 ENetWrapper::ENetWrapper(const Napi::CallbackInfo& info) : Napi::ObjectWrap<ENetWrapper>(info) {
+    jsThreadId = std::this_thread::get_id();
 }
 
 ENetWrapper::~ENetWrapper() {
+    JoinThread();
+    ClosePoll();
+    CloseTick();
     if (host) {
+        RemoveInterceptors(host);
         enet_host_destroy(host);
         host = nullptr;
     }
+    DrainPins();
     if (initialized) {
         initialized = false;
         if (g_enetInitCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
@@ -114,7 +991,9 @@ Napi::Value ENetWrapper::Initialize(const Napi::CallbackInfo& info) {
     }
     
     if (g_enetInitCount.fetch_add(1, std::memory_order_acq_rel) == 0) {
-        if (enet_initialize() != 0) {
+        // @note every enet allocation goes through the slab allocator so hosts can be capped and measured
+        ENetCallbacks callbacks = SlabAllocator::Callbacks();
+        if (enet_initialize_with_callbacks(ENET_VERSION, &callbacks) != 0) {
             g_enetInitCount.fetch_sub(1, std::memory_order_acq_rel);
             Napi::TypeError::New(env, "Failed to initialize ENet").ThrowAsJavaScriptException();
             return env.Null();
@@ -128,7 +1007,11 @@ Napi::Value ENetWrapper::Initialize(const Napi::CallbackInfo& info) {
 Napi::Value ENetWrapper::Deinitialize(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
+    JoinThread();
+    ClosePoll();
+    CloseTick();
     if (host) {
+        RemoveInterceptors(host);
         enet_host_destroy(host);
         host = nullptr;
     }
@@ -151,8 +1034,13 @@ Napi::Value ENetWrapper::CreateHost(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     
+    JoinThread();
+    ClosePoll();
+    CloseTick();
     if (host) {
+        RemoveInterceptors(host);
         enet_host_destroy(host);
+        host = nullptr;
     }
     
     ENetAddress address;
@@ -190,6 +1078,8 @@ Napi::Value ENetWrapper::CreateHost(const Napi::CallbackInfo& info) {
     size_t channelLimit = 2;
     enet_uint32 incomingBandwidth = 0;
     enet_uint32 outgoingBandwidth = 0;
+    enet_uint32 throttleInterval = ENET_HOST_BANDWIDTH_THROTTLE_INTERVAL;
+    enet_uint32 hostFlags = 0;
     
     if (info.Length() > 1 && info[1].IsObject()) {
         Napi::Object options = info[1].As<Napi::Object>();
@@ -206,15 +1096,45 @@ Napi::Value ENetWrapper::CreateHost(const Napi::CallbackInfo& info) {
         if (options.Has("outgoingBandwidth")) {
             outgoingBandwidth = options.Get("outgoingBandwidth").As<Napi::Number>().Uint32Value();
         }
+        if (options.Has("bandwidthThrottleInterval")) {
+            throttleInterval = options.Get("bandwidthThrottleInterval").As<Napi::Number>().Uint32Value();
+        }
+        // @note turning the throttle off keeps bandwidth limit negotiation but stops periodic rebalancing
+        if (options.Has("bandwidthThrottle") && !options.Get("bandwidthThrottle").ToBoolean().Value()) {
+            throttleInterval = 0;
+        }
+        // @note lets several hosts, one per worker, bind the same port
+        if (options.Has("reusePort") && options.Get("reusePort").ToBoolean().Value()) {
+            hostFlags |= ENET_HOST_FLAG_REUSE_PORT;
+        }
+        // @note the allocator is process-wide, so the cap covers every host in this process and stays
+        // @note in effect for hosts created later; leaving the option out keeps the current cap
+        if (options.Has("memoryLimit") && !options.Get("memoryLimit").IsUndefined()) {
+            if (!options.Get("memoryLimit").IsNumber()) {
+                Napi::TypeError::New(env, "memoryLimit must be a number of bytes").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+            double memoryLimit = options.Get("memoryLimit").As<Napi::Number>().DoubleValue();
+            SlabAllocator::SetLimit(memoryLimit > 0 ? static_cast<size_t>(memoryLimit) : 0);
+        }
+        if (options.Has("streamChannels") && !options.Get("streamChannels").IsArray()) {
+            Napi::TypeError::New(env, "streamChannels must be an array of channel ids").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (options.Has("channelPriorities") && !options.Get("channelPriorities").IsArray()) {
+            Napi::TypeError::New(env, "channelPriorities must be an array of priorities").ThrowAsJavaScriptException();
+            return env.Null();
+        }
     }
     
-    host = enet_host_create(
+    host = enet_host_create_with_flags(
         ENET_ADDRESS_TYPE_IPV4,
         isServer ? &address : nullptr,
         peerCount,
         channelLimit,
         incomingBandwidth,
-        outgoingBandwidth
+        outgoingBandwidth,
+        hostFlags
     );
     
     if (!host) {
@@ -222,13 +1142,58 @@ Napi::Value ENetWrapper::CreateHost(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     
+    enet_host_bandwidth_throttle_interval(host, throttleInterval);
+    
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        
+        // @note budgets for fragmented messages still being reassembled; 0 keeps the enet default
+        double reassemblyLimit = options.Has("maxReassemblyData") && options.Get("maxReassemblyData").IsNumber()
+            ? options.Get("maxReassemblyData").As<Napi::Number>().DoubleValue() : 0;
+        if (reassemblyLimit > 0) {
+            host->maximumReassemblyData = static_cast<size_t>(reassemblyLimit);
+        }
+        double peerReassemblyLimit = options.Has("maxPeerReassemblyData") && options.Get("maxPeerReassemblyData").IsNumber()
+            ? options.Get("maxPeerReassemblyData").As<Napi::Number>().DoubleValue() : 0;
+        if (peerReassemblyLimit > 0) {
+            host->maximumPeerReassemblyData = static_cast<size_t>(peerReassemblyLimit);
+        }
+        
+        // @note reliable messages on these channels arrive as receiveChunk events instead of being reassembled
+        if (options.Has("streamChannels")) {
+            Napi::Array channels = options.Get("streamChannels").As<Napi::Array>();
+            for (uint32_t i = 0; i < channels.Length(); i++) {
+                Napi::Value channel = channels.Get(i);
+                if (channel.IsNumber() && channel.As<Napi::Number>().Uint32Value() < ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT) {
+                    enet_host_stream_channel(host, static_cast<enet_uint8>(channel.As<Napi::Number>().Uint32Value()), 1);
+                }
+            }
+        }
+        
+        // @note indexed by channel id; peers connected later, from either side, start with these priorities
+        if (options.Has("channelPriorities")) {
+            Napi::Array priorities = options.Get("channelPriorities").As<Napi::Array>();
+            for (uint32_t i = 0; i < priorities.Length() && i < ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT; i++) {
+                Napi::Value priority = priorities.Get(i);
+                if (priority.IsNumber()) {
+                    uint32_t value = priority.As<Napi::Number>().Uint32Value();
+                    enet_host_channel_priority(host, static_cast<enet_uint8>(i), static_cast<enet_uint8>(value > 255 ? 255 : value));
+                }
+            }
+        }
+    }
+    
     return Napi::Boolean::New(env, true);
 }
 
 Napi::Value ENetWrapper::DestroyHost(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
+    JoinThread();
+    ClosePoll();
+    CloseTick();
     if (host) {
+        RemoveInterceptors(host);
         enet_host_destroy(host);
         host = nullptr;
     }
@@ -244,11 +1209,18 @@ Napi::Value ENetWrapper::HostService(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     
+    if (threadRunning) {
+        Napi::TypeError::New(env, "Host is owned by the network thread").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
     enet_uint32 timeout = 0;
     if (info.Length() > 0 && info[0].IsNumber()) {
         timeout = info[0].As<Napi::Number>().Uint32Value();
     }
     
+    ReleaseHeldDatagrams(host);
+    
     ENetEvent event;
     int result = enet_host_service(host, &event, timeout);
     
@@ -261,39 +1233,61 @@ Napi::Value ENetWrapper::HostService(const Napi::CallbackInfo& info) {
         return env.Null(); // No event
     }
     
-    Napi::Object eventObj = Napi::Object::New(env);
+    return ConvertEvent(env, host, event);
+}
+
+int ENetWrapper::ServiceEvents(Napi::Env env, Napi::Array& events, uint32_t maxEvents, enet_uint32 timeout) {
+    uint32_t count = 0;
+    ENetEvent event;
     
-    switch (event.type) {
-        case ENET_EVENT_TYPE_CONNECT:
-            eventObj.Set("type", "connect");
-            eventObj.Set("peer", Napi::BigInt::New(env, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(event.peer))));
-            break;
-            
-        case ENET_EVENT_TYPE_DISCONNECT:
-            eventObj.Set("type", "disconnect");
-            eventObj.Set("peer", Napi::BigInt::New(env, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(event.peer))));
-            eventObj.Set("data", Napi::Number::New(env, event.data));
-            break;
-            
-        case ENET_EVENT_TYPE_RECEIVE:
-            eventObj.Set("type", "receive");
-            eventObj.Set("peer", Napi::BigInt::New(env, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(event.peer))));
-            eventObj.Set("channelID", Napi::Number::New(env, event.channelID));
-            
-            // Convert packet data to Buffer
-            if (event.packet) {
-                auto buffer = Napi::Buffer<enet_uint8>::Copy(env, event.packet->data, event.packet->dataLength);
-                eventObj.Set("data", buffer);
-                enet_packet_destroy(event.packet);
-            }
-            break;
-            
-        default:
-            eventObj.Set("type", "unknown");
+    ReleaseHeldDatagrams(host);
+    
+    // @note one full send/receive pass, then drain whatever it left in the dispatch queue
+    int result = enet_host_service(host, &event, timeout);
+    while (result > 0) {
+        events.Set(count++, ConvertEvent(env, host, event));
+        if (count >= maxEvents) {
             break;
+        }
+        result = enet_host_check_events(host, &event);
     }
     
-    return eventObj;
+    return result;
+}
+
+Napi::Value ENetWrapper::HostServiceBatch(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (threadRunning) {
+        Napi::TypeError::New(env, "Host is owned by the network thread").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    uint32_t maxEvents = 256;
+    if (info.Length() > 0 && info[0].IsNumber()) {
+        maxEvents = info[0].As<Napi::Number>().Uint32Value();
+    }
+    if (maxEvents == 0) {
+        maxEvents = 1;
+    }
+    
+    enet_uint32 timeout = 0;
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        timeout = info[1].As<Napi::Number>().Uint32Value();
+    }
+    
+    Napi::Array events = Napi::Array::New(env);
+    if (ServiceEvents(env, events, maxEvents, timeout) < 0) {
+        Napi::TypeError::New(env, "Error occurred during host service").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    return events;
 }
 
 Napi::Value ENetWrapper::Flush(const Napi::CallbackInfo& info) {
@@ -302,6 +1296,10 @@ Napi::Value ENetWrapper::Flush(const Napi::CallbackInfo& info) {
         Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
         return env.Null();
     }
+    if (threadRunning) {
+        WakeThread();
+        return env.Undefined();
+    }
     enet_host_flush(host);
     return env.Undefined();
 }
@@ -343,27 +1341,50 @@ Napi::Value ENetWrapper::Connect(const Napi::CallbackInfo& info) {
         data = info[3].As<Napi::Number>().Uint32Value();
     }
     
-    ENetPeer* peer = enet_host_connect(host, &enetAddress, channelCount, data);
+    ENetPeer* peer = nullptr;
+    uint32_t handle = 0;
+    {
+        std::lock_guard<std::mutex> lock(hostMutex);
+        peer = enet_host_connect(host, &enetAddress, channelCount, data);
+        if (peer) {
+            handle = PeerHandle(peer, peer->generation);
+            // @note per-connection priorities override the host defaults the peer was created with
+            if (info.Length() > 4 && info[4].IsArray()) {
+                Napi::Array priorities = info[4].As<Napi::Array>();
+                for (uint32_t i = 0; i < priorities.Length() && i < peer->channelCount; i++) {
+                    Napi::Value priority = priorities.Get(i);
+                    if (priority.IsNumber()) {
+                        uint32_t value = priority.As<Napi::Number>().Uint32Value();
+                        enet_peer_channel_priority(peer, (enet_uint8)i, (enet_uint8)(value > 255 ? 255 : value));
+                    }
+                }
+            }
+        }
+    }
     
     if (!peer) {
         Napi::TypeError::New(env, "Failed to connect").ThrowAsJavaScriptException();
         return env.Null();
     }
+    if (threadRunning) {
+        WakeThread();
+    } else {
+        ScheduleFlush();
+    }
     
-    return Napi::BigInt::New(env, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(peer)));
+    return Napi::Number::New(env, handle);
 }
 
 Napi::Value ENetWrapper::Disconnect(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
     if (info.Length() < 1 || !(info[0].IsBigInt() || info[0].IsNumber())) {
-        Napi::TypeError::New(env, "Expected peer ID (bigint or number)").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Expected peer ID").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    bool ok = false;
-    ENetPeer* peer = JsValueToPeer(info[0], ok);
-    if (!ok || !peer) {
+    uint32_t handle = 0;
+    if (!JsValueToPeerHandle(info[0], handle)) {
         Napi::TypeError::New(env, "Invalid peer id").ThrowAsJavaScriptException();
         return env.Null();
     }
@@ -373,20 +1394,60 @@ Napi::Value ENetWrapper::Disconnect(const Napi::CallbackInfo& info) {
         data = info[1].As<Napi::Number>().Uint32Value();
     }
     
-    enet_peer_disconnect(peer, data);
+    if (threadRunning) {
+        QueueThreadCommand(NetCommand::Disconnect, handle, 0, nullptr, data);
+        return env.Undefined();
+    }
+    // @note a stale handle names a peer that is already gone
+    ENetPeer* peer = PeerFromHandle(host, handle);
+    if (peer) {
+        enet_peer_disconnect(peer, data);
+        ScheduleFlush();
+    }
     return env.Undefined();
 }
 
+Napi::Value ENetWrapper::SetChannelPriority(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 3 || !(info[0].IsBigInt() || info[0].IsNumber()) || !info[1].IsNumber() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected peer ID, channel ID (number) and priority (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    uint32_t handle = 0;
+    if (!JsValueToPeerHandle(info[0], handle)) {
+        Napi::TypeError::New(env, "Invalid peer id").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    uint32_t channelID = info[1].As<Napi::Number>().Uint32Value();
+    uint32_t priority = info[2].As<Napi::Number>().Uint32Value();
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    // @note commands already queued keep the priority they were queued with, so later ones may overtake them
+    ENetPeer* peer = PeerFromHandle(host, handle);
+    if (!peer || channelID >= peer->channelCount) {
+        return Napi::Boolean::New(env, false);
+    }
+    enet_peer_channel_priority(peer, (enet_uint8)channelID, (enet_uint8)(priority > 255 ? 255 : priority));
+    return Napi::Boolean::New(env, true);
+}
+
 Napi::Value ENetWrapper::DisconnectNow(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     if (info.Length() < 1 || !(info[0].IsBigInt() || info[0].IsNumber())) {
-        Napi::TypeError::New(env, "Expected peer ID (bigint or number)").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Expected peer ID").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    bool ok = false;
-    ENetPeer* peer = JsValueToPeer(info[0], ok);
-    if (!ok || !peer) {
+    uint32_t handle = 0;
+    if (!JsValueToPeerHandle(info[0], handle)) {
         Napi::TypeError::New(env, "Invalid peer id").ThrowAsJavaScriptException();
         return env.Null();
     }
@@ -395,20 +1456,27 @@ Napi::Value ENetWrapper::DisconnectNow(const Napi::CallbackInfo& info) {
     if (info.Length() > 1 && info[1].IsNumber()) {
         data = info[1].As<Napi::Number>().Uint32Value();
     }
-    enet_peer_disconnect_now(peer, data);
+    if (threadRunning) {
+        QueueThreadCommand(NetCommand::DisconnectNow, handle, 0, nullptr, data);
+        return env.Undefined();
+    }
+    // @note a stale handle names a peer that is already gone
+    ENetPeer* peer = PeerFromHandle(host, handle);
+    if (peer) {
+        enet_peer_disconnect_now(peer, data);
+    }
     return env.Undefined();
 }
 
 Napi::Value ENetWrapper::DisconnectLater(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     if (info.Length() < 1 || !(info[0].IsBigInt() || info[0].IsNumber())) {
-        Napi::TypeError::New(env, "Expected peer ID (bigint or number)").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Expected peer ID").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    bool ok = false;
-    ENetPeer* peer = JsValueToPeer(info[0], ok);
-    if (!ok || !peer) {
+    uint32_t handle = 0;
+    if (!JsValueToPeerHandle(info[0], handle)) {
         Napi::TypeError::New(env, "Invalid peer id").ThrowAsJavaScriptException();
         return env.Null();
     }
@@ -417,7 +1485,16 @@ Napi::Value ENetWrapper::DisconnectLater(const Napi::CallbackInfo& info) {
     if (info.Length() > 1 && info[1].IsNumber()) {
         data = info[1].As<Napi::Number>().Uint32Value();
     }
-    enet_peer_disconnect_later(peer, data);
+    if (threadRunning) {
+        QueueThreadCommand(NetCommand::DisconnectLater, handle, 0, nullptr, data);
+        return env.Undefined();
+    }
+    // @note a stale handle names a peer that is already gone
+    ENetPeer* peer = PeerFromHandle(host, handle);
+    if (peer) {
+        enet_peer_disconnect_later(peer, data);
+        ScheduleFlush();
+    }
     return env.Undefined();
 }
 
@@ -425,13 +1502,12 @@ Napi::Value ENetWrapper::SendPacket(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
     if (info.Length() < 3 || !(info[0].IsBigInt() || info[0].IsNumber()) || !info[1].IsNumber()) {
-        Napi::TypeError::New(env, "Expected peer ID (bigint), channel ID, and data").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Expected peer ID, channel ID, and data").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    bool ok = false;
-    ENetPeer* peer = JsValueToPeer(info[0], ok);
-    if (!ok || !peer) {
+    uint32_t handle = 0;
+    if (!JsValueToPeerHandle(info[0], handle)) {
         Napi::TypeError::New(env, "Invalid peer id").ThrowAsJavaScriptException();
         return env.Null();
     }
@@ -462,9 +1538,19 @@ Napi::Value ENetWrapper::SendPacket(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     
-    int result = enet_peer_send(peer, channelID, packet);
+    if (threadRunning) {
+        // @note the network thread reports nothing back; queued sends count as accepted
+        QueueThreadCommand(NetCommand::Send, handle, channelID, packet, 0);
+        return Napi::Number::New(env, 0);
+    }
+    
+    // @note a stale handle fails like a send to a disconnected peer
+    ENetPeer* peer = PeerFromHandle(host, handle);
+    int result = peer ? enet_peer_send(peer, channelID, packet) : -1;
     if (result < 0) {
         enet_packet_destroy(packet);
+    } else {
+        ScheduleFlush();
     }
     return Napi::Number::New(env, result);
 }
@@ -473,13 +1559,12 @@ Napi::Value ENetWrapper::SendRawPacket(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
     if (info.Length() < 3 || !(info[0].IsBigInt() || info[0].IsNumber()) || !info[1].IsNumber()) {
-        Napi::TypeError::New(env, "Expected peer ID (bigint), channel ID, and data").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Expected peer ID, channel ID, and data").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    bool ok = false;
-    ENetPeer* peer = JsValueToPeer(info[0], ok);
-    if (!ok || !peer) {
+    uint32_t handle = 0;
+    if (!JsValueToPeerHandle(info[0], handle)) {
         Napi::TypeError::New(env, "Invalid peer id").ThrowAsJavaScriptException();
         return env.Null();
     }
@@ -520,13 +1605,321 @@ Napi::Value ENetWrapper::SendRawPacket(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     
-    int result = enet_peer_send(peer, channelID, packet);
+    if (threadRunning) {
+        // @note the network thread reports nothing back; queued sends count as accepted
+        QueueThreadCommand(NetCommand::Send, handle, channelID, packet, 0);
+        return Napi::Number::New(env, 0);
+    }
+    
+    // @note a stale handle fails like a send to a disconnected peer
+    ENetPeer* peer = PeerFromHandle(host, handle);
+    int result = peer ? enet_peer_send(peer, channelID, packet) : -1;
+    if (result < 0) {
+        enet_packet_destroy(packet);
+    } else {
+        ScheduleFlush();
+    }
+    return Napi::Number::New(env, result);
+}
+
+Napi::Value ENetWrapper::SendZeroCopy(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 3 || !(info[0].IsBigInt() || info[0].IsNumber()) || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected peer ID, channel ID, and data").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    uint32_t handle = 0;
+    if (!JsValueToPeerHandle(info[0], handle)) {
+        Napi::TypeError::New(env, "Invalid peer id").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    enet_uint8 channelID = info[1].As<Napi::Number>().Uint32Value();
+    
+    enet_uint32 flags = ENET_PACKET_FLAG_RELIABLE;
+    if (info.Length() > 3 && info[3].IsNumber()) {
+        flags = info[3].As<Napi::Number>().Uint32Value();
+    }
+    
+    if (!info[2].IsTypedArray() && !info[2].IsArrayBuffer()) {
+        Napi::TypeError::New(env, "Data must be a Buffer, TypedArray, or ArrayBuffer for zero-copy packet").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    ENetPacket* packet = CreatePinnedPacket(info[2], flags);
+    if (!packet) {
+        Napi::TypeError::New(env, "Failed to create zero-copy packet").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (threadRunning) {
+        // @note the network thread reports nothing back; queued sends count as accepted
+        QueueThreadCommand(NetCommand::Send, handle, channelID, packet, 0);
+        return Napi::Number::New(env, 0);
+    }
+    
+    // @note a stale handle fails like a send to a disconnected peer
+    ENetPeer* peer = PeerFromHandle(host, handle);
+    int result = peer ? enet_peer_send(peer, channelID, packet) : -1;
     if (result < 0) {
         enet_packet_destroy(packet);
+    } else {
+        ScheduleFlush();
     }
     return Napi::Number::New(env, result);
 }
 
+Napi::Value ENetWrapper::Broadcast(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 2 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected channel ID and data").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    enet_uint8 channelID = info[0].As<Napi::Number>().Uint32Value();
+    
+    enet_uint32 flags = ENET_PACKET_FLAG_RELIABLE;
+    if (info.Length() > 2 && info[2].IsNumber()) {
+        flags = info[2].As<Napi::Number>().Uint32Value();
+    }
+    
+    ENetPacket* packet = CreatePacketFromValue(info[1], flags);
+    if (!packet) {
+        Napi::TypeError::New(env, "Data must be a Buffer, TypedArray, ArrayBuffer, or string").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (threadRunning) {
+        QueueThreadCommand(NetCommand::Broadcast, 0, channelID, packet, 0);
+        return env.Undefined();
+    }
+    
+    // @note enet_host_broadcast shares the packet across connected peers and frees it if unused
+    enet_host_broadcast(host, channelID, packet);
+    ScheduleFlush();
+    return env.Undefined();
+}
+
+Napi::Value ENetWrapper::SendMany(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 2 || !info[0].IsTypedArray() || info[0].As<Napi::TypedArray>().TypedArrayType() != napi_uint32_array) {
+        Napi::TypeError::New(env, "Expected Uint32Array of send descriptors and payload").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    const uint8_t* payload = nullptr;
+    size_t payloadLength = 0;
+    if (info[1].IsTypedArray()) {
+        Napi::TypedArray typedArray = info[1].As<Napi::TypedArray>();
+        payload = static_cast<const uint8_t*>(typedArray.ArrayBuffer().Data()) + typedArray.ByteOffset();
+        payloadLength = typedArray.ByteLength();
+    } else if (info[1].IsArrayBuffer()) {
+        Napi::ArrayBuffer arrayBuffer = info[1].As<Napi::ArrayBuffer>();
+        payload = static_cast<const uint8_t*>(arrayBuffer.Data());
+        payloadLength = arrayBuffer.ByteLength();
+    } else {
+        Napi::TypeError::New(env, "Payload must be a Buffer, TypedArray, or ArrayBuffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Uint32Array descriptors = info[0].As<Napi::Uint32Array>();
+    const uint32_t* records = descriptors.Data();
+    size_t count = descriptors.ElementLength() / kSendRecordWords;
+    
+    Napi::Int32Array results;
+    if (info.Length() > 2 && info[2].IsTypedArray()) {
+        Napi::TypedArray out = info[2].As<Napi::TypedArray>();
+        if (out.TypedArrayType() != napi_int32_array || out.ElementLength() < count) {
+            Napi::TypeError::New(env, "Results must be an Int32Array with one slot per descriptor").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        results = info[2].As<Napi::Int32Array>();
+    } else {
+        results = Napi::Int32Array::New(env, count);
+    }
+    int32_t* status = results.Data();
+    
+    // @note validate the whole batch first so a bad record never leaves it half queued
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t* record = records + i * kSendRecordWords;
+        if (record[kSendRecordOffset] > payloadLength || record[kSendRecordLength] > payloadLength - record[kSendRecordOffset]) {
+            Napi::TypeError::New(env, "Send descriptor outside of payload").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+    
+    NetCommand* command = nullptr;
+    if (threadRunning) {
+        command = new NetCommand();
+        command->type = NetCommand::SendBatch;
+        command->sends.reserve(count);
+    }
+    
+    bool queued = false;
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t* record = records + i * kSendRecordWords;
+        // @note disallow NO_ALLOCATE: the payload is copied, js may reuse it right away
+        enet_uint32 flags = record[kSendRecordFlags] & ~ENET_PACKET_FLAG_NO_ALLOCATE;
+        enet_uint8 channelID = static_cast<enet_uint8>(record[kSendRecordChannel]);
+        ENetPacket* packet = enet_packet_create(payload + record[kSendRecordOffset], record[kSendRecordLength], flags);
+        if (!packet) {
+            status[i] = -1;
+            continue;
+        }
+        
+        if (command != nullptr) {
+            // @note the network thread reports nothing back; queued sends count as accepted
+            command->sends.push_back({ record[kSendRecordPeer], channelID, packet });
+            status[i] = 0;
+            continue;
+        }
+        
+        ENetPeer* peer = PeerFromHandle(host, record[kSendRecordPeer]);
+        status[i] = peer ? enet_peer_send(peer, channelID, packet) : -1;
+        if (status[i] < 0) {
+            enet_packet_destroy(packet);
+        } else {
+            queued = true;
+        }
+    }
+    
+    if (command != nullptr) {
+        commandQueue.Push(command);
+        WakeThread();
+    } else if (queued) {
+        ScheduleFlush();
+    }
+    
+    return results;
+}
+
+Napi::Value ENetWrapper::SendToMany(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 3 || !info[0].IsArray() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected peer ID array, channel ID, and data").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Array peerIds = info[0].As<Napi::Array>();
+    enet_uint8 channelID = info[1].As<Napi::Number>().Uint32Value();
+    
+    enet_uint32 flags = ENET_PACKET_FLAG_RELIABLE;
+    if (info.Length() > 3 && info[3].IsNumber()) {
+        flags = info[3].As<Napi::Number>().Uint32Value();
+    }
+    
+    std::vector<uint32_t> peers;
+    peers.reserve(peerIds.Length());
+    for (uint32_t i = 0; i < peerIds.Length(); i++) {
+        uint32_t handle = 0;
+        if (!JsValueToPeerHandle(peerIds.Get(i), handle)) {
+            Napi::TypeError::New(env, "Invalid peer id").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        peers.push_back(handle);
+    }
+    
+    ENetPacket* packet = CreatePacketFromValue(info[2], flags);
+    if (!packet) {
+        Napi::TypeError::New(env, "Data must be a Buffer, TypedArray, ArrayBuffer, or string").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (threadRunning) {
+        // @note the network thread reports nothing back; every listed peer counts as queued
+        int count = static_cast<int>(peers.size());
+        NetCommand* command = new NetCommand();
+        command->type = NetCommand::SendMany;
+        command->channelID = channelID;
+        command->packet = packet;
+        command->peers = std::move(peers);
+        commandQueue.Push(command);
+        WakeThread();
+        return Napi::Number::New(env, count);
+    }
+    
+    int sent = SendToPeers(host, peers, channelID, packet);
+    if (sent > 0) {
+        ScheduleFlush();
+    }
+    return Napi::Number::New(env, sent);
+}
+
+ENetPacket* ENetWrapper::CreatePinnedPacket(const Napi::Value& value, enet_uint32 flags) {
+    uint8_t* data = nullptr;
+    size_t length = 0;
+    
+    if (value.IsTypedArray()) {
+        Napi::TypedArray typedArray = value.As<Napi::TypedArray>();
+        data = static_cast<uint8_t*>(typedArray.ArrayBuffer().Data()) + typedArray.ByteOffset();
+        length = typedArray.ByteLength();
+    } else {
+        Napi::ArrayBuffer arrayBuffer = value.As<Napi::ArrayBuffer>();
+        data = static_cast<uint8_t*>(arrayBuffer.Data());
+        length = arrayBuffer.ByteLength();
+    }
+    
+    // @note enet reads straight from js memory; callers must not mutate or detach it until sent
+    ENetPacket* packet = enet_packet_create(data, length, flags | ENET_PACKET_FLAG_NO_ALLOCATE);
+    if (!packet) {
+        return nullptr;
+    }
+    
+    PinnedPacket* pin = new PinnedPacket();
+    pin->reference = Napi::Persistent(value.As<Napi::Object>());
+    pin->owner = this;
+    packet->userData = pin;
+    packet->freeCallback = OnPinnedPacketFree;
+    return packet;
+}
+
+void ENET_CALLBACK ENetWrapper::OnPinnedPacketFree(ENetPacket* packet) {
+    PinnedPacket* pin = static_cast<PinnedPacket*>(packet->userData);
+    packet->userData = nullptr;
+    if (!pin) {
+        return;
+    }
+    
+    ENetWrapper* owner = pin->owner;
+    if (std::this_thread::get_id() == owner->jsThreadId) {
+        delete pin;
+        return;
+    }
+    
+    // @note freed on the network thread; the reference goes back to js with the next post
+    std::lock_guard<std::mutex> lock(owner->pinMutex);
+    owner->pendingPins.push_back(pin);
+}
+
+void ENetWrapper::DrainPins() {
+    std::vector<PinnedPacket*> pins;
+    {
+        std::lock_guard<std::mutex> lock(pinMutex);
+        pins.swap(pendingPins);
+    }
+    for (PinnedPacket* pin : pins) {
+        delete pin;
+    }
+}
+
 Napi::Value ENetWrapper::SetCompression(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
@@ -535,18 +1928,68 @@ Napi::Value ENetWrapper::SetCompression(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     
+    // @note true selects the range coder for compatibility; 'range' or 'lz4' pick a codec explicitly
+    std::string algorithm = "range";
     bool enable = true;
     if (info.Length() > 0 && info[0].IsBoolean()) {
         enable = info[0].As<Napi::Boolean>().Value();
+    } else if (info.Length() > 0 && info[0].IsString()) {
+        algorithm = info[0].As<Napi::String>().Utf8Value();
+        enable = algorithm != "none";
     }
     
-    if (enable) {
-        int result = enet_host_compress_with_range_coder(host);
-        return Napi::Number::New(env, result);
-    } else {
+    if (enable && algorithm != "range" && algorithm != "lz4") {
+        Napi::TypeError::New(env, "Unknown compression algorithm").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    // @note options: { threshold, dictionary }; both ends must agree on the algorithm and dictionary
+    size_t threshold = 0;
+    const void* dictionary = nullptr;
+    size_t dictionaryLength = 0;
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        Napi::Value value = options.Get("threshold");
+        if (value.IsNumber()) {
+            int64_t number = value.As<Napi::Number>().Int64Value();
+            threshold = number > 0 ? static_cast<size_t>(number) : 0;
+        }
+        value = options.Get("dictionary");
+        if (value.IsTypedArray()) {
+            Napi::TypedArray typedArray = value.As<Napi::TypedArray>();
+            dictionary = static_cast<uint8_t*>(typedArray.ArrayBuffer().Data()) + typedArray.ByteOffset();
+            dictionaryLength = typedArray.ByteLength();
+        } else if (value.IsArrayBuffer()) {
+            Napi::ArrayBuffer arrayBuffer = value.As<Napi::ArrayBuffer>();
+            dictionary = arrayBuffer.Data();
+            dictionaryLength = arrayBuffer.ByteLength();
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    if (!enable) {
         enet_host_compress(host, NULL);
         return Napi::Boolean::New(env, true);
     }
+    
+    // @note enet_host_compress copies the struct out, so the codec is installed first and then moved into the wrapper
+    int result = algorithm == "lz4"
+        ? enet_host_compress_with_lz4(host, dictionary, dictionaryLength)
+        : enet_host_compress_with_range_coder(host);
+    if (result < 0) {
+        return Napi::Number::New(env, result);
+    }
+    
+    MeteredCompressor* metered = new MeteredCompressor();
+    metered->inner = host->compressor;
+    metered->algorithm = algorithm == "lz4" ? "lz4" : "range";
+    metered->threshold = threshold;
+    host->compressor.context = metered;
+    host->compressor.compress = MeteredCompressor::Compress;
+    host->compressor.decompress = MeteredCompressor::Decompress;
+    host->compressor.destroy = MeteredCompressor::Destroy;
+    return Napi::Number::New(env, result);
 }
 
 Napi::Value ENetWrapper::SetChecksum(const Napi::CallbackInfo& info) {
@@ -557,6 +2000,8 @@ Napi::Value ENetWrapper::SetChecksum(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
     bool enable = true;
     if (info.Length() > 0 && info[0].IsBoolean()) {
         enable = info[0].As<Napi::Boolean>().Value();
@@ -579,6 +2024,8 @@ Napi::Value ENetWrapper::SetNewPacket(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
     bool enable = false;
     bool isServer = false;
     
@@ -599,6 +2046,1352 @@ Napi::Value ENetWrapper::SetNewPacket(const Napi::CallbackInfo& info) {
     return Napi::Boolean::New(env, true);
 }
 
+Napi::Value ENetWrapper::SetOffload(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    enet_uint32 flags = 0;
+    if (info.Length() > 0 && info[0].IsBoolean() && info[0].As<Napi::Boolean>().Value()) {
+        flags |= ENET_HOST_OFFLOAD_GSO;
+    }
+    if (info.Length() > 1 && info[1].IsBoolean() && info[1].As<Napi::Boolean>().Value()) {
+        flags |= ENET_HOST_OFFLOAD_GRO;
+    }
+    
+    // @note unsupported modes are silently left off; report what the socket accepted
+    enet_uint32 enabled = enet_host_offload(host, flags);
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("gso", Napi::Boolean::New(env, (enabled & ENET_HOST_OFFLOAD_GSO) != 0));
+    result.Set("gro", Napi::Boolean::New(env, (enabled & ENET_HOST_OFFLOAD_GRO) != 0));
+    return result;
+}
+
+Napi::Value ENetWrapper::GetPoolStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("outgoingCommands", PoolToObject(env, host->outgoingCommandPool));
+    result.Set("acknowledgements", PoolToObject(env, host->acknowledgementPool));
+    result.Set("incomingCommands", PoolToObject(env, host->incomingCommandPool));
+    result.Set("fragmentBitmaps", PoolToObject(env, host->fragmentBitmapPool));
+    return result;
+}
+
+Napi::Value ENetWrapper::GetMemoryStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    SlabAllocatorStats stats = SlabAllocator::GetStats();
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("inUse", Napi::Number::New(env, static_cast<double>(stats.inUse)));
+    result.Set("highWater", Napi::Number::New(env, static_cast<double>(stats.highWater)));
+    result.Set("reserved", Napi::Number::New(env, static_cast<double>(stats.reserved)));
+    result.Set("limit", Napi::Number::New(env, static_cast<double>(stats.limit)));
+    result.Set("failures", Napi::Number::New(env, static_cast<double>(stats.failures)));
+    return result;
+}
+
+Napi::Value ENetWrapper::GetCompressionStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    MeteredCompressor* metered = GetMeteredCompressor(host);
+    if (!metered) {
+        return env.Null();
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("algorithm", Napi::String::New(env, metered->algorithm));
+    result.Set("threshold", Napi::Number::New(env, static_cast<double>(metered->threshold)));
+    result.Set("compressed", Napi::Number::New(env, static_cast<double>(metered->compressed)));
+    result.Set("incompressible", Napi::Number::New(env, static_cast<double>(metered->incompressible)));
+    result.Set("skipped", Napi::Number::New(env, static_cast<double>(metered->skipped)));
+    result.Set("bytesIn", Napi::Number::New(env, static_cast<double>(metered->bytesIn)));
+    result.Set("bytesOut", Napi::Number::New(env, static_cast<double>(metered->bytesOut)));
+    result.Set("ratio", Napi::Number::New(env, metered->bytesIn ? static_cast<double>(metered->bytesOut) / metered->bytesIn : 1.0));
+    result.Set("compressNs", Napi::Number::New(env, static_cast<double>(metered->compressNs)));
+    result.Set("decompressed", Napi::Number::New(env, static_cast<double>(metered->decompressed)));
+    result.Set("decompressedBytesIn", Napi::Number::New(env, static_cast<double>(metered->decompressedBytesIn)));
+    result.Set("decompressedBytesOut", Napi::Number::New(env, static_cast<double>(metered->decompressedBytesOut)));
+    result.Set("decompressNs", Napi::Number::New(env, static_cast<double>(metered->decompressNs)));
+    return result;
+}
+
+Napi::Value ENetWrapper::GetHostStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    StatsArray out;
+    if (info.Length() < 1 || !out.Bind(info[0]) || out.Length() < kHostStatsLength) {
+        Napi::TypeError::New(env, "Expected a Float64Array or BigUint64Array of HOST_STATS_LENGTH elements").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    uint64_t inTransit = 0, waiting = 0;
+    for (ENetPeer* peer = host->activePeers; peer != nullptr; peer = peer->activeNext) {
+        inTransit += peer->reliableDataInTransit;
+        waiting += peer->totalWaitingData;
+    }
+    
+    out.Set(kHostStatsTotalSentData, host->totalSentData);
+    out.Set(kHostStatsTotalSentPackets, host->totalSentPackets);
+    out.Set(kHostStatsTotalReceivedData, host->totalReceivedData);
+    out.Set(kHostStatsTotalReceivedPackets, host->totalReceivedPackets);
+    out.Set(kHostStatsPeerCount, host->peerCount);
+    out.Set(kHostStatsConnectedPeers, host->connectedPeers);
+    out.Set(kHostStatsBandwidthLimitedPeers, host->bandwidthLimitedPeers);
+    out.Set(kHostStatsIncomingBandwidth, host->incomingBandwidth);
+    out.Set(kHostStatsOutgoingBandwidth, host->outgoingBandwidth);
+    out.Set(kHostStatsServiceTime, host->serviceTime);
+    out.Set(kHostStatsOutgoingCommands, host->outgoingCommandPool.inUse);
+    out.Set(kHostStatsAcknowledgements, host->acknowledgementPool.inUse);
+    out.Set(kHostStatsIncomingCommands, host->incomingCommandPool.inUse);
+    out.Set(kHostStatsTotalRetransmits, host->totalRetransmits);
+    out.Set(kHostStatsReliableDataInTransit, inTransit);
+    out.Set(kHostStatsTotalWaitingData, waiting);
+    out.Set(kHostStatsReassemblyData, host->reassemblyData);
+    return info[0];
+}
+
+Napi::Value ENetWrapper::GetPeerStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    // @note (peerIds | null, out); rows of PEER_STATS_STRIDE fields, one per listed or occupied peer slot
+    StatsArray out;
+    if (info.Length() < 2 || !out.Bind(info[1])) {
+        Napi::TypeError::New(env, "Expected peer ID array or null, and a Float64Array or BigUint64Array").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    size_t capacity = out.Length() / kPeerStatsStride;
+    size_t rows = 0;
+    
+    if (info[0].IsArray()) {
+        Napi::Array peerIds = info[0].As<Napi::Array>();
+        uint32_t count = peerIds.Length();
+        
+        std::lock_guard<std::mutex> lock(hostMutex);
+        
+        for (uint32_t i = 0; i < count && rows < capacity; i++) {
+            uint32_t handle = 0;
+            ENetPeer* peer = JsValueToPeerHandle(peerIds.Get(i), handle) ? PeerFromHandle(host, handle) : nullptr;
+            if (!peer) {
+                // @note unknown ids keep their row so output lines up with the input; everything but the id is zero
+                for (size_t field = 0; field < kPeerStatsStride; field++) {
+                    out.Set(rows * kPeerStatsStride + field, 0);
+                }
+                out.Set(rows * kPeerStatsStride + kPeerStatsId, handle);
+            } else {
+                WritePeerStats(out, rows * kPeerStatsStride, peer);
+            }
+            rows++;
+        }
+        return Napi::Number::New(env, static_cast<double>(rows));
+    }
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    for (ENetPeer* peer = host->activePeers; peer != nullptr && rows < capacity; peer = peer->activeNext) {
+        WritePeerStats(out, rows * kPeerStatsStride, peer);
+        rows++;
+    }
+    return Napi::Number::New(env, static_cast<double>(rows));
+}
+
+Napi::Value ENetWrapper::SetInstrument(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    bool enable = true;
+    if (info.Length() > 0 && info[0].IsBoolean()) {
+        enable = info[0].As<Napi::Boolean>().Value();
+    }
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    // @note false when enet was built without ENET_INSTRUMENT; enabling again clears the histograms
+    return Napi::Boolean::New(env, enet_host_instrument(host, enable ? 1 : 0) == 0);
+}
+
+Napi::Value ENetWrapper::GetLatencyHistograms(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    if (host->histograms == nullptr) {
+        return env.Null();
+    }
+    
+    // @note nanoseconds; indexed by ENetInstrumentStage
+    static const char* const stageNames[ENET_INSTRUMENT_STAGE_COUNT] = {
+        "socketReceive", "protocol", "dispatch", "conversion", "queueToWire"
+    };
+    Napi::Object result = Napi::Object::New(env);
+    for (int stage = 0; stage < ENET_INSTRUMENT_STAGE_COUNT; stage++) {
+        result.Set(stageNames[stage], HistogramToObject(env, host->histograms[stage]));
+    }
+    return result;
+}
+
+Napi::Value ENetWrapper::SetNetworkConditions(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    double loss = 0.0;
+    enet_uint32 latency = 0;
+    enet_uint32 jitter = 0;
+    if (info.Length() > 0 && info[0].IsObject()) {
+        Napi::Object options = info[0].As<Napi::Object>();
+        if (options.Has("loss") && options.Get("loss").IsNumber()) {
+            loss = options.Get("loss").As<Napi::Number>().DoubleValue();
+        }
+        if (options.Has("latency") && options.Get("latency").IsNumber()) {
+            latency = options.Get("latency").As<Napi::Number>().Uint32Value();
+        }
+        if (options.Has("jitter") && options.Get("jitter").IsNumber()) {
+            jitter = options.Get("jitter").As<Napi::Number>().Uint32Value();
+        }
+    } else if (info.Length() > 0 && !info[0].IsNull() && !info[0].IsUndefined()) {
+        Napi::TypeError::New(env, "Expected options object or null").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (!(loss >= 0.0 && loss <= 1.0)) {
+        Napi::RangeError::New(env, "loss must be between 0 and 1").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    // @note the host has a single intercept slot, so conditions cannot share it with another callback
+    if (host->intercept != nullptr && GetNetworkConditioner(host) == nullptr) {
+        Napi::TypeError::New(env, "Host already has an intercept callback").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    // @note all zero removes the conditioner and delivers whatever it was holding back
+    if (loss == 0.0 && latency == 0 && jitter == 0) {
+        RemoveNetworkConditioner(host, true);
+        return Napi::Boolean::New(env, true);
+    }
+    
+    NetworkConditioner* conditioner = GetNetworkConditioner(host);
+    if (conditioner == nullptr) {
+        conditioner = new NetworkConditioner();
+        host->data = conditioner;
+        host->intercept = NetworkConditioner::Intercept;
+    }
+    conditioner->loss = loss;
+    conditioner->latency = latency;
+    conditioner->jitter = jitter;
+    
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value ENetWrapper::GetNetworkConditions(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    NetworkConditioner* conditioner = GetNetworkConditioner(host);
+    if (conditioner == nullptr) {
+        return env.Null();
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("loss", Napi::Number::New(env, conditioner->loss));
+    result.Set("latency", Napi::Number::New(env, conditioner->latency));
+    result.Set("jitter", Napi::Number::New(env, conditioner->jitter));
+    result.Set("dropped", Napi::Number::New(env, static_cast<double>(conditioner->dropped)));
+    result.Set("delayed", Napi::Number::New(env, static_cast<double>(conditioner->delayed)));
+    result.Set("pending", Napi::Number::New(env, static_cast<double>(conditioner->pending.size())));
+    return result;
+}
+
+static Napi::Object CaptureStatsToObject(Napi::Env env, const TrafficCaptureStats& stats) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("records", Napi::Number::New(env, static_cast<double>(stats.records)));
+    result.Set("bytes", Napi::Number::New(env, static_cast<double>(stats.bytes)));
+    result.Set("dropped", Napi::Number::New(env, static_cast<double>(stats.dropped)));
+    return result;
+}
+
+static Napi::Object ReplayStatsToObject(Napi::Env env, const TrafficReplayStats& stats) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("delivered", Napi::Number::New(env, static_cast<double>(stats.delivered)));
+    result.Set("total", Napi::Number::New(env, static_cast<double>(stats.total)));
+    result.Set("done", Napi::Boolean::New(env, stats.delivered >= stats.total));
+    result.Set("partial", Napi::Boolean::New(env, stats.partial));
+    return result;
+}
+
+Napi::Value ENetWrapper::StartCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected capture file path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    bool captureSend = false;
+    size_t bufferSize = 4 * 1024 * 1024;
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        captureSend = options.Has("send") && options.Get("send").ToBoolean().Value();
+        if (options.Has("bufferSize") && options.Get("bufferSize").IsNumber()) {
+            bufferSize = static_cast<size_t>(options.Get("bufferSize").As<Napi::Number>().DoubleValue());
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    if (host->intercept != nullptr) {
+        Napi::TypeError::New(env, "Host already has an intercept callback").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    TrafficCapture* capture = new TrafficCapture();
+    if (!capture->Open(path, bufferSize, HostHasPeers(host))) {
+        delete capture;
+        Napi::TypeError::New(env, "Failed to create capture file").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    host->data = capture;
+    host->intercept = TrafficCapture::Intercept;
+    if (captureSend) {
+        host->interceptSend = TrafficCapture::InterceptSend;
+    }
+    
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value ENetWrapper::StopCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        return env.Null();
+    }
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    if (GetTrafficCapture(host) == nullptr) {
+        return env.Null();
+    }
+    
+    TrafficCaptureStats stats;
+    RemoveTrafficCapture(host, &stats);
+    return CaptureStatsToObject(env, stats);
+}
+
+Napi::Value ENetWrapper::GetCaptureStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        return env.Null();
+    }
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    TrafficCapture* capture = GetTrafficCapture(host);
+    if (capture == nullptr) {
+        return env.Null();
+    }
+    return CaptureStatsToObject(env, capture->Stats());
+}
+
+Napi::Value ENetWrapper::StartReplay(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected capture file path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    double speed = 1.0;
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (options.Has("speed") && options.Get("speed").IsNumber()) {
+            speed = options.Get("speed").As<Napi::Number>().DoubleValue();
+        }
+    }
+    
+    if (!(speed >= 0.0)) {
+        Napi::RangeError::New(env, "speed must not be negative").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    TrafficReplayStats stats;
+    {
+        std::lock_guard<std::mutex> lock(hostMutex);
+        
+        if (host->intercept != nullptr) {
+            Napi::TypeError::New(env, "Host already has an intercept callback").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        
+        // @note the host switches clocks, which is only safe while nothing is scheduled on the old one
+        if (HostHasPeers(host)) {
+            Napi::TypeError::New(env, "Replay needs a host without peers").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        
+        TrafficReplay* replay = new TrafficReplay();
+        if (!replay->Open(path, speed)) {
+            delete replay;
+            Napi::TypeError::New(env, "Failed to open capture file").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        // @note replies never leave the host and live datagrams are ignored until stopReplay
+        host->data = replay;
+        host->intercept = TrafficReplay::Intercept;
+        host->interceptSend = TrafficReplay::InterceptSend;
+        enet_host_set_clock(host, TrafficReplay::Clock);
+        stats = replay->Stats();
+    }
+    
+    if (threadRunning) {
+        WakeThread();
+    } else {
+        ScheduleFlush();
+    }
+    
+    return Napi::Number::New(env, static_cast<double>(stats.total));
+}
+
+Napi::Value ENetWrapper::StopReplay(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        return env.Null();
+    }
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    if (GetTrafficReplay(host) == nullptr) {
+        return env.Null();
+    }
+    
+    TrafficReplayStats stats;
+    RemoveTrafficReplay(host, &stats);
+    return ReplayStatsToObject(env, stats);
+}
+
+Napi::Value ENetWrapper::GetReplayStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        return env.Null();
+    }
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    TrafficReplay* replay = GetTrafficReplay(host);
+    if (replay == nullptr) {
+        return env.Null();
+    }
+    return ReplayStatsToObject(env, replay->Stats());
+}
+
+int ENetWrapper::ServiceRing(uint32_t maxEvents, enet_uint32 timeout, uint32_t& written) {
+    EventRing& ring = *eventRing;
+    written = 0;
+    
+    ReleaseHeldDatagrams(host);
+    
+    if (ring.hasPending) {
+        if (!ring.Push(ring.pending)) {
+            // @note js has not caught up: keep the protocol moving and leave new events queued in enet
+            return enet_host_service(host, nullptr, 0) < 0 ? -1 : 0;
+        }
+        ring.hasPending = false;
+        written++;
+    }
+    
+    ENetEvent event;
+    int result = enet_host_service(host, &event, timeout);
+    while (result > 0) {
+        ThreadEvent item = { event, EventPeerHandle(event) };
+        if (!ring.Push(item)) {
+            ring.pending = item;
+            ring.hasPending = true;
+            break;
+        }
+        if (++written >= maxEvents) {
+            break;
+        }
+        result = enet_host_check_events(host, &event);
+    }
+    
+    return result < 0 ? result : 0;
+}
+
+Napi::Value ENetWrapper::HostServiceRing(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (threadRunning) {
+        Napi::TypeError::New(env, "Host is owned by the network thread").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (!eventRing) {
+        Napi::TypeError::New(env, "Event ring not attached").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    uint32_t maxEvents = 256;
+    if (info.Length() > 0 && info[0].IsNumber()) {
+        maxEvents = info[0].As<Napi::Number>().Uint32Value();
+    }
+    if (maxEvents == 0) {
+        maxEvents = 1;
+    }
+    
+    enet_uint32 timeout = 0;
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        timeout = info[1].As<Napi::Number>().Uint32Value();
+    }
+    
+    uint32_t written = 0;
+    if (ServiceRing(maxEvents, timeout, written) < 0) {
+        Napi::TypeError::New(env, "Error occurred during host service").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    return Napi::Number::New(env, written);
+}
+
+Napi::Value ENetWrapper::AttachEventRing(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || info[0].IsNull() || info[0].IsUndefined()) {
+        std::lock_guard<std::mutex> lock(hostMutex);
+        // @note an event held back for a full ring is already out of enet, so it goes back as an object
+        Napi::Value pending = env.Undefined();
+        if (eventRing && eventRing->hasPending) {
+            pending = EventToObject(env, eventRing->pending.event, eventRing->pending.peer);
+            eventRing->hasPending = false;
+        }
+        eventRing.reset();
+        return pending;
+    }
+    
+    if (!info[0].IsTypedArray() || info[0].As<Napi::TypedArray>().TypedArrayType() != napi_uint32_array) {
+        Napi::TypeError::New(env, "Expected Uint32Array for event records").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (info.Length() < 2 || !info[1].IsTypedArray() || info[1].As<Napi::TypedArray>().TypedArrayType() != napi_uint8_array) {
+        Napi::TypeError::New(env, "Expected Uint8Array for event arena").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Uint32Array records = info[0].As<Napi::Uint32Array>();
+    Napi::Uint8Array arena = info[1].As<Napi::Uint8Array>();
+    
+    size_t slots = records.ElementLength() > kEventRingHeaderWords
+        ? (records.ElementLength() - kEventRingHeaderWords) / kEventRecordWords : 0;
+    size_t arenaSize = arena.ElementLength();
+    // @note both sizes are indexed with a mask, so they have to be powers of two
+    if (slots == 0 || (slots & (slots - 1)) != 0 || slots > (1u << 24)) {
+        Napi::TypeError::New(env, "Event ring capacity must be a power of two").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (arenaSize == 0 || (arenaSize & (arenaSize - 1)) != 0 || arenaSize > (1u << 31)) {
+        Napi::TypeError::New(env, "Event arena size must be a power of two").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::unique_ptr<EventRing> ring(new EventRing());
+    ring->headerRef = Napi::Persistent(records);
+    ring->arenaRef = Napi::Persistent(arena);
+    ring->header = records.Data();
+    ring->records = ring->header + kEventRingHeaderWords;
+    ring->capacity = static_cast<uint32_t>(slots);
+    ring->arena = arena.Data();
+    ring->arenaSize = static_cast<uint32_t>(arenaSize);
+    ring->arenaEnds.assign(slots, 0);
+    
+    std::lock_guard<std::mutex> lock(hostMutex);
+    
+    ring->header[kEventRingWrite] = 0;
+    ring->header[kEventRingRead] = 0;
+    ring->header[kEventRingCapacity] = ring->capacity;
+    ring->header[kEventRingDropped] = 0;
+    // @note a held back event moves to the new ring and is written before anything else
+    if (eventRing && eventRing->hasPending) {
+        ring->pending = eventRing->pending;
+        ring->hasPending = true;
+        eventRing->hasPending = false;
+    }
+    eventRing = std::move(ring);
+    
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value ENetWrapper::StartPoll(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (threadRunning) {
+        Napi::TypeError::New(env, "Host is owned by the network thread").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Expected callback function").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    pollMaxEvents = 256;
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        pollMaxEvents = info[1].As<Napi::Number>().Uint32Value();
+    }
+    if (pollMaxEvents == 0) {
+        pollMaxEvents = 1;
+    }
+    
+    // @note polling and ticking both drive the host from the js loop, so only one runs at a time
+    ClosePoll();
+    CloseTick();
+    
+    uv_loop_t* loop = nullptr;
+    if (napi_get_uv_event_loop(env, &loop) != napi_ok || loop == nullptr) {
+        Napi::TypeError::New(env, "Failed to get event loop").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    pollHandle = new uv_poll_t;
+    if (uv_poll_init_socket(loop, pollHandle, static_cast<uv_os_sock_t>(host->socket)) != 0) {
+        delete pollHandle;
+        pollHandle = nullptr;
+        Napi::TypeError::New(env, "Failed to watch host socket").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    pollHandle->data = this;
+    
+    pollTimer = new uv_timer_t;
+    uv_timer_init(loop, pollTimer);
+    pollTimer->data = this;
+    
+    pollEnv = env;
+    pollCallback = Napi::Persistent(info[0].As<Napi::Function>());
+    
+    uv_poll_start(pollHandle, UV_READABLE, &ENetWrapper::OnPollReadable);
+    // @note service once right away to pick up anything queued before polling started
+    ArmPollTimer(true);
+    
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value ENetWrapper::StopPoll(const Napi::CallbackInfo& info) {
+    ClosePoll();
+    return info.Env().Undefined();
+}
+
+void ENetWrapper::ClosePoll() {
+    // @note handles are freed from their close callbacks once libuv is done with them
+    if (pollHandle) {
+        uv_poll_stop(pollHandle);
+        pollHandle->data = nullptr;
+        uv_close(reinterpret_cast<uv_handle_t*>(pollHandle), [](uv_handle_t* handle) {
+            delete reinterpret_cast<uv_poll_t*>(handle);
+        });
+        pollHandle = nullptr;
+    }
+    if (pollTimer) {
+        uv_timer_stop(pollTimer);
+        pollTimer->data = nullptr;
+        uv_close(reinterpret_cast<uv_handle_t*>(pollTimer), [](uv_handle_t* handle) {
+            delete reinterpret_cast<uv_timer_t*>(handle);
+        });
+        pollTimer = nullptr;
+    }
+    pollCallback.Reset();
+    flushScheduled = false;
+}
+
+void ENetWrapper::OnPollReadable(uv_poll_t* handle, int status, int events) {
+    ENetWrapper* self = static_cast<ENetWrapper*>(handle->data);
+    if (self) {
+        self->ServicePoll();
+    }
+}
+
+void ENetWrapper::OnPollTimer(uv_timer_t* handle) {
+    ENetWrapper* self = static_cast<ENetWrapper*>(handle->data);
+    if (self) {
+        self->ServicePoll();
+    }
+}
+
+void ENetWrapper::ArmPollTimer(bool morePending) {
+    if (!pollTimer || !host) {
+        return;
+    }
+    
+    enet_uint32 timeout = 0;
+    bool deadline = enet_host_next_timeout(host, &timeout);
+    if (host->intercept != nullptr) {
+        if (!deadline) {
+            timeout = UINT32_MAX;
+        }
+        deadline = HeldDatagramTimeout(host, timeout) || deadline;
+    }
+    if (morePending || deadline) {
+        uv_timer_start(pollTimer, &ENetWrapper::OnPollTimer, morePending ? 0 : timeout, 0);
+    } else {
+        // @note nothing in flight and no peers to ping: sleep until the socket is readable
+        uv_timer_stop(pollTimer);
+    }
+}
+
+void ENetWrapper::ScheduleFlush() {
+    // @note sends made outside a poll callback go out on the next loop turn
+    if (pollTimer && !flushScheduled) {
+        flushScheduled = true;
+        uv_timer_start(pollTimer, &ENetWrapper::OnPollTimer, 0, 0);
+    }
+}
+
+void ENetWrapper::ServicePoll() {
+    if (!host || !pollHandle) {
+        return;
+    }
+    
+    Napi::Env env(pollEnv);
+    Napi::HandleScope scope(env);
+    
+    // @note in ring mode the callback only gets the record count; js reads the ring itself
+    Napi::Value delivered;
+    bool morePending = false;
+    int result;
+    if (eventRing) {
+        uint32_t written = 0;
+        result = ServiceRing(pollMaxEvents, 0, written);
+        morePending = written >= pollMaxEvents;
+        if (written > 0) {
+            delivered = Napi::Number::New(env, written);
+        }
+    } else {
+        Napi::Array events = Napi::Array::New(env);
+        result = ServiceEvents(env, events, pollMaxEvents, 0);
+        morePending = events.Length() >= pollMaxEvents;
+        if (events.Length() > 0) {
+            delivered = events;
+        }
+    }
+    
+    if (result < 0) {
+        Napi::Error error = Napi::Error::New(env, "Error occurred during host service");
+        pollCallback.MakeCallback(Value(), { env.Null(), error.Value() });
+    } else if (!delivered.IsEmpty()) {
+        pollCallback.MakeCallback(Value(), { delivered });
+    }
+    
+    if (env.IsExceptionPending()) {
+        Napi::Error error = env.GetAndClearPendingException();
+        napi_fatal_exception(env, error.Value());
+    }
+    
+    // @note the callback may have stopped polling or destroyed the host
+    if (!host || !pollHandle) {
+        return;
+    }
+    
+    // @note push out anything the callback queued, then sleep until the next deadline
+    enet_host_flush(host);
+    flushScheduled = false;
+    ArmPollTimer(morePending || (eventRing && eventRing->hasPending));
+}
+
+Napi::Value ENetWrapper::ReceiveAll(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (threadRunning) {
+        Napi::TypeError::New(env, "Host is owned by the network thread").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    // @note 0 means drain until the socket and the dispatch queue are empty
+    uint32_t maxEvents = 0;
+    if (info.Length() > 0 && info[0].IsNumber()) {
+        maxEvents = info[0].As<Napi::Number>().Uint32Value();
+    }
+    if (maxEvents == 0) {
+        maxEvents = UINT32_MAX;
+    }
+    
+    ReleaseHeldDatagrams(host);
+    
+    ENetEvent event;
+    int result = 0;
+    uint32_t count = 0;
+    
+    if (eventRing) {
+        EventRing& ring = *eventRing;
+        if (ring.hasPending) {
+            // @note js is behind: leave the rest in the socket until the ring has room
+            if (!ring.Push(ring.pending)) {
+                return Napi::Number::New(env, 0);
+            }
+            ring.hasPending = false;
+            count++;
+        }
+        while (count < maxEvents && (result = enet_host_receive(host, &event)) > 0) {
+            ThreadEvent item = { event, EventPeerHandle(event) };
+            if (!ring.Push(item)) {
+                ring.pending = item;
+                ring.hasPending = true;
+                break;
+            }
+            count++;
+        }
+        if (result < 0) {
+            Napi::TypeError::New(env, "Error occurred during host receive").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        return Napi::Number::New(env, count);
+    }
+    
+    Napi::Array events = Napi::Array::New(env);
+    while (count < maxEvents && (result = enet_host_receive(host, &event)) > 0) {
+        events.Set(count++, ConvertEvent(env, host, event));
+    }
+    if (result < 0) {
+        Napi::TypeError::New(env, "Error occurred during host receive").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    return events;
+}
+
+Napi::Value ENetWrapper::FlushAll(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (threadRunning) {
+        Napi::TypeError::New(env, "Host is owned by the network thread").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (enet_host_transmit(host) < 0) {
+        Napi::TypeError::New(env, "Error occurred during host transmit").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    flushScheduled = false;
+    
+    return env.Undefined();
+}
+
+Napi::Value ENetWrapper::StartTick(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (threadRunning) {
+        Napi::TypeError::New(env, "Host is owned by the network thread").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Expected tick period in milliseconds and callback function").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    double periodMs = info[0].As<Napi::Number>().DoubleValue();
+    if (!(periodMs >= 1.0 && periodMs <= 3600000.0)) {
+        Napi::TypeError::New(env, "Tick period must be between 1 ms and 1 hour").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    ClosePoll();
+    CloseTick();
+    
+    uv_loop_t* loop = nullptr;
+    if (napi_get_uv_event_loop(env, &loop) != napi_ok || loop == nullptr) {
+        Napi::TypeError::New(env, "Failed to get event loop").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    tickTimer = new uv_timer_t;
+    uv_timer_init(loop, tickTimer);
+    tickTimer->data = this;
+    
+    tickEnv = env;
+    tickCallback = Napi::Persistent(info[1].As<Napi::Function>());
+    tickPeriodNs = static_cast<uint64_t>(periodMs * 1e6);
+    tickOrigin = enet_time_get_ns();
+    tickCount = 0;
+    
+    uv_timer_start(tickTimer, &ENetWrapper::OnTickTimer, 0, 0);
+    
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value ENetWrapper::Now(const Napi::CallbackInfo& info) {
+    // @note ENet's monotonic clock in fractional milliseconds; SERVICE_TIME is the same clock wrapped at 2^32 ms
+    return Napi::Number::New(info.Env(), static_cast<double>(enet_time_get_ns()) / 1e6);
+}
+
+Napi::Value ENetWrapper::StopTick(const Napi::CallbackInfo& info) {
+    CloseTick();
+    return info.Env().Undefined();
+}
+
+void ENetWrapper::CloseTick() {
+    if (tickTimer) {
+        uv_timer_stop(tickTimer);
+        tickTimer->data = nullptr;
+        uv_close(reinterpret_cast<uv_handle_t*>(tickTimer), [](uv_handle_t* handle) {
+            delete reinterpret_cast<uv_timer_t*>(handle);
+        });
+        tickTimer = nullptr;
+    }
+    tickCallback.Reset();
+}
+
+void ENetWrapper::OnTickTimer(uv_timer_t* handle) {
+    ENetWrapper* self = static_cast<ENetWrapper*>(handle->data);
+    if (self) {
+        self->RunTick();
+    }
+}
+
+void ENetWrapper::ArmTickTimer() {
+    // @note deadlines come from the fixed origin, so timer lateness never accumulates into drift
+    uv_loop_t* loop = uv_handle_get_loop(reinterpret_cast<uv_handle_t*>(tickTimer));
+    uv_update_time(loop);
+    uint64_t deadline = tickOrigin + tickCount * tickPeriodNs;
+    uint64_t now = enet_time_get_ns();
+    uint64_t delay = deadline > now ? (deadline - now + 999999) / 1000000 : 0;
+    uv_timer_start(tickTimer, &ENetWrapper::OnTickTimer, delay, 0);
+}
+
+void ENetWrapper::RunTick() {
+    if (!tickTimer) {
+        return;
+    }
+    
+    uint64_t now = enet_time_get_ns();
+    uint64_t due = (now - tickOrigin) / tickPeriodNs;
+    if (due < tickCount) {
+        // @note libuv timers have millisecond granularity and may fire a little early
+        ArmTickTimer();
+        return;
+    }
+    
+    // @note ticks that were overrun by a slow step are skipped, not replayed in a burst
+    uint64_t missed = due - tickCount;
+    tickCount = due + 1;
+    
+    Napi::Env env(tickEnv);
+    Napi::HandleScope scope(env);
+    
+    tickCallback.MakeCallback(Value(), {
+        Napi::Number::New(env, static_cast<double>(due)),
+        Napi::Number::New(env, static_cast<double>(missed))
+    });
+    
+    if (env.IsExceptionPending()) {
+        Napi::Error error = env.GetAndClearPendingException();
+        napi_fatal_exception(env, error.Value());
+    }
+    
+    // @note the callback may have stopped ticking
+    if (tickTimer) {
+        ArmTickTimer();
+    }
+}
+
+Napi::Value ENetWrapper::StartThread(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!host) {
+        Napi::TypeError::New(env, "Host not created").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Expected callback function").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    threadMaxEvents = 256;
+    threadWaitMs = 100;
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (options.Has("maxEvents") && options.Get("maxEvents").IsNumber()) {
+            threadMaxEvents = options.Get("maxEvents").As<Napi::Number>().Uint32Value();
+        }
+        if (options.Has("waitMs") && options.Get("waitMs").IsNumber()) {
+            threadWaitMs = options.Get("waitMs").As<Napi::Number>().Uint32Value();
+        }
+    }
+    if (threadMaxEvents == 0) {
+        threadMaxEvents = 1;
+    }
+    
+    JoinThread();
+    ClosePoll();
+    CloseTick();
+    
+    // @note loopback socket the js thread pokes to cut the network thread's wait short
+    memset(&wakeAddress, 0, sizeof(ENetAddress));
+    enet_address_build_loopback(&wakeAddress, ENET_ADDRESS_TYPE_IPV4);
+    wakeSocket = enet_socket_create(ENET_ADDRESS_TYPE_IPV4, ENET_SOCKET_TYPE_DATAGRAM);
+    if (wakeSocket == ENET_SOCKET_NULL ||
+        enet_socket_bind(wakeSocket, &wakeAddress) < 0 ||
+        enet_socket_get_address(wakeSocket, &wakeAddress) < 0 ||
+        enet_socket_set_option(wakeSocket, ENET_SOCKOPT_NONBLOCK, 1) < 0) {
+        if (wakeSocket != ENET_SOCKET_NULL) {
+            enet_socket_destroy(wakeSocket);
+            wakeSocket = ENET_SOCKET_NULL;
+        }
+        Napi::TypeError::New(env, "Failed to create wake socket").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    threadCallback = Napi::ThreadSafeFunction::New(env, info[0].As<Napi::Function>(), "ENetNetworkThread", 0, 1);
+    wakePending.store(false, std::memory_order_relaxed);
+    threadRunning.store(true, std::memory_order_release);
+    networkThread = std::thread(&ENetWrapper::NetworkThreadMain, this);
+    
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value ENetWrapper::StopThread(const Napi::CallbackInfo& info) {
+    JoinThread();
+    return info.Env().Undefined();
+}
+
+void ENetWrapper::JoinThread() {
+    if (!networkThread.joinable()) {
+        return;
+    }
+    
+    threadRunning.store(false, std::memory_order_release);
+    WakeThread();
+    networkThread.join();
+    
+    // @note the js thread owns the host again; deliver whatever was still queued
+    if (host) {
+        ApplyThreadCommands();
+        enet_host_flush(host);
+    }
+    
+    threadCallback.Release();
+    enet_socket_destroy(wakeSocket);
+    wakeSocket = ENET_SOCKET_NULL;
+    DrainPins();
+}
+
+bool ENetWrapper::QueueThreadCommand(NetCommand::Type type, uint32_t peer, enet_uint8 channelID, ENetPacket* packet, enet_uint32 data) {
+    NetCommand* command = new NetCommand();
+    command->type = type;
+    command->peer = peer;
+    command->channelID = channelID;
+    command->packet = packet;
+    command->data = data;
+    commandQueue.Push(command);
+    WakeThread();
+    return true;
+}
+
+void ENetWrapper::WakeThread() {
+    if (wakeSocket == ENET_SOCKET_NULL || wakePending.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    
+    enet_uint8 signal = 0;
+    ENetBuffer buffer;
+    buffer.data = &signal;
+    buffer.dataLength = sizeof(signal);
+    enet_socket_send(wakeSocket, &wakeAddress, &buffer, 1);
+}
+
+void ENetWrapper::ApplyThreadCommands() {
+    NetCommand* command;
+    while ((command = commandQueue.Pop()) != nullptr) {
+        // @note handles come straight from js and may have gone stale while queued
+        ENetPeer* peer = PeerFromHandle(host, command->peer);
+        switch (command->type) {
+            case NetCommand::Send:
+                if (!peer || enet_peer_send(peer, command->channelID, command->packet) < 0) {
+                    enet_packet_destroy(command->packet);
+                }
+                break;
+            case NetCommand::SendMany:
+                SendToPeers(host, command->peers, command->channelID, command->packet);
+                break;
+            case NetCommand::SendBatch:
+                for (QueuedSend& send : command->sends) {
+                    ENetPeer* target = PeerFromHandle(host, send.peer);
+                    if (!target || enet_peer_send(target, send.channelID, send.packet) < 0) {
+                        enet_packet_destroy(send.packet);
+                    }
+                }
+                break;
+            case NetCommand::Broadcast:
+                enet_host_broadcast(host, command->channelID, command->packet);
+                break;
+            case NetCommand::Disconnect:
+                if (peer) {
+                    enet_peer_disconnect(peer, command->data);
+                }
+                break;
+            case NetCommand::DisconnectNow:
+                if (peer) {
+                    enet_peer_disconnect_now(peer, command->data);
+                }
+                break;
+            case NetCommand::DisconnectLater:
+                if (peer) {
+                    enet_peer_disconnect_later(peer, command->data);
+                }
+                break;
+        }
+        delete command;
+    }
+}
+
+void ENetWrapper::WaitForNetwork(enet_uint32 timeout) {
+    bool woken = false;
+#ifdef _WIN32
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(host->socket, &readSet);
+    FD_SET(wakeSocket, &readSet);
+    struct timeval timeVal;
+    timeVal.tv_sec = timeout / 1000;
+    timeVal.tv_usec = (timeout % 1000) * 1000;
+    if (select(0, &readSet, NULL, NULL, &timeVal) > 0) {
+        woken = FD_ISSET(wakeSocket, &readSet) != 0;
+    }
+#else
+    struct pollfd fds[2];
+    fds[0].fd = host->socket;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = wakeSocket;
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+    if (poll(fds, 2, static_cast<int>(timeout)) > 0) {
+        woken = (fds[1].revents & POLLIN) != 0;
+    }
+#endif
+    if (woken) {
+        enet_uint8 signal[16];
+        ENetBuffer buffer;
+        buffer.data = signal;
+        buffer.dataLength = sizeof(signal);
+        ENetAddress from;
+        while (enet_socket_receive(wakeSocket, &from, &buffer, 1) > 0) {
+        }
+    }
+}
+
+void ENetWrapper::NetworkThreadMain() {
+    while (threadRunning.load(std::memory_order_acquire)) {
+        std::vector<ThreadEvent>* batch = nullptr;
+        bool failed = false;
+        bool morePending = false;
+        bool ringWritten = false;
+        enet_uint32 timeout = threadWaitMs;
+        
+        {
+            std::lock_guard<std::mutex> lock(hostMutex);
+            
+            // @note clear the flag before draining so a racing push always re-signals
+            wakePending.store(false, std::memory_order_release);
+            ApplyThreadCommands();
+            ReleaseHeldDatagrams(host);
+            
+            if (eventRing) {
+                uint32_t written = 0;
+                failed = ServiceRing(threadMaxEvents, 0, written) < 0;
+                morePending = written >= threadMaxEvents;
+                ringWritten = written > 0;
+                // @note js is behind: poll again soon rather than sleeping a full wait
+                if (eventRing->hasPending && timeout > 1) {
+                    timeout = 1;
+                }
+            } else {
+                ENetEvent event;
+                int result = enet_host_service(host, &event, 0);
+                while (result > 0) {
+                    if (batch == nullptr) {
+                        batch = new std::vector<ThreadEvent>();
+                    }
+                    batch->push_back({ event, EventPeerHandle(event) });
+                    if (batch->size() >= threadMaxEvents) {
+                        morePending = true;
+                        break;
+                    }
+                    result = enet_host_check_events(host, &event);
+                }
+                failed = result < 0;
+            }
+            
+            enet_uint32 nextTimeout = 0;
+            if (morePending) {
+                timeout = 0;
+            } else if (enet_host_next_timeout(host, &nextTimeout) && nextTimeout < timeout) {
+                timeout = nextTimeout;
+            }
+            HeldDatagramTimeout(host, timeout);
+        }
+        
+        if (batch != nullptr) {
+            napi_status status = threadCallback.NonBlockingCall(batch, [](Napi::Env env, Napi::Function callback, std::vector<ThreadEvent>* events) {
+                Napi::Array array = Napi::Array::New(env, events->size());
+                for (size_t i = 0; i < events->size(); i++) {
+                    array.Set(static_cast<uint32_t>(i), EventToObject(env, (*events)[i].event, (*events)[i].peer));
+                }
+                delete events;
+                callback.Call({ array });
+            });
+            if (status != napi_ok) {
+                for (ThreadEvent& pending : *batch) {
+                    if (pending.event.packet) {
+                        enet_packet_destroy(pending.event.packet);
+                    }
+                }
+                delete batch;
+            }
+        }
+        
+        if (ringWritten && !ringSignalPending->exchange(true, std::memory_order_acq_rel)) {
+            std::shared_ptr<std::atomic<bool>> signal = ringSignalPending;
+            napi_status status = threadCallback.NonBlockingCall([signal](Napi::Env env, Napi::Function callback) {
+                signal->store(false, std::memory_order_release);
+                callback.Call({ Napi::Number::New(env, 0) });
+            });
+            if (status != napi_ok) {
+                ringSignalPending->store(false, std::memory_order_release);
+            }
+        }
+        
+        std::vector<PinnedPacket*>* pins = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(pinMutex);
+            if (!pendingPins.empty()) {
+                pins = new std::vector<PinnedPacket*>();
+                pins->swap(pendingPins);
+            }
+        }
+        if (pins != nullptr) {
+            napi_status status = threadCallback.NonBlockingCall(pins, [](Napi::Env, Napi::Function, std::vector<PinnedPacket*>* released) {
+                for (PinnedPacket* pin : *released) {
+                    delete pin;
+                }
+                delete released;
+            });
+            if (status != napi_ok) {
+                // @note the js thread drains these after joining
+                std::lock_guard<std::mutex> lock(pinMutex);
+                pendingPins.insert(pendingPins.end(), pins->begin(), pins->end());
+                delete pins;
+            }
+        }
+        
+        if (failed) {
+            threadCallback.NonBlockingCall([](Napi::Env env, Napi::Function callback) {
+                Napi::Error error = Napi::Error::New(env, "Error occurred during host service");
+                callback.Call({ env.Null(), error.Value() });
+            });
+        }
+        
+        if (timeout > 0) {
+            WaitForNetwork(timeout);
+        }
+    }
+}
+
 Napi::Object InitAll(Napi::Env env, Napi::Object exports) {
     return ENetWrapper::Init(env, exports);
 }
@@ -0,0 +1,173 @@
+#include "slab_allocator.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+
+// @note size classes run 64 B .. 64 KiB in powers of two; anything larger goes straight to malloc
+static const size_t kMinClassShift = 6;
+static const size_t kClassCount = 11;
+static const size_t kSlabBytes = 64 * 1024;
+static const uint32_t kLargeClass = 0xFFFFFFFFu;
+
+// @note prefix of every block; 16 bytes keeps the payload aligned like malloc's
+struct alignas(16) BlockHeader {
+    uint32_t sizeClass;
+    uint32_t reserved;
+    union {
+        BlockHeader* next;  // while on a free list
+        size_t size;        // large blocks: requested size, for accounting
+    };
+};
+
+struct SizeClass {
+    std::mutex mutex;
+    BlockHeader* freeList = nullptr;
+};
+
+static SizeClass g_classes[kClassCount];
+static std::atomic<uint64_t> g_inUse{0};
+static std::atomic<uint64_t> g_highWater{0};
+static std::atomic<uint64_t> g_reserved{0};
+static std::atomic<uint64_t> g_limit{0};
+static std::atomic<uint64_t> g_failures{0};
+
+static size_t ClassPayload(size_t sizeClass) {
+    return static_cast<size_t>(1) << (sizeClass + kMinClassShift);
+}
+
+static size_t ClassForSize(size_t size) {
+    size_t sizeClass = 0;
+    while (sizeClass < kClassCount && ClassPayload(sizeClass) < size) {
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+// @note reserves bytes against the cap and tracks the high-water mark
+static bool Reserve(uint64_t bytes) {
+    uint64_t limit = g_limit.load(std::memory_order_relaxed);
+    uint64_t inUse = g_inUse.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    if (limit != 0 && inUse > limit) {
+        g_inUse.fetch_sub(bytes, std::memory_order_relaxed);
+        g_failures.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    uint64_t highWater = g_highWater.load(std::memory_order_relaxed);
+    while (inUse > highWater && !g_highWater.compare_exchange_weak(highWater, inUse, std::memory_order_relaxed)) {
+    }
+    return true;
+}
+
+// @note carves a fresh slab into blocks of one class; caller holds the class mutex
+static bool RefillClass(SizeClass& slabClass, size_t sizeClass) {
+    size_t blockBytes = sizeof(BlockHeader) + ClassPayload(sizeClass);
+    size_t blockCount = kSlabBytes / blockBytes;
+    if (blockCount < 4) {
+        blockCount = 4;
+    }
+    
+    uint8_t* slab = static_cast<uint8_t*>(malloc(blockBytes * blockCount));
+    if (!slab) {
+        return false;
+    }
+    g_reserved.fetch_add(blockBytes * blockCount, std::memory_order_relaxed);
+    
+    // @note slabs are never returned; blocks recycle within their class so rss settles at the high-water mark
+    for (size_t i = 0; i < blockCount; i++) {
+        BlockHeader* block = reinterpret_cast<BlockHeader*>(slab + i * blockBytes);
+        block->sizeClass = static_cast<uint32_t>(sizeClass);
+        block->next = slabClass.freeList;
+        slabClass.freeList = block;
+    }
+    return true;
+}
+
+void* ENET_CALLBACK SlabAllocator::Allocate(size_t size) {
+    size_t sizeClass = ClassForSize(size);
+    
+    if (sizeClass >= kClassCount) {
+        if (!Reserve(size)) {
+            return nullptr;
+        }
+        BlockHeader* block = static_cast<BlockHeader*>(malloc(sizeof(BlockHeader) + size));
+        if (!block) {
+            g_inUse.fetch_sub(size, std::memory_order_relaxed);
+            return nullptr;
+        }
+        g_reserved.fetch_add(sizeof(BlockHeader) + size, std::memory_order_relaxed);
+        block->sizeClass = kLargeClass;
+        block->size = size;
+        return block + 1;
+    }
+    
+    if (!Reserve(ClassPayload(sizeClass))) {
+        return nullptr;
+    }
+    
+    SizeClass& slabClass = g_classes[sizeClass];
+    BlockHeader* block = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(slabClass.mutex);
+        if (slabClass.freeList || RefillClass(slabClass, sizeClass)) {
+            block = slabClass.freeList;
+            slabClass.freeList = block->next;
+        }
+    }
+    
+    if (!block) {
+        g_inUse.fetch_sub(ClassPayload(sizeClass), std::memory_order_relaxed);
+        return nullptr;
+    }
+    return block + 1;
+}
+
+void ENET_CALLBACK SlabAllocator::Free(void* memory) {
+    if (!memory) {
+        return;
+    }
+    
+    BlockHeader* block = static_cast<BlockHeader*>(memory) - 1;
+    
+    if (block->sizeClass == kLargeClass) {
+        g_inUse.fetch_sub(block->size, std::memory_order_relaxed);
+        g_reserved.fetch_sub(sizeof(BlockHeader) + block->size, std::memory_order_relaxed);
+        free(block);
+        return;
+    }
+    
+    size_t sizeClass = block->sizeClass;
+    g_inUse.fetch_sub(ClassPayload(sizeClass), std::memory_order_relaxed);
+    
+    SizeClass& slabClass = g_classes[sizeClass];
+    std::lock_guard<std::mutex> lock(slabClass.mutex);
+    block->next = slabClass.freeList;
+    slabClass.freeList = block;
+}
+
+void ENET_CALLBACK SlabAllocator::NoMemory() {
+    // @note enet checks for NULL everywhere it allocates; let the cap surface as a failed call
+}
+
+ENetCallbacks SlabAllocator::Callbacks() {
+    ENetCallbacks callbacks;
+    callbacks.malloc = &SlabAllocator::Allocate;
+    callbacks.free = &SlabAllocator::Free;
+    callbacks.no_memory = &SlabAllocator::NoMemory;
+    return callbacks;
+}
+
+void SlabAllocator::SetLimit(size_t limit) {
+    g_limit.store(limit, std::memory_order_relaxed);
+}
+
+SlabAllocatorStats SlabAllocator::GetStats() {
+    SlabAllocatorStats stats;
+    stats.inUse = g_inUse.load(std::memory_order_relaxed);
+    stats.highWater = g_highWater.load(std::memory_order_relaxed);
+    stats.reserved = g_reserved.load(std::memory_order_relaxed);
+    stats.limit = g_limit.load(std::memory_order_relaxed);
+    stats.failures = g_failures.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,31 @@
+#ifndef SKY_ENET_SLAB_ALLOCATOR_H
+#define SKY_ENET_SLAB_ALLOCATOR_H
+
+#include <enet/enet.h>
+#include <cstddef>
+#include <cstdint>
+
+// @note process-wide size-class allocator handed to enet through enet_initialize_with_callbacks
+struct SlabAllocatorStats {
+    uint64_t inUse = 0;       // bytes handed out, rounded up to their size class
+    uint64_t highWater = 0;   // largest inUse seen
+    uint64_t reserved = 0;    // bytes held from the system allocator, slabs plus large blocks
+    uint64_t limit = 0;       // cap on inUse, 0 when unlimited
+    uint64_t failures = 0;    // allocations refused because of the cap
+};
+
+class SlabAllocator {
+public:
+    // @note callbacks for enet_initialize_with_callbacks; allocations fail with NULL instead of aborting
+    static ENetCallbacks Callbacks();
+    
+    static void SetLimit(size_t limit);
+    static SlabAllocatorStats GetStats();
+    
+private:
+    static void* ENET_CALLBACK Allocate(size_t size);
+    static void ENET_CALLBACK Free(void* memory);
+    static void ENET_CALLBACK NoMemory();
+};
+
+#endif
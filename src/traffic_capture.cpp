@@ -0,0 +1,459 @@
+#include "traffic_capture.h"
+
+#include <chrono>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char kCaptureMagic[8] = { 'S', 'K', 'Y', 'E', 'C', 'A', 'P', '\0' };
+static const uint32_t kCaptureVersion = 1;
+static const uint32_t kCaptureByteOrder = 0x01020304u;
+static const size_t kCaptureHeaderSize = 40;
+// @note header flag: peers were already connected, so their datagrams carry ids a fresh host lacks
+static const uint32_t kCaptureJoinedSession = 1u << 0;
+static const size_t kRecordFixedSize = 14;
+// @note the file grows by doubling from here; pages past the data are never touched, so it stays sparse
+static const size_t kCaptureInitialFileSize = 16 * 1024 * 1024;
+static const size_t kCaptureMinimumRingSize = 64 * 1024;
+// @note datagrams injected per release when replaying faster than the host drains them
+static const uint32_t kReplayBurst = 256;
+
+struct CaptureHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t startedAtMs;   // wall clock when the capture started, for reference only
+    uint64_t clockNs;       // enet_time_get_ns() when the capture started, which record times count from
+    uint32_t flags;
+    uint32_t hostTime;      // enet_time_from_ns(clockNs), the capturing host's clock in milliseconds
+};
+
+static_assert(sizeof(CaptureHeader) == kCaptureHeaderSize, "capture header layout");
+
+static size_t AddressBytes(uint8_t type) {
+    return type == ENET_ADDRESS_TYPE_IPV4 ? 4 : 16;
+}
+
+MappedFile::~MappedFile() {
+    Unmap();
+#ifdef _WIN32
+    if (file != nullptr) {
+        CloseHandle(file);
+        file = nullptr;
+    }
+#else
+    if (file >= 0) {
+        close(file);
+        file = -1;
+    }
+#endif
+}
+
+bool MappedFile::OpenRead(const std::string& path) {
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    file = handle;
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(handle, &length) || length.QuadPart <= 0) {
+        return false;
+    }
+    size = static_cast<size_t>(length.QuadPart);
+#else
+    file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size <= 0) {
+        return false;
+    }
+    size = static_cast<size_t>(status.st_size);
+#endif
+    return Map(false);
+}
+
+bool MappedFile::Create(const std::string& path) {
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    file = handle;
+#else
+    file = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file < 0) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool MappedFile::Resize(size_t newSize) {
+    Unmap();
+#ifndef _WIN32
+    // @note on windows the mapping itself extends the file
+    if (ftruncate(file, static_cast<off_t>(newSize)) != 0) {
+        return false;
+    }
+#endif
+    size = newSize;
+    return Map(true);
+}
+
+void MappedFile::Close(size_t length) {
+    Unmap();
+#ifdef _WIN32
+    if (file != nullptr) {
+        LARGE_INTEGER position;
+        position.QuadPart = static_cast<LONGLONG>(length);
+        if (SetFilePointerEx(file, position, nullptr, FILE_BEGIN)) {
+            SetEndOfFile(file);
+        }
+        CloseHandle(file);
+        file = nullptr;
+    }
+#else
+    if (file >= 0) {
+        if (ftruncate(file, static_cast<off_t>(length)) != 0) {
+            // @note the tail past length is unused space, the records before it are intact
+        }
+        close(file);
+        file = -1;
+    }
+#endif
+}
+
+bool MappedFile::Map(bool writable) {
+#ifdef _WIN32
+    mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                 static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                 static_cast<DWORD>(size & 0xFFFFFFFFu), nullptr);
+    if (mapping == nullptr) {
+        return false;
+    }
+    data = static_cast<uint8_t*>(MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size));
+    return data != nullptr;
+#else
+    void* view = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    data = static_cast<uint8_t*>(view);
+    return true;
+#endif
+}
+
+void MappedFile::Unmap() {
+#ifdef _WIN32
+    if (data != nullptr) {
+        UnmapViewOfFile(data);
+    }
+    if (mapping != nullptr) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+#else
+    if (data != nullptr) {
+        munmap(data, size);
+    }
+#endif
+    data = nullptr;
+}
+
+TrafficCapture::~TrafficCapture() {
+    Close();
+}
+
+bool TrafficCapture::Open(const std::string& path, size_t ringSize, bool peersConnected) {
+    if (!file.Create(path) || !file.Resize(kCaptureInitialFileSize)) {
+        return false;
+    }
+
+    CaptureHeader header;
+    memcpy(header.magic, kCaptureMagic, sizeof(header.magic));
+    header.version = kCaptureVersion;
+    header.byteOrder = kCaptureByteOrder;
+    header.startedAtMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    startNs = enet_time_get_ns();
+    header.clockNs = startNs;
+    header.flags = peersConnected ? kCaptureJoinedSession : 0;
+    header.hostTime = enet_time_from_ns(startNs);
+    memcpy(file.Data(), &header, sizeof(header));
+    fileLength = sizeof(header);
+    written.store(fileLength, std::memory_order_relaxed);
+
+    size_t capacity = kCaptureMinimumRingSize;
+    while (capacity < ringSize) {
+        capacity <<= 1;
+    }
+    ring.reset(new uint8_t[capacity]);
+    ringMask = capacity - 1;
+
+    running.store(true, std::memory_order_release);
+    writer = std::thread(&TrafficCapture::WriterMain, this);
+    return true;
+}
+
+void TrafficCapture::Close() {
+    if (!writer.joinable()) {
+        return;
+    }
+    running.store(false, std::memory_order_release);
+    writer.join();
+    file.Close(fileLength);
+}
+
+TrafficCaptureStats TrafficCapture::Stats() const {
+    TrafficCaptureStats stats;
+    stats.records = records.load(std::memory_order_relaxed);
+    stats.bytes = written.load(std::memory_order_relaxed);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+int ENET_CALLBACK TrafficCapture::Intercept(ENetHost* host, ENetEvent* event) {
+    TrafficCapture* self = static_cast<TrafficCapture*>(host->data);
+    ENetBuffer buffer;
+    buffer.data = host->receivedData;
+    buffer.dataLength = host->receivedDataLength;
+    self->Append(kTrafficReceive, host->receivedAddress, &buffer, 1);
+    return 0;
+}
+
+int ENET_CALLBACK TrafficCapture::InterceptSend(ENetHost* host, const ENetAddress* address,
+                                                const ENetBuffer* buffers, size_t bufferCount) {
+    TrafficCapture* self = static_cast<TrafficCapture*>(host->data);
+    self->Append(kTrafficSend, *address, buffers, bufferCount);
+    return 0;
+}
+
+void TrafficCapture::Append(uint8_t direction, const ENetAddress& address, const ENetBuffer* buffers, size_t bufferCount) {
+    size_t length = 0;
+    for (size_t i = 0; i < bufferCount; i++) {
+        length += buffers[i].dataLength;
+    }
+
+    uint8_t type = static_cast<uint8_t>(address.type);
+    size_t addressBytes = AddressBytes(type);
+    size_t need = kRecordFixedSize + addressBytes + length;
+    size_t position = head.load(std::memory_order_relaxed);
+    // @note never wait for the writer: a datagram that does not fit is counted and skipped
+    if (length > 0xFFFF || need > ringMask + 1 - (position - tail.load(std::memory_order_acquire))) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint8_t fixed[kRecordFixedSize];
+    uint64_t timeNs = enet_time_get_ns() - startNs;
+    uint16_t recordLength = static_cast<uint16_t>(length);
+    memcpy(&fixed[0], &timeNs, sizeof(timeNs));
+    memcpy(&fixed[8], &recordLength, sizeof(recordLength));
+    fixed[10] = direction;
+    fixed[11] = type;
+    memcpy(&fixed[12], &address.port, sizeof(address.port));
+
+    auto put = [&](const void* source, size_t bytes) {
+        size_t offset = position & ringMask;
+        size_t first = bytes < ringMask + 1 - offset ? bytes : ringMask + 1 - offset;
+        memcpy(&ring[offset], source, first);
+        memcpy(&ring[0], static_cast<const uint8_t*>(source) + first, bytes - first);
+        position += bytes;
+    };
+    put(fixed, sizeof(fixed));
+    put(&address.host, addressBytes);
+    for (size_t i = 0; i < bufferCount; i++) {
+        put(buffers[i].data, buffers[i].dataLength);
+    }
+
+    head.store(position, std::memory_order_release);
+    records.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TrafficCapture::WriterMain() {
+    while (running.load(std::memory_order_acquire)) {
+        if (!Drain()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    // @note the servicing thread has stopped appending by the time running is cleared
+    Drain();
+}
+
+bool TrafficCapture::Drain() {
+    size_t start = tail.load(std::memory_order_relaxed);
+    size_t end = head.load(std::memory_order_acquire);
+    size_t bytes = end - start;
+    if (bytes == 0) {
+        return false;
+    }
+
+    if (!failed && fileLength + bytes > file.Size()) {
+        size_t size = file.Size() * 2;
+        while (size < fileLength + bytes) {
+            size *= 2;
+        }
+        failed = !file.Resize(size);
+    }
+
+    if (failed) {
+        // @note the file could not grow: keep the ring moving so the host is unaffected, and count what is lost
+        for (size_t position = start; position < end;) {
+            uint8_t lengthBytes[2] = { ring[(position + 8) & ringMask], ring[(position + 9) & ringMask] };
+            uint16_t length;
+            memcpy(&length, lengthBytes, sizeof(length));
+            position += kRecordFixedSize + AddressBytes(ring[(position + 11) & ringMask]) + length;
+            records.fetch_sub(1, std::memory_order_relaxed);
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else {
+        size_t offset = start & ringMask;
+        size_t first = bytes < ringMask + 1 - offset ? bytes : ringMask + 1 - offset;
+        memcpy(file.Data() + fileLength, &ring[offset], first);
+        memcpy(file.Data() + fileLength + first, &ring[0], bytes - first);
+        fileLength += bytes;
+        written.store(fileLength, std::memory_order_relaxed);
+    }
+
+    tail.store(end, std::memory_order_release);
+    return true;
+}
+
+bool TrafficReplay::Open(const std::string& path, double replaySpeed) {
+    if (!file.OpenRead(path) || file.Size() < kCaptureHeaderSize) {
+        return false;
+    }
+
+    CaptureHeader header;
+    memcpy(&header, file.Data(), sizeof(header));
+    if (memcmp(header.magic, kCaptureMagic, sizeof(header.magic)) != 0 || header.version != kCaptureVersion ||
+        header.byteOrder != kCaptureByteOrder) {
+        return false;
+    }
+
+    // @note a capture cut short by a crash ends at its last complete record
+    end = file.Size();
+    size_t offset = kCaptureHeaderSize;
+    while (offset + kRecordFixedSize <= end) {
+        uint16_t length;
+        memcpy(&length, file.Data() + offset + 8, sizeof(length));
+        size_t size = kRecordFixedSize + AddressBytes(file.Data()[offset + 11]) + length;
+        if (offset + size > end) {
+            break;
+        }
+        if (file.Data()[offset + 10] == kTrafficReceive) {
+            stats.total++;
+        }
+        offset += size;
+    }
+    end = offset;
+
+    cursor = kCaptureHeaderSize;
+    speed = replaySpeed;
+    startNs = enet_time_get_ns();
+    captureNs = header.clockNs;
+    captureHostTime = header.hostTime;
+    stats.partial = (header.flags & kCaptureJoinedSession) != 0;
+    return true;
+}
+
+bool TrafficReplay::Peek(size_t offset, Record& record, size_t& recordOffset) const {
+    const uint8_t* data = file.Data();
+    while (offset < end) {
+        uint16_t length;
+        memcpy(&length, data + offset + 8, sizeof(length));
+        uint8_t type = data[offset + 11];
+        size_t addressBytes = AddressBytes(type);
+        record.size = kRecordFixedSize + addressBytes + length;
+
+        if (data[offset + 10] == kTrafficReceive) {
+            memcpy(&record.timeNs, data + offset, sizeof(record.timeNs));
+            memset(&record.address, 0, sizeof(record.address));
+            record.address.type = static_cast<ENetAddressType>(type);
+            memcpy(&record.address.port, data + offset + 12, sizeof(record.address.port));
+            memcpy(&record.address.host, data + offset + kRecordFixedSize, addressBytes);
+            record.data = data + offset + kRecordFixedSize + addressBytes;
+            record.length = length;
+            recordOffset = offset;
+            return true;
+        }
+        offset += record.size;
+    }
+    return false;
+}
+
+uint64_t TrafficReplay::DueNs(uint64_t recordNs) const {
+    return speed > 0.0 ? startNs + static_cast<uint64_t>(static_cast<double>(recordNs) / speed) : 0;
+}
+
+void TrafficReplay::Release(ENetHost* host) {
+    uint64_t now = enet_time_get_ns();
+    Record record;
+    size_t offset;
+    for (uint32_t burst = 0; burst < kReplayBurst && Peek(cursor, record, offset); burst++) {
+        if (DueNs(record.timeNs) > now) {
+            cursor = offset;
+            return;
+        }
+        deliveredNs = record.timeNs;
+        enet_host_inject(host, &record.address, record.data, record.length, nullptr);
+        // @note answer each datagram before the next, as the captured host did; later datagrams
+        // @note acknowledge what it sent in between
+        enet_host_flush(host);
+        stats.delivered++;
+        cursor = offset + record.size;
+    }
+}
+
+bool TrafficReplay::NextTimeout(enet_uint32& timeout) const {
+    Record record;
+    size_t offset;
+    if (!Peek(cursor, record, offset)) {
+        return false;
+    }
+    uint64_t now = enet_time_get_ns();
+    uint64_t due = DueNs(record.timeNs);
+    enet_uint32 wait = due > now ? static_cast<enet_uint32>((due - now + 999999) / 1000000) : 0;
+    if (wait < timeout) {
+        timeout = wait;
+    }
+    return true;
+}
+
+TrafficReplayStats TrafficReplay::Stats() const {
+    return stats;
+}
+
+int ENET_CALLBACK TrafficReplay::Intercept(ENetHost* host, ENetEvent* event) {
+    // @note live datagrams would interleave with the capture, so the socket is ignored while replaying
+    return 1;
+}
+
+enet_uint32 ENET_CALLBACK TrafficReplay::Clock(ENetHost* host) {
+    TrafficReplay* self = static_cast<TrafficReplay*>(host->data);
+    // @note as fast as possible means time advances from one datagram to the next
+    uint64_t elapsedNs = self->speed > 0.0
+        ? static_cast<uint64_t>(static_cast<double>(enet_time_get_ns() - self->startNs) * self->speed)
+        : self->deliveredNs;
+    // @note millisecond boundaries fall where they did for the captured host, so the host reads the
+    // @note times it read, whatever offset its enet_time_set() applied
+    enet_uint64 elapsedMs = (self->captureNs + elapsedNs) / 1000000 - self->captureNs / 1000000;
+    return self->captureHostTime + static_cast<enet_uint32>(elapsedMs);
+}
+
+int ENET_CALLBACK TrafficReplay::InterceptSend(ENetHost* host, const ENetAddress* address,
+                                               const ENetBuffer* buffers, size_t bufferCount) {
+    // @note replies would go to the addresses in the capture; they count as sent but never leave
+    return 1;
+}
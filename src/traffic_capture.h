@@ -0,0 +1,148 @@
+#ifndef SKY_ENET_TRAFFIC_CAPTURE_H
+#define SKY_ENET_TRAFFIC_CAPTURE_H
+
+#include <enet/enet.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+// @note capture file: a 40 byte header, then records back to back, all in host byte order
+// @note record: u64 nanoseconds since capture start, u16 length, u8 direction, u8 address type,
+// @note u16 port, 4 or 16 address bytes by type, then the datagram itself
+enum TrafficDirection : uint8_t {
+    kTrafficReceive = 0,
+    kTrafficSend = 1
+};
+
+struct TrafficCaptureStats {
+    uint64_t records = 0;   // datagrams written to the file
+    uint64_t bytes = 0;     // file bytes, header included
+    uint64_t dropped = 0;   // datagrams lost because the writer fell a whole ring behind
+};
+
+struct TrafficReplayStats {
+    uint64_t delivered = 0; // received datagrams injected so far
+    uint64_t total = 0;     // received datagrams in the capture
+    bool partial = false;   // the capture joined a running session; datagrams of the peers already
+                            // connected are dropped by the replaying host
+};
+
+// @note file view that can grow; read-only for replay, read-write for capture
+class MappedFile {
+public:
+    ~MappedFile();
+
+    bool OpenRead(const std::string& path);
+    bool Create(const std::string& path);
+    // @note remaps the file at a new length; existing bytes are kept
+    bool Resize(size_t size);
+    // @note unmaps, trims the file to length and closes it
+    void Close(size_t length);
+
+    uint8_t* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    bool Map(bool writable);
+    void Unmap();
+
+    uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int file = -1;
+#endif
+};
+
+// @note records a host's datagrams as its intercept and interceptSend, with itself in host->data;
+// @note the servicing thread appends to a lock-free ring and never waits, a writer thread drains
+// @note the ring into the mapped file
+class TrafficCapture {
+public:
+    ~TrafficCapture();
+
+    // @note ringSize is rounded up to a power of two; peersConnected marks a capture that joins a
+    // @note running session, which replays only the connections made after it started
+    bool Open(const std::string& path, size_t ringSize, bool peersConnected);
+    // @note drains whatever the ring still holds and finishes the file
+    void Close();
+
+    TrafficCaptureStats Stats() const;
+
+    static int ENET_CALLBACK Intercept(ENetHost* host, ENetEvent* event);
+    static int ENET_CALLBACK InterceptSend(ENetHost* host, const ENetAddress* address,
+                                           const ENetBuffer* buffers, size_t bufferCount);
+
+private:
+    void Append(uint8_t direction, const ENetAddress& address, const ENetBuffer* buffers, size_t bufferCount);
+    void WriterMain();
+    bool Drain();
+
+    MappedFile file;
+    size_t fileLength = 0;
+    bool failed = false;
+    enet_uint64 startNs = 0;
+
+    std::unique_ptr<uint8_t[]> ring;
+    size_t ringMask = 0;
+    // @note head is advanced only by the servicing thread, tail only by the writer
+    std::atomic<size_t> head{0};
+    std::atomic<size_t> tail{0};
+    std::atomic<uint64_t> records{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> running{false};
+    std::thread writer;
+};
+
+// @note feeds the received datagrams of a capture back into a host through enet_host_inject; as
+// @note the host's intercept it also drops live traffic, and it swallows everything the host sends.
+// @note As the host's clock it keeps the host on the captured timeline, scaled by speed, so the
+// @note sent times echoed in captured acknowledgements still make sense
+class TrafficReplay {
+public:
+    // @note speed scales the original timing, 0 delivers as fast as the host can take it
+    bool Open(const std::string& path, double speed);
+
+    // @note injects the datagrams that are due; must not run inside enet_host_service
+    void Release(ENetHost* host);
+    // @note lowers timeout to the next delivery, false once the capture is exhausted
+    bool NextTimeout(enet_uint32& timeout) const;
+
+    TrafficReplayStats Stats() const;
+
+    static int ENET_CALLBACK Intercept(ENetHost* host, ENetEvent* event);
+    static int ENET_CALLBACK InterceptSend(ENetHost* host, const ENetAddress* address,
+                                           const ENetBuffer* buffers, size_t bufferCount);
+    static enet_uint32 ENET_CALLBACK Clock(ENetHost* host);
+
+private:
+    struct Record {
+        uint64_t timeNs;
+        ENetAddress address;
+        const uint8_t* data;
+        size_t length;
+        size_t size;        // bytes the record takes in the file
+    };
+
+    // @note finds the first received datagram at or after offset, false at the end of the capture
+    bool Peek(size_t offset, Record& record, size_t& recordOffset) const;
+    uint64_t DueNs(uint64_t recordNs) const;
+
+    MappedFile file;
+    size_t cursor = 0;
+    size_t end = 0;         // end of the last complete record
+    double speed = 1.0;
+    enet_uint64 startNs = 0;
+    uint64_t captureNs = 0;     // the capturing host's clock at the start of the capture
+    enet_uint32 captureHostTime = 0;
+    uint64_t deliveredNs = 0;   // capture time of the last injected datagram
+    TrafficReplayStats stats;
+};
+
+#endif
@@ -0,0 +1,457 @@
+import { Server, Client, PACKET_FLAG_RELIABLE, PACKET_FLAG_UNSEQUENCED } from '../index.js';
+import { fork } from 'child_process';
+import { fileURLToPath } from 'url';
+import { performance } from 'perf_hooks';
+import os from 'os';
+
+// @note multi-client load generator: the server runs in this process so its cpu and rss are measured alone,
+// @note clients run in forked processes and echo timestamps back for round-trip latency
+// @note configuration via env or defaults
+const SOAK = process.env.SOAK === '1';
+const CLIENTS = parseInt(process.env.CLIENTS || '64', 10);
+const PROCESSES = Math.max(1, Math.min(CLIENTS, parseInt(process.env.PROCESSES || String(Math.min(4, os.cpus().length)), 10)));
+const DURATION_MS = parseInt(process.env.DURATION_MS || (SOAK ? '600000' : '30000'), 10);
+const RATE = parseFloat(process.env.RATE || '20'); // packets per second per client
+const SIZES = process.env.SIZES || '64:60,256:25,1024:15'; // size:weight
+const MIX = process.env.MIX || 'reliable:40,unreliable:50,unsequenced:10'; // mode:weight
+const RAMP_MS = parseInt(process.env.RAMP_MS || '1000', 10); // 0 connects every client at once
+const STORM_EVERY_MS = parseInt(process.env.STORM_EVERY_MS || '0', 10); // drop and reconnect all clients periodically
+const LOSS = parseFloat(process.env.LOSS || '0'); // applied on receive at both ends
+const LATENCY_MS = parseInt(process.env.LATENCY_MS || '0', 10); // rtt grows by about twice this
+const JITTER_MS = parseInt(process.env.JITTER_MS || '0', 10);
+const REPORT_MS = parseInt(process.env.REPORT_MS || '1000', 10);
+const PORT = parseInt(process.env.PORT || '17191', 10);
+const SOAK_WARMUP_MS = parseInt(process.env.SOAK_WARMUP_MS || String(Math.min(60000, DURATION_MS / 10)), 10);
+const SOAK_MAX_GROWTH_MB = parseFloat(process.env.SOAK_MAX_GROWTH_MB || '16');
+
+const MODES = ['reliable', 'unreliable', 'unsequenced'];
+const MODE_FLAGS = [PACKET_FLAG_RELIABLE, 0, PACKET_FLAG_UNSEQUENCED];
+// @note mode byte, then the sender's performance.now() as a double
+const HEADER_SIZE = 12;
+const conditions = LOSS > 0 || LATENCY_MS > 0 || JITTER_MS > 0
+  ? { loss: LOSS, latency: LATENCY_MS, jitter: JITTER_MS }
+  : null;
+
+// @note helpers
+const toMB = bytes => (bytes / (1024 * 1024));
+
+function parseWeights(spec, parseKey) {
+  const entries = spec.split(',').map(item => {
+    const [key, weight] = item.split(':');
+    return { key: parseKey(key.trim()), weight: parseFloat(weight || '1') };
+  });
+  const total = entries.reduce((sum, entry) => sum + entry.weight, 0);
+  let acc = 0;
+  for (const entry of entries) {
+    acc += entry.weight / total;
+    entry.cumulative = acc;
+  }
+  return entries;
+}
+
+function pickWeighted(entries) {
+  const r = Math.random();
+  for (const entry of entries) {
+    if (r < entry.cumulative) return entry.key;
+  }
+  return entries[entries.length - 1].key;
+}
+
+// @note log-linear histogram of microseconds: exact below 32, then 16 sub-buckets per power of two
+const HISTOGRAM_BUCKETS = 448;
+
+function bucketOf(us) {
+  const v = Math.min(0x7fffffff, Math.max(0, Math.floor(us)));
+  if (v < 32) return v;
+  const e = 31 - Math.clz32(v);
+  return (e - 4) * 16 + (v >>> (e - 4));
+}
+
+function bucketValue(index) {
+  if (index < 32) return index;
+  const e = Math.floor(index / 16) + 3;
+  return (index - (e - 4) * 16) * 2 ** (e - 4);
+}
+
+function percentile(counts, p) {
+  let total = 0;
+  for (let i = 0; i < counts.length; i += 1) total += counts[i];
+  if (total === 0) return NaN;
+  const rank = Math.ceil(total * p);
+  let seen = 0;
+  for (let i = 0; i < counts.length; i += 1) {
+    seen += counts[i];
+    if (seen >= rank) return bucketValue(i);
+  }
+  return bucketValue(counts.length - 1);
+}
+
+const fmtMs = us => (Number.isNaN(us) ? '-' : `${(us / 1000).toFixed(2)}ms`);
+
+// @note pretty print a boxed summary
+function printBoxedSummary(title, pairs) {
+  const labels = pairs.map(([k]) => String(k));
+  const values = pairs.map(([, v]) => String(v));
+  const labelWidth = Math.max(...labels.map(s => s.length));
+  const valueWidth = Math.max(...values.map(s => s.length));
+  const innerWidth = Math.max(title.length, labelWidth + 3 + valueWidth);
+  const top = '┌' + '─'.repeat(innerWidth + 2) + '┐';
+  const sep = '├' + '─'.repeat(innerWidth + 2) + '┤';
+  const bot = '└' + '─'.repeat(innerWidth + 2) + '┘';
+  console.log(top);
+  console.log('│ ' + title.padEnd(innerWidth) + ' │');
+  console.log(sep);
+  for (let i = 0; i < pairs.length; i += 1) {
+    const [k, v] = pairs[i];
+    console.log('│ ' + String(k).padEnd(labelWidth) + ' : ' + String(v).padEnd(valueWidth) + ' │');
+  }
+  console.log(bot);
+}
+
+// @note least squares slope and intercept of y over x
+function linearFit(xs, ys) {
+  const n = xs.length;
+  const mx = xs.reduce((a, b) => a + b, 0) / n;
+  const my = ys.reduce((a, b) => a + b, 0) / n;
+  let num = 0;
+  let den = 0;
+  for (let i = 0; i < n; i += 1) {
+    num += (xs[i] - mx) * (ys[i] - my);
+    den += (xs[i] - mx) ** 2;
+  }
+  const slope = den === 0 ? 0 : num / den;
+  return { slope, intercept: my - slope * mx };
+}
+
+// ---------------------------------------------------------------------------
+// @note client process: a share of the clients, reporting a window of stats every REPORT_MS
+
+async function runClients(workerIndex, count) {
+  const sizes = parseWeights(SIZES, key => Math.max(HEADER_SIZE, parseInt(key, 10)));
+  const mix = parseWeights(MIX, key => {
+    const mode = MODES.indexOf(key);
+    if (mode < 0) throw new Error(`Unknown mode in MIX: ${key}`);
+    return mode;
+  });
+  const scratch = Buffer.alloc(Math.max(...sizes.map(entry => entry.key)), 0x5a);
+
+  const window = {
+    sent: 0,
+    received: 0,
+    bytesSent: 0,
+    bytesReceived: 0,
+    sendErrors: 0,
+    connects: 0,
+    connectFailures: 0,
+    rtt: new Float64Array(HISTOGRAM_BUCKETS),
+    connect: new Float64Array(HISTOGRAM_BUCKETS),
+  };
+  const clients = [];
+  let running = true;
+
+  const connectClient = async state => {
+    const start = performance.now();
+    state.connecting = true;
+    try {
+      await state.client.connect({ timeoutMs: 5000 });
+      state.connected = true;
+      window.connects += 1;
+      window.connect[bucketOf((performance.now() - start) * 1000)] += 1;
+    } catch {
+      window.connectFailures += 1;
+    }
+    state.connecting = false;
+  };
+
+  for (let i = 0; i < count; i += 1) {
+    const client = new Client({ address: '127.0.0.1', port: PORT, usingNewPacket: true });
+    if (conditions) client.setNetworkConditions(conditions);
+    const state = { client, connected: false, connecting: false };
+    client
+      .on('receive', evt => {
+        window.received += 1;
+        window.bytesReceived += evt.data.length;
+        if (evt.data.length >= HEADER_SIZE) {
+          const sentAt = evt.data.readDoubleLE(4);
+          window.rtt[bucketOf((performance.now() - sentAt) * 1000)] += 1;
+        }
+      })
+      .on('disconnect', () => {
+        state.connected = false;
+      })
+      .on('error', () => {});
+    clients.push(state);
+  }
+
+  // @note ramp in over RAMP_MS, or all at once for a connect storm
+  const globalIndex = i => workerIndex + i * PROCESSES;
+  for (let i = 0; i < clients.length; i += 1) {
+    const delay = RAMP_MS > 0 ? (globalIndex(i) / CLIENTS) * RAMP_MS : 0;
+    setTimeout(() => connectClient(clients[i]), delay);
+  }
+
+  // @note send at RATE per connected client using a fractional budget per tick
+  let budget = 0;
+  let cursor = 0;
+  let lastTick = performance.now();
+  const tick = setInterval(() => {
+    const nowMs = performance.now();
+    const live = clients.filter(state => state.connected);
+    budget += (live.length * RATE * (nowMs - lastTick)) / 1000;
+    lastTick = nowMs;
+    while (budget >= 1 && live.length > 0) {
+      budget -= 1;
+      const state = live[cursor++ % live.length];
+      const size = pickWeighted(sizes);
+      const mode = pickWeighted(mix);
+      const payload = scratch.subarray(0, size);
+      payload[0] = mode;
+      payload.writeDoubleLE(performance.now(), 4);
+      const rc = state.client.sendRawPacket(mode === 0 ? 0 : 1, payload, MODE_FLAGS[mode]);
+      if (rc >= 0) {
+        window.sent += 1;
+        window.bytesSent += size;
+      } else {
+        window.sendErrors += 1;
+      }
+    }
+    if (live.length === 0) budget = 0;
+  }, 10);
+
+  // @note connect storm: every client drops at once and reconnects immediately
+  const storm = STORM_EVERY_MS > 0
+    ? setInterval(() => {
+      for (const state of clients) {
+        if (!state.connected || state.connecting) continue;
+        state.connected = false;
+        state.client.disconnectNow();
+        connectClient(state);
+      }
+    }, STORM_EVERY_MS)
+    : null;
+
+  const flushWindow = () => {
+    process.send({
+      type: 'sample',
+      worker: workerIndex,
+      connected: clients.filter(state => state.connected).length,
+      sent: window.sent,
+      received: window.received,
+      bytesSent: window.bytesSent,
+      bytesReceived: window.bytesReceived,
+      sendErrors: window.sendErrors,
+      connects: window.connects,
+      connectFailures: window.connectFailures,
+      rtt: Array.from(window.rtt),
+      connect: Array.from(window.connect),
+    });
+    window.sent = 0;
+    window.received = 0;
+    window.bytesSent = 0;
+    window.bytesReceived = 0;
+    window.sendErrors = 0;
+    window.connects = 0;
+    window.connectFailures = 0;
+    window.rtt.fill(0);
+    window.connect.fill(0);
+  };
+  const report = setInterval(flushWindow, REPORT_MS);
+
+  process.on('message', message => {
+    if (message.type !== 'stop' || !running) return;
+    running = false;
+    clearInterval(tick);
+    if (storm) clearInterval(storm);
+    // @note let in-flight echoes land before the final window
+    setTimeout(() => {
+      clearInterval(report);
+      flushWindow();
+      for (const state of clients) {
+        try { state.client.disconnectNow(); } catch {}
+        try { state.client.stop(); } catch {}
+        try { state.client.destroy(); } catch {}
+      }
+      process.send({ type: 'done', worker: workerIndex });
+      setTimeout(() => process.exit(0), 100);
+    }, 500);
+  });
+}
+
+// ---------------------------------------------------------------------------
+// @note server process: echo everything back with the sender's reliability and sample cpu and rss
+
+async function runServer() {
+  const server = new Server({
+    address: '127.0.0.1',
+    port: PORT,
+    usingNewPacketForServer: true,
+    maxPeer: Math.min(4095, CLIENTS * 2),
+  });
+  server.on('receive', evt => {
+    const mode = evt.data.length > 0 ? evt.data[0] : 0;
+    server.sendRawPacket(evt.peer, evt.channelID, evt.data, MODE_FLAGS[mode] ?? 0);
+  }).on('error', err => {
+    console.error('[server] error', err);
+  });
+  await server.createServer();
+  if (conditions) server.setNetworkConditions(conditions);
+  server.listen();
+
+  console.log(
+    `[harness] clients=${CLIENTS} processes=${PROCESSES} duration=${DURATION_MS}ms rate=${RATE}pps/client ` +
+    `sizes=${SIZES} mix=${MIX} ramp=${RAMP_MS}ms storm=${STORM_EVERY_MS}ms ` +
+    `loss=${LOSS} latency=${LATENCY_MS}ms jitter=${JITTER_MS}ms${SOAK ? ' soak' : ''}`,
+  );
+
+  const totals = {
+    sent: 0,
+    received: 0,
+    bytesSent: 0,
+    bytesReceived: 0,
+    sendErrors: 0,
+    connects: 0,
+    connectFailures: 0,
+    rtt: new Float64Array(HISTOGRAM_BUCKETS),
+    connect: new Float64Array(HISTOGRAM_BUCKETS),
+  };
+  const connectedByWorker = new Array(PROCESSES).fill(0);
+  let windowStats = null;
+  const resetWindow = () => {
+    windowStats = { sent: 0, received: 0, rtt: new Float64Array(HISTOGRAM_BUCKETS) };
+  };
+  resetWindow();
+
+  const workers = [];
+  let done = 0;
+  const self = fileURLToPath(import.meta.url);
+  for (let w = 0; w < PROCESSES; w += 1) {
+    const count = Math.floor(CLIENTS / PROCESSES) + (w < CLIENTS % PROCESSES ? 1 : 0);
+    const worker = fork(self, ['--clients', String(w), String(count)], { stdio: ['ignore', 'ignore', 'inherit', 'ipc'] });
+    worker.on('message', message => {
+      if (message.type === 'sample') {
+        connectedByWorker[message.worker] = message.connected;
+        for (const key of ['sent', 'received', 'bytesSent', 'bytesReceived', 'sendErrors', 'connects', 'connectFailures']) {
+          totals[key] += message[key];
+        }
+        windowStats.sent += message.sent;
+        windowStats.received += message.received;
+        for (let i = 0; i < HISTOGRAM_BUCKETS; i += 1) {
+          totals.rtt[i] += message.rtt[i];
+          totals.connect[i] += message.connect[i];
+          windowStats.rtt[i] += message.rtt[i];
+        }
+      } else if (message.type === 'done') {
+        done += 1;
+      }
+    });
+    workers.push(worker);
+  }
+
+  // @note time series: one row per REPORT_MS with the server's own cpu and rss
+  const series = [];
+  const start = performance.now();
+  let lastCpu = process.cpuUsage();
+  let lastAt = start;
+  const sampler = setInterval(() => {
+    const nowMs = performance.now();
+    const cpu = process.cpuUsage(lastCpu);
+    lastCpu = process.cpuUsage();
+    const cpuPct = ((cpu.user + cpu.system) / 1000 / (nowMs - lastAt)) * 100;
+    const seconds = (nowMs - lastAt) / 1000;
+    lastAt = nowMs;
+    const mem = process.memoryUsage();
+    const native = server.getMemoryStats();
+    const connected = connectedByWorker.reduce((a, b) => a + b, 0);
+    const row = {
+      t: (nowMs - start) / 1000,
+      connected,
+      cpuPct,
+      rssMB: toMB(mem.rss),
+      heapMB: toMB(mem.heapUsed),
+      nativeMB: native ? toMB(native.inUse) : 0,
+    };
+    series.push(row);
+    console.log(
+      `t=${row.t.toFixed(1).padStart(7)}s clients=${String(connected).padStart(5)} ` +
+      `out=${(windowStats.sent / seconds).toFixed(0).padStart(7)}pps in=${(windowStats.received / seconds).toFixed(0).padStart(7)}pps ` +
+      `rtt p50=${fmtMs(percentile(windowStats.rtt, 0.5))} p99=${fmtMs(percentile(windowStats.rtt, 0.99))} ` +
+      `p999=${fmtMs(percentile(windowStats.rtt, 0.999))} cpu=${cpuPct.toFixed(1)}% ` +
+      `rss=${row.rssMB.toFixed(1)}MB heap=${row.heapMB.toFixed(1)}MB native=${row.nativeMB.toFixed(2)}MB`,
+    );
+    resetWindow();
+  }, REPORT_MS);
+
+  await new Promise(resolve => setTimeout(resolve, DURATION_MS));
+  for (const worker of workers) worker.send({ type: 'stop' });
+  const stopDeadline = Date.now() + 5000;
+  while (done < workers.length && Date.now() < stopDeadline) {
+    await new Promise(resolve => setTimeout(resolve, 50));
+  }
+  clearInterval(sampler);
+
+  const elapsedMs = performance.now() - start;
+  const steady = series.filter(row => row.t * 1000 >= Math.min(SOAK_WARMUP_MS, RAMP_MS + REPORT_MS));
+  const avg = (rows, key) => (rows.length ? rows.reduce((a, row) => a + row[key], 0) / rows.length : 0);
+  const avgCpu = avg(steady, 'cpuPct');
+  const avgClients = avg(steady, 'connected');
+  const pairs = [
+    ['duration', `${elapsedMs.toFixed(0)} ms`],
+    ['clients', `${CLIENTS} in ${PROCESSES} processes`],
+    ['sent', `${totals.sent} pkts`],
+    ['recv (echoed)', `${totals.received} pkts`],
+    ['send errors', `${totals.sendErrors}`],
+    ['bytes out', `${toMB(totals.bytesSent).toFixed(2)} MB`],
+    ['bytes in', `${toMB(totals.bytesReceived).toFixed(2)} MB`],
+    ['connects', `${totals.connects} (failed ${totals.connectFailures})`],
+    ['connect p50/p99', `${fmtMs(percentile(totals.connect, 0.5))} / ${fmtMs(percentile(totals.connect, 0.99))}`],
+    ['rtt p50', fmtMs(percentile(totals.rtt, 0.5))],
+    ['rtt p99', fmtMs(percentile(totals.rtt, 0.99))],
+    ['rtt p999', fmtMs(percentile(totals.rtt, 0.999))],
+    ['server cpu avg', `${avgCpu.toFixed(2)} % of 1 core`],
+    ['server cpu max', `${Math.max(0, ...steady.map(row => row.cpuPct)).toFixed(2)} %`],
+    ['server rss max', `${Math.max(0, ...series.map(row => row.rssMB)).toFixed(2)} MB`],
+    ['clients per core', avgCpu > 0 ? `${((avgClients * 100) / avgCpu).toFixed(0)} at ${RATE} pps` : '-'],
+  ];
+  const conditionStats = server.getNetworkConditions();
+  if (conditionStats) {
+    pairs.push(['server dropped', `${conditionStats.dropped}`]);
+    pairs.push(['server delayed', `${conditionStats.delayed}`]);
+  }
+
+  // @note soak: fit rss, heap and native memory after warmup and flag growth past SOAK_MAX_GROWTH_MB
+  let leaking = false;
+  if (SOAK) {
+    const rows = series.filter(row => row.t * 1000 >= SOAK_WARMUP_MS);
+    if (rows.length >= 3) {
+      const xs = rows.map(row => row.t);
+      const span = xs[xs.length - 1] - xs[0];
+      for (const key of ['rssMB', 'heapMB', 'nativeMB']) {
+        const { slope } = linearFit(xs, rows.map(row => row[key]));
+        const growth = slope * span;
+        const flagged = growth > SOAK_MAX_GROWTH_MB;
+        leaking = leaking || flagged;
+        pairs.push([`soak ${key.replace('MB', '')} growth`, `${growth.toFixed(2)} MB (${(slope * 3600).toFixed(2)} MB/h)${flagged ? ' GROWING' : ''}`]);
+      }
+    } else {
+      pairs.push(['soak', 'not enough samples after warmup']);
+    }
+  }
+
+  printBoxedSummary('gtenet load summary', pairs);
+
+  try { server.stop(); } catch {}
+  try { server.destroy(); } catch {}
+  for (const worker of workers) {
+    if (worker.exitCode === null) worker.kill();
+  }
+  setTimeout(() => process.exit(leaking ? 1 : 0), 200);
+}
+
+if (process.argv[2] === '--clients') {
+  runClients(parseInt(process.argv[3], 10), parseInt(process.argv[4], 10));
+} else {
+  runServer().catch(err => {
+    console.error('[harness] failed', err);
+    process.exit(1);
+  });
+}